@@ -7,20 +7,31 @@
 
 #include <AboutWindow.h>
 #include <Alert.h>
+#include <Autolock.h>
 #include <Catalog.h>
 #include <Directory.h>
 #include <Entry.h>
 #include <File.h>
 #include <FindDirectory.h>
+#include <NodeMonitor.h>
 #include <Path.h>
 
+#include <cstring>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "AppPreferencesWindow.h"
+#include "DataMonitor.h"
+#include "EditorConfig.h"
 #include "EditorWindow.h"
+#include "FindInFiles.h"
 #include "FindWindow.h"
+#include "GoToLineWindow.h"
+#include "IdentifierIndex.h"
 #include "Preferences.h"
+#include "ReplacePreviewWindow.h"
+#include "SearchResultsView.h"
 #include "Styler.h"
 #include "QuitAlert.h"
 
@@ -34,7 +45,9 @@ App::App()
 	BApplication(gAppMime),
 	fLastActiveWindow(NULL),
 	fAppPreferencesWindow(nullptr),
+	fDataMonitor(nullptr),
 	fFindWindow(nullptr),
+	fFindInFiles(nullptr),
 	fPreferences(NULL)
 {
 }
@@ -54,6 +67,11 @@ App::~App()
 		}
 	}
 
+	delete fFindInFiles;
+	delete fDataMonitor;
+	EditorConfig::Stop();
+	IdentifierIndex::Stop();
+
 	fPreferences->Save(fPreferencesFile.Path());
 	delete fPreferences;
 }
@@ -76,7 +94,11 @@ App::Init()
 	fPreferences->fSettingsPath = settingsPath;
 	EditorWindow::SetPreferences(fPreferences);
 
-	Languages::LoadLanguages();
+	// edited styles and languages are applied to open windows right away
+	fDataMonitor = new DataMonitor(BMessenger(this));
+	fDataMonitor->Start();
+	EditorConfig::Start(BMessenger(this));
+	IdentifierIndex::Start(BMessenger(this));
 }
 
 
@@ -143,16 +165,16 @@ App::ReadyToRun()
 void
 App::ArgvReceived(int32 argc, char** argv)
 {
+	BMessage refs(B_REFS_RECEIVED);
 	entry_ref ref;
 	BEntry entry;
 	for(int32 i = 1; i < argc; ++i) {
 		entry.SetTo(argv[i]);
 		entry.GetRef(&ref);
-		EditorWindow* window = new EditorWindow();
-		window->OpenFile(&ref);
-		window->Show();
-		fWindows.AddItem(window);
+		refs.AddRef("refs", &ref);
 	}
+	if(refs.HasRef("refs") == true)
+		RefsReceived(&refs);
 }
 
 
@@ -163,13 +185,32 @@ App::RefsReceived(BMessage* message)
 	if(message->GetInfo("refs", nullptr, &count) != B_OK) {
 		return;
 	}
+	// file which is already open is not opened again, its window shows
+	// another view of it, or just goes to the line if "be:line" is sent
+	// by search results
+	const int32 line = message->GetInt32("be:line", 0);
 	entry_ref ref;
 	for(int32 i = 0; i < count; ++i) {
 		if(message->FindRef("refs", i, &ref) == B_OK) {
-			EditorWindow* window = new EditorWindow();
-			window->OpenFile(&ref);
-			window->Show();
-			fWindows.AddItem(window);
+			EditorWindow* window = _FindWindow(ref);
+			if(window == nullptr) {
+				window = new EditorWindow();
+				window->OpenFile(&ref);
+				window->Show();
+				fWindows.AddItem(window);
+			} else {
+				window->Activate();
+				if(line <= 0) {
+					BMessage split(MAINMENU_VIEW_SPLIT);
+					split.AddBool("show", true);
+					BMessenger((BWindow*) window).SendMessage(&split);
+				}
+			}
+			if(line > 0) {
+				BMessage go(GTLW_GO);
+				go.AddInt32("line", line);
+				BMessenger((BWindow*) window).SendMessage(&go);
+			}
 		}
 	}
 }
@@ -190,19 +231,87 @@ App::MessageReceived(BMessage* message)
 			messenger.SendMessage(message);
 		}
 	} break;
+	case IDENTIFIERINDEX_CHANGED: {
+		for(uint32 i = 0, count = fWindows.CountItems(); i < count; i++) {
+			BMessenger messenger((BWindow*) fWindows.ItemAt(i));
+			messenger.SendMessage(message);
+		}
+	} break;
+	case B_NODE_MONITOR: {
+		if(EditorConfig::Changed(message) == true) {
+			BMessage changed(EDITORCONFIG_CHANGED);
+			for(uint32 i = 0, count = fWindows.CountItems(); i < count; i++) {
+				BMessenger messenger((BWindow*) fWindows.ItemAt(i));
+				messenger.SendMessage(&changed);
+			}
+			break;
+		}
+		std::vector<std::string> names;
+		if(fDataMonitor == nullptr || !fDataMonitor->Changed(message, names))
+			break;
+		for(const auto& name : names) {
+			if(!Styler::Invalidate(name) && !Languages::Invalidate(name))
+				continue;
+			// windows check whether they use it
+			BMessage changed(DATAMONITOR_CHANGED);
+			changed.AddString("name", name.c_str());
+			for(uint32 i = 0, count = fWindows.CountItems(); i < count; i++) {
+				BMessenger messenger((BWindow*) fWindows.ItemAt(i));
+				messenger.SendMessage(&changed);
+			}
+		}
+	} break;
 	case APP_PREFERENCES_QUITTING: {
 		fAppPreferencesWindow = nullptr;
 	} break;
 	case FINDWINDOW_FIND:
 	case FINDWINDOW_REPLACE:
 	case FINDWINDOW_REPLACEFIND:
-	case FINDWINDOW_REPLACEALL: {
+	case FINDWINDOW_REPLACEALL:
+	case FINDWINDOW_FINDALL: {
 		// TODO: == nullptr should never happen, alert if it somehow does?
 		if(fLastActiveWindow != nullptr) {
 			BMessenger messenger((BWindow*) fLastActiveWindow);
 			messenger.SendMessage(message);
 		}
 	} break;
+	case FINDWINDOW_REPLACEINFILES:
+	case FINDWINDOW_FINDINFILES: {
+		_StartFindInFiles(message);
+	} break;
+	case FINDINFILES_SCANNED: {
+		int32 status = message->GetInt32("status", B_ERROR);
+		if(fFindInFiles->IsStreaming() == true) {
+			BMessage done(SEARCHRESULTS_DONE);
+			done.AddInt32("status", status);
+			fFindInFiles->ResultsTarget().SendMessage(&done);
+			delete fFindInFiles;
+			fFindInFiles = nullptr;
+		} else if(status == B_OK && fFindInFiles->Changes().empty() == false) {
+			ReplacePreviewWindow* preview = new ReplacePreviewWindow(fFindInFiles);
+			preview->Show();
+		} else {
+			if(status == B_OK) {
+				BAlert* alert = new BAlert(B_TRANSLATE("Replace in files"),
+					B_TRANSLATE("No results found."),
+					B_TRANSLATE("OK"), nullptr, nullptr, B_WIDTH_AS_USUAL, B_INFO_ALERT);
+				alert->SetShortcut(0, B_ESCAPE);
+				alert->Go(nullptr);
+			}
+			delete fFindInFiles;
+			fFindInFiles = nullptr;
+		}
+	} break;
+	case REPLACEPREVIEW_APPLY: {
+		_ApplyReplaceInFiles();
+	} break;
+	case REPLACEPREVIEW_CANCEL: {
+		delete fFindInFiles;
+		fFindInFiles = nullptr;
+	} break;
+	case FINDINFILES_REPLACED: {
+		_FinishReplaceInFiles(message);
+	} break;
 	case FINDWINDOW_QUITTING: {
 		fFindWindow = nullptr;
 	} break;
@@ -240,3 +349,158 @@ App::MessageReceived(BMessage* message)
 	break;
 	}
 }
+
+
+EditorWindow*
+App::_FindWindow(const entry_ref& ref)
+{
+	BPath path(&ref);
+	for(int32 i = 0; i < fWindows.CountItems(); i++) {
+		EditorWindow* window = fWindows.ItemAt(i);
+		// the path is replaced by the window thread on save and when the
+		// file is moved
+		BAutolock lock(window);
+		if(lock.IsLocked() == true && window->IsFileOpened(path.Path()) == true)
+			return window;
+	}
+	return nullptr;
+}
+
+
+void
+App::_StartFindInFiles(BMessage* message)
+{
+	const bool replace = message->what == FINDWINDOW_REPLACEINFILES;
+	const char* title = replace ? B_TRANSLATE("Replace in files")
+		: B_TRANSLATE("Find in files");
+	if(fFindInFiles != nullptr) {
+		BAlert* alert = new BAlert(title,
+			B_TRANSLATE("Another search in files is in progress."),
+			B_TRANSLATE("OK"), nullptr, nullptr, B_WIDTH_AS_USUAL, B_WARNING_ALERT);
+		alert->SetShortcut(0, B_ESCAPE);
+		alert->Go(nullptr);
+		return;
+	}
+
+	BPath folder;
+	const char* folderText = message->GetString("folder", "");
+	if(folderText[0] != '\0') {
+		folder.SetTo(folderText, nullptr, true);
+	} else if(fLastActiveWindow != nullptr
+			&& fLastActiveWindow->IsFileOpened() == true) {
+		// default to directory of the file being edited
+		BPath file(fLastActiveWindow->OpenedFilePath());
+		file.GetParent(&folder);
+	}
+	BEntry folderEntry(folder.Path());
+	if(folder.InitCheck() != B_OK || folderEntry.IsDirectory() == false) {
+		BAlert* alert = new BAlert(title,
+			B_TRANSLATE("Specify an existing folder to search in."),
+			B_TRANSLATE("OK"), nullptr, nullptr, B_WIDTH_AS_USUAL, B_WARNING_ALERT);
+		alert->SetShortcut(0, B_ESCAPE);
+		alert->Go(nullptr);
+		return;
+	}
+
+	fFindInFiles = new FindInFiles(BMessenger(this), folder.Path(),
+		message->GetString("filter", ""), message->GetString("findText", ""),
+		message->GetString("replaceText", ""), message->GetBool("matchCase"),
+		message->GetBool("matchWord"), message->GetBool("regex"));
+	if(fFindInFiles->IsValid() == false) {
+		BAlert* alert = new BAlert(title,
+			B_TRANSLATE("Regular expression is not valid."),
+			B_TRANSLATE("OK"), nullptr, nullptr, B_WIDTH_AS_USUAL, B_STOP_ALERT);
+		alert->SetShortcut(0, B_ESCAPE);
+		alert->Go(nullptr);
+		delete fFindInFiles;
+		fFindInFiles = nullptr;
+		return;
+	}
+	if(replace == false) {
+		// results of a find are always listed in a window, never previewed
+		// as replacements
+		if(fLastActiveWindow == nullptr) {
+			fLastActiveWindow = new EditorWindow();
+			fLastActiveWindow->Show();
+			fWindows.AddItem(fLastActiveWindow);
+		}
+		BMessenger results((BWindow*) fLastActiveWindow);
+		results.SendMessage(SEARCHRESULTS_CLEAR);
+		fFindInFiles->StreamResults(results);
+	}
+	if(fFindInFiles->Scan() != B_OK) {
+		delete fFindInFiles;
+		fFindInFiles = nullptr;
+	}
+}
+
+
+void
+App::_ApplyReplaceInFiles()
+{
+	if(fFindInFiles == nullptr)
+		return;
+
+	std::set<std::string> changedPaths;
+	for(const auto& change : fFindInFiles->Changes())
+		changedPaths.insert(change.path);
+
+	// Documents which are already open are changed through their windows,
+	// so that replacement becomes a single undoable action and unsaved
+	// edits are preserved. Only the rest is rewritten on disk, and open
+	// documents are changed when that succeeded.
+	std::set<std::string> openPaths;
+	EditorWindow* window;
+	for(int32 i = 0; (window = fWindows.ItemAt(i)) != nullptr; i++) {
+		BAutolock lock(window);
+		if(lock.IsLocked() == false || window->IsFileOpened() == false)
+			continue;
+		std::string path(window->OpenedFilePath());
+		if(changedPaths.count(path) != 0)
+			openPaths.insert(path);
+	}
+
+	if(fFindInFiles->Replace(openPaths) != B_OK) {
+		delete fFindInFiles;
+		fFindInFiles = nullptr;
+	}
+}
+
+
+void
+App::_FinishReplaceInFiles(BMessage* message)
+{
+	int32 status = message->GetInt32("status", B_ERROR);
+	const std::set<std::string>& openPaths = fFindInFiles->SkippedPaths();
+	if(status == B_OK && openPaths.empty() == false) {
+		EditorWindow* window;
+		for(int32 i = 0; (window = fWindows.ItemAt(i)) != nullptr; i++) {
+			BAutolock lock(window);
+			if(lock.IsLocked() == false || window->IsFileOpened() == false
+					|| openPaths.count(window->OpenedFilePath()) == 0)
+				continue;
+			BMessage replaceAll(FINDWINDOW_REPLACEALL);
+			replaceAll.AddBool("inSelection", false);
+			replaceAll.AddBool("matchCase", fFindInFiles->MatchCase());
+			replaceAll.AddBool("matchWord", fFindInFiles->MatchWord());
+			replaceAll.AddBool("regex", fFindInFiles->Regex());
+			replaceAll.AddString("findText", fFindInFiles->FindText());
+			replaceAll.AddString("replaceText", fFindInFiles->ReplaceText());
+			BMessenger messenger((BWindow*) window);
+			messenger.SendMessage(&replaceAll);
+		}
+	} else if(status != B_OK && status != B_CANCELED) {
+		BString text(openPaths.empty() == true
+			? B_TRANSLATE("Could not write %path%. No files were changed on disk.")
+			: B_TRANSLATE("Could not write %path%. No files were changed on disk "
+				"and open documents were left as they were."));
+		text.ReplaceAll("%path%", message->GetString("failedPath", ""));
+		BAlert* alert = new BAlert(B_TRANSLATE("Replace in files"),
+			text.String(), B_TRANSLATE("OK"), nullptr, nullptr,
+			B_WIDTH_AS_USUAL, B_STOP_ALERT);
+		alert->SetShortcut(0, B_ESCAPE);
+		alert->Go(nullptr);
+	}
+	delete fFindInFiles;
+	fFindInFiles = nullptr;
+}
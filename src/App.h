@@ -13,10 +13,13 @@
 
 
 class AppPreferencesWindow;
+class DataMonitor;
 class EditorWindow;
+class FindInFiles;
 class FindWindow;
 class Preferences;
 class Styler;
+struct entry_ref;
 
 
 class App : public BApplication {
@@ -34,10 +37,17 @@ public:
 	void						MessageReceived(BMessage* message);
 
 private:
+	EditorWindow*				_FindWindow(const entry_ref& ref);
+	void						_StartFindInFiles(BMessage* message);
+	void						_ApplyReplaceInFiles();
+	void						_FinishReplaceInFiles(BMessage* message);
+
 	BObjectList<EditorWindow>	fWindows;
 	EditorWindow*				fLastActiveWindow;
 	AppPreferencesWindow*		fAppPreferencesWindow;
+	DataMonitor*				fDataMonitor;
 	FindWindow*					fFindWindow;
+	FindInFiles*				fFindInFiles;
 	Preferences*				fPreferences;
 	Styler*						fStyler;
 
@@ -13,12 +13,16 @@
 #include <Catalog.h>
 #include <CheckBox.h>
 #include <LayoutBuilder.h>
+#include <MenuField.h>
+#include <MenuItem.h>
 #include <Message.h>
+#include <PopUpMenu.h>
 #include <RadioButton.h>
 #include <StringView.h>
 
 #include <Scintilla.h>
 
+#include "DataLoader.h"
 #include "Preferences.h"
 
 
@@ -128,6 +132,10 @@ AppPreferencesWindow::MessageReceived(BMessage* message)
 				(fBracesHighlightingCB->Value() == B_CONTROL_ON ? true : false);
 			_PreferencesModified();
 		} break;
+		case Actions::STYLE: {
+			fTempPreferences->fStyle = message->GetString("style", "default");
+			_PreferencesModified();
+		} break;
 		case Actions::APPLY: {
 			*fCurrentPreferences = *fTempPreferences;
 			fApplyButton->SetEnabled(false);
@@ -204,6 +212,14 @@ AppPreferencesWindow::_InitInterface()
 
 	fBracesHighlightingCB = new BCheckBox("bracesHighlighting", B_TRANSLATE("Highlight braces"), new BMessage((uint32) Actions::BRACES_HIGHLIGHTING));
 
+	BPopUpMenu* styleMenu = new BPopUpMenu("style");
+	for(const auto& style : DataLoader::StyleNames()) {
+		BMessage* message = new BMessage((uint32) Actions::STYLE);
+		message->AddString("style", style.c_str());
+		styleMenu->AddItem(new BMenuItem(style.c_str(), message));
+	}
+	fStyleMenu = new BMenuField("style", B_TRANSLATE("Style:"), styleMenu);
+
 	fApplyButton = new BButton(B_TRANSLATE("Apply"), new BMessage((uint32) Actions::APPLY));
 	fRevertButton = new BButton(B_TRANSLATE("Revert"), new BMessage((uint32) Actions::REVERT));
 
@@ -223,6 +239,7 @@ AppPreferencesWindow::_InitInterface()
 		.Add(fLineLimitBox)
 		.Add(fIndentGuidesBox)
 		.Add(fBracesHighlightingCB)
+		.Add(fStyleMenu)
 		.AddGlue()
 		.SetInsets(10, 15, 15, 10);
 
@@ -298,6 +315,11 @@ AppPreferencesWindow::_SyncPreferences(Preferences* preferences)
 	} else {
 		fBracesHighlightingCB->SetValue(B_CONTROL_OFF);
 	}
+
+	BMenuItem* styleItem = fStyleMenu->Menu()->FindItem(preferences->fStyle);
+	if(styleItem != nullptr) {
+		styleItem->SetMarked(true);
+	}
 }
 
 
@@ -13,6 +13,7 @@
 class BBox;
 class BButton;
 class BCheckBox;
+class BMenuField;
 class BMessage;
 class BRadioButton;
 class BStringView;
@@ -54,6 +55,8 @@ private:
 
 		BRACES_HIGHLIGHTING		= 'bhlt',
 
+		STYLE					= 'styl',
+
 		APPLY					= 'appl',
 		REVERT					= 'rvrt'
 	};
@@ -96,6 +99,8 @@ private:
 
 	BCheckBox*		fBracesHighlightingCB;
 
+	BMenuField*		fStyleMenu;
+
 	BButton*		fApplyButton;
 	BButton*		fRevertButton;
 };
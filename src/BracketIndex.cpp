@@ -0,0 +1,143 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "BracketIndex.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Editor.h"
+
+
+namespace {
+
+const Sci_Position kScanChunk = 64 * 1024;
+
+
+// Kind of bracket c, value set to 1 for opening and -1 for closing ones.
+int
+BracketKind(char c, int32& value)
+{
+	switch(c) {
+		case '(': value = 1; return 0;
+		case ')': value = -1; return 0;
+		case '[': value = 1; return 1;
+		case ']': value = -1; return 1;
+		case '{': value = 1; return 2;
+		case '}': value = -1; return 2;
+	}
+	return -1;
+}
+
+}
+
+
+BracketIndex::BracketIndex(Editor* editor)
+	:
+	fEditor(editor),
+	fStyle(-1)
+{
+}
+
+
+void
+BracketIndex::SetStyle(int style)
+{
+	fStyle = style;
+	_Rescan(0, fEditor->SendMessage(SCI_GETLENGTH, 0, 0));
+}
+
+
+void
+BracketIndex::Modified(const SCNotification* notification)
+{
+	const int type = notification->modificationType;
+	const Sci_Position position = notification->position;
+	const Sci_Position length = notification->length;
+	if((type & SC_MOD_INSERTTEXT) != 0) {
+		for(NestingTree& tree : fTrees)
+			tree.Shift(position, length);
+		_Rescan(position, position + length);
+	} else if((type & SC_MOD_DELETETEXT) != 0) {
+		for(NestingTree& tree : fTrees) {
+			tree.Remove(position, position + length);
+			tree.Shift(position + length, -length);
+		}
+	} else if((type & SC_MOD_CHANGESTYLE) != 0) {
+		// inserted text is styled later, that is when brackets in it
+		// are found to be in code or not
+		_Rescan(position, position + length);
+	}
+}
+
+
+bool
+BracketIndex::Contains(Sci_Position pos) const
+{
+	for(const NestingTree& tree : fTrees) {
+		if(tree.Contains(pos))
+			return true;
+	}
+	return false;
+}
+
+
+Sci_Position
+BracketIndex::MatchOf(Sci_Position pos)
+{
+	if(Contains(pos) == false)
+		return -1;
+	int32 value;
+	const int kind = BracketKind(fEditor->SendMessage(SCI_GETCHARAT, pos, 0), value);
+	if(kind < 0)
+		return -1;
+	return value > 0 ? fTrees[kind].Closing(pos) : fTrees[kind].Opening(pos);
+}
+
+
+Sci_Position
+BracketIndex::Enclosing(Sci_Position pos, char open)
+{
+	int32 value;
+	const int only = open != 0 ? BracketKind(open, value) : -1;
+	Sci_Position result = -1;
+	for(int kind = 0; kind < kKinds; kind++) {
+		if(only >= 0 && kind != only)
+			continue;
+		result = std::max(result, fTrees[kind].Opening(pos));
+	}
+	return result;
+}
+
+
+// Replaces brackets between from and to with those in the text there.
+void
+BracketIndex::_Rescan(Sci_Position from, Sci_Position to)
+{
+	NestingTree found[kKinds];
+	std::vector<char> styled;
+	for(Sci_Position start = from; start < to; start += kScanChunk) {
+		const Sci_Position end = std::min(to, start + kScanChunk);
+		// characters interleaved with their styles
+		styled.resize(2 * (end - start) + 2);
+		Sci_TextRange range;
+		range.chrg.cpMin = start;
+		range.chrg.cpMax = end;
+		range.lpstrText = styled.data();
+		fEditor->SendMessage(SCI_GETSTYLEDTEXT, 0, (sptr_t) &range);
+		for(Sci_Position i = 0; i < end - start; i++) {
+			int32 value;
+			const int kind = BracketKind(styled[2 * i], value);
+			if(kind < 0 || (fStyle != -1
+					&& static_cast<unsigned char>(styled[2 * i + 1]) != fStyle))
+				continue;
+			found[kind].Append(start + i, value);
+		}
+	}
+	for(int kind = 0; kind < kKinds; kind++) {
+		fTrees[kind].Remove(from, to);
+		fTrees[kind].Insert(found[kind]);
+	}
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef BRACKETINDEX_H
+#define BRACKETINDEX_H
+
+
+#include <SupportDefs.h>
+
+#include <Scintilla.h>
+
+#include "NestingTree.h"
+
+
+class Editor;
+
+
+/*
+ * Brackets of a document in nesting trees, one for each kind. Edits move
+ * the brackets after them lazily and restyled text is rescanned, so comments
+ * and strings never take part once they are styled.
+ */
+class BracketIndex {
+public:
+								BracketIndex(Editor* editor);
+
+			// Only brackets in style count, or all brackets if it is -1.
+			// Scans the whole document.
+			void				SetStyle(int style);
+			// Call for SCN_MODIFIED, styling changes included.
+			void				Modified(const SCNotification* notification);
+
+			bool				Contains(Sci_Position pos) const;
+			// Position of the bracket paired with the one at pos, -1 if
+			// there is none.
+			Sci_Position		MatchOf(Sci_Position pos);
+			// Position of the innermost bracket opened before pos and not
+			// closed before it, of the kind opened with open or of any kind
+			// if it is 0. -1 if there is none.
+			Sci_Position		Enclosing(Sci_Position pos, char open = 0);
+
+private:
+	enum {
+		kKinds = 3
+			// (), [] and {}
+	};
+
+			void				_Rescan(Sci_Position from, Sci_Position to);
+
+			Editor*				fEditor;
+			int					fStyle;
+			NestingTree			fTrees[kKinds];
+};
+
+
+#endif // BRACKETINDEX_H
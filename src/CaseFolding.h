@@ -0,0 +1,45 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef CASEFOLDING_H
+#define CASEFOLDING_H
+
+
+#include <SupportDefs.h>
+
+#include <cstddef>
+
+
+/*
+ * Unicode simple case folding (statuses C and S of CaseFolding.txt), which
+ * maps every code point to exactly one code point. Full foldings such as
+ * ß -> ss are not applied, so matches never change length in characters.
+ */
+class CaseFolding {
+public:
+	static	uint32	Fold(uint32 codePoint)
+						{ return codePoint < 0x80
+							? _FoldAscii(codePoint) : _FoldTable(codePoint); }
+
+	// Decodes code point at pos and advances pos past it. Malformed bytes
+	// are returned one by one, offset by kInvalid so that they only ever
+	// match themselves.
+	static	uint32	Decode(const char* text, size_t length, size_t& pos);
+
+	// Marks first bytes of UTF-8 encodings of all code points folding to
+	// folded (including folded itself).
+	static	void	CollectLeadBytes(uint32 folded, bool leadBytes[256]);
+
+	static	const uint32	kInvalid = 0x110000;
+
+private:
+	static	uint32	_FoldAscii(uint32 ch)
+						{ return (ch >= 'A' && ch <= 'Z') ? ch + ('a' - 'A') : ch; }
+	static	uint32	_FoldTable(uint32 codePoint);
+	static	void	_AddLeadByte(uint32 codePoint, bool leadBytes[256]);
+};
+
+
+#endif // CASEFOLDING_H
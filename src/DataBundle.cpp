@@ -0,0 +1,470 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "DataBundle.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+const char kMagic[4] = { 'K', 'D', 'A', 'T' };
+
+}
+
+
+DataBundle::DataBundle()
+	:
+	fData(NULL),
+	fSize(0),
+	fModified(0),
+	fHeader(NULL),
+	fEntries(NULL),
+	fPairs(NULL),
+	fStyles(NULL),
+	fProfiles(NULL),
+	fRules(NULL),
+	fStrings(NULL)
+{
+}
+
+
+DataBundle::~DataBundle()
+{
+	if(fData != NULL)
+		munmap(fData, fSize);
+}
+
+
+bool
+DataBundle::Open(const char* path)
+{
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return false;
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(Header)) {
+		close(fd);
+		return false;
+	}
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED)
+		return false;
+
+	// Bundles from another version or a truncated write are ignored, the
+	// loader falls back to YAML then.
+	const Header* header = static_cast<const Header*>(data);
+	const uint64 expected = sizeof(Header)
+		+ (uint64) header->entryCount * sizeof(Entry)
+		+ (uint64) header->pairCount * sizeof(Pair)
+		+ (uint64) header->styleCount * sizeof(Style)
+		+ (uint64) header->profileCount * sizeof(Profile)
+		+ (uint64) header->ruleCount * sizeof(Rule)
+		+ header->stringsSize;
+	if(memcmp(header->magic, kMagic, sizeof(kMagic)) != 0
+		|| header->version != kVersion
+		|| header->size != (uint64) st.st_size
+		|| expected != (uint64) st.st_size
+		|| header->stringsSize == 0) {
+		munmap(data, st.st_size);
+		return false;
+	}
+
+	const char* base = static_cast<const char*>(data);
+	const Entry* entries = reinterpret_cast<const Entry*>(base + sizeof(Header));
+	const Pair* pairs = reinterpret_cast<const Pair*>(entries + header->entryCount);
+	const Style* styles = reinterpret_cast<const Style*>(pairs + header->pairCount);
+	const Profile* profiles = reinterpret_cast<const Profile*>(styles + header->styleCount);
+	const Rule* rules = reinterpret_cast<const Rule*>(profiles + header->profileCount);
+	const char* strings = reinterpret_cast<const char*>(rules + header->ruleCount);
+	if(strings[header->stringsSize - 1] != '\0') {
+		munmap(data, st.st_size);
+		return false;
+	}
+	for(uint32 i = 0; i < header->entryCount; i++) {
+		const Entry& entry = entries[i];
+		if(entry.name >= header->stringsSize
+			|| (uint64) entry.pairs + entry.pairCount > header->pairCount
+			|| (uint64) entry.extraPairs + entry.extraPairCount > header->pairCount
+			|| (uint64) entry.styles + entry.styleCount > header->styleCount
+			|| (uint64) entry.profiles + entry.profileCount > header->profileCount
+			|| (uint64) entry.rules + entry.ruleCount > header->ruleCount) {
+			munmap(data, st.st_size);
+			return false;
+		}
+	}
+	for(uint32 i = 0; i < header->profileCount; i++) {
+		if((uint64) profiles[i].pairs + profiles[i].pairCount > header->pairCount) {
+			munmap(data, st.st_size);
+			return false;
+		}
+	}
+
+	fData = data;
+	fSize = st.st_size;
+	fModified = st.st_mtime;
+	fHeader = header;
+	fEntries = entries;
+	fPairs = pairs;
+	fStyles = styles;
+	fProfiles = profiles;
+	fRules = rules;
+	fStrings = strings;
+	return true;
+}
+
+
+bool
+DataBundle::GetGlobalStyle(const std::string& name, GlobalStyleTable& table) const
+{
+	const Entry* entry = _Find(name);
+	if(entry == NULL)
+		return false;
+	const Style* styles = fStyles + entry->styles;
+	uint32 first = 0;
+	if(entry->value != 0 && entry->styleCount > 0) {
+		table.hasDefault = true;
+		table.defaultStyle = _Record(styles[0]);
+		first = 1;
+	}
+	for(uint32 i = first; i < entry->styleCount; i++) {
+		if(styles[i].name != 0)
+			table.special[_String(styles[i].name)] = _Record(styles[i]);
+		else
+			table.styles[styles[i].id] = _Record(styles[i]);
+	}
+	return true;
+}
+
+
+bool
+DataBundle::GetLanguageStyle(const std::string& name, LanguageStyleTable& table) const
+{
+	const Entry* entry = _Find(name);
+	if(entry == NULL)
+		return false;
+	const Style* styles = fStyles + entry->styles;
+	for(uint32 i = 0; i < entry->styleCount; i++)
+		table.styles[styles[i].id] = _Record(styles[i]);
+	return true;
+}
+
+
+bool
+DataBundle::GetLanguage(const std::string& name, LanguageTable& table) const
+{
+	const Entry* entry = _Find(name);
+	if(entry == NULL)
+		return false;
+	table.lexer = entry->value;
+	table.identifiers = entry->option;
+	table.foldByIndentation = entry->folding;
+	table.bracketStyle = entry->brackets;
+	const Pair* properties = fPairs + entry->pairs;
+	for(uint32 i = 0; i < entry->pairCount; i++) {
+		table.properties[_String(properties[i].key)]
+			= _String(properties[i].value);
+	}
+	const Pair* keywords = fPairs + entry->extraPairs;
+	for(uint32 i = 0; i < entry->extraPairCount; i++)
+		table.keywords[keywords[i].key] = _String(keywords[i].value);
+	const Profile* profiles = fProfiles + entry->profiles;
+	for(uint32 i = 0; i < entry->profileCount; i++) {
+		LanguageTable::Profile profile;
+		profile.name = _String(profiles[i].name);
+		profile.size = profiles[i].size;
+		profile.lineLength = profiles[i].lineLength;
+		profile.lexer = profiles[i].lexer;
+		const Pair* pairs = fPairs + profiles[i].pairs;
+		for(uint32 j = 0; j < profiles[i].pairCount; j++)
+			profile.properties[_String(pairs[j].key)] = _String(pairs[j].value);
+		table.profiles.push_back(profile);
+	}
+	return true;
+}
+
+
+bool
+DataBundle::GetLanguageList(LanguageListTable& table) const
+{
+	const Entry* entry = _Find("languages");
+	if(entry == NULL)
+		return false;
+	const Pair* languages = fPairs + entry->pairs;
+	for(uint32 i = 0; i < entry->pairCount; i++) {
+		table.languages.push_back(std::make_pair(
+			std::string(_String(languages[i].key)),
+			std::string(_String(languages[i].value))));
+	}
+	const Pair* extensions = fPairs + entry->extraPairs;
+	for(uint32 i = 0; i < entry->extraPairCount; i++)
+		table.extensions[_String(extensions[i].key)] = _String(extensions[i].value);
+	const Rule* rules = fRules + entry->rules;
+	for(uint32 i = 0; i < entry->ruleCount; i++) {
+		const std::string pattern = _String(rules[i].pattern);
+		const std::string language = _String(rules[i].language);
+		switch(rules[i].kind) {
+			case FILENAME:
+				table.filenames.push_back(std::make_pair(pattern, language));
+			break;
+			case ALIAS:
+				table.aliases[pattern] = language;
+			break;
+			case FIRST_LINE:
+				table.firstLines.push_back(std::make_pair(pattern, language));
+			break;
+		}
+	}
+	return true;
+}
+
+
+void
+DataBundle::GetNames(const std::string& prefix, std::vector<std::string>& names) const
+{
+	if(fData == NULL)
+		return;
+	for(uint32 i = 0; i < fHeader->entryCount; i++) {
+		const char* name = _String(fEntries[i].name);
+		if(strncmp(name, prefix.c_str(), prefix.size()) == 0
+				&& strchr(name + prefix.size(), '/') == NULL)
+			names.push_back(name + prefix.size());
+	}
+}
+
+
+const DataBundle::Entry*
+DataBundle::_Find(const std::string& name) const
+{
+	if(fData == NULL)
+		return NULL;
+	uint32 low = 0;
+	uint32 high = fHeader->entryCount;
+	while(low < high) {
+		const uint32 middle = low + (high - low) / 2;
+		const int result = strcmp(_String(fEntries[middle].name), name.c_str());
+		if(result == 0)
+			return &fEntries[middle];
+		if(result < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return NULL;
+}
+
+
+const char*
+DataBundle::_String(uint32 offset) const
+{
+	if(offset >= fHeader->stringsSize)
+		return "";
+	return fStrings + offset;
+}
+
+
+StyleRecord
+DataBundle::_Record(const Style& style) const
+{
+	StyleRecord record;
+	record.id = style.id;
+	record.fgColor = style.fgColor;
+	record.bgColor = style.bgColor;
+	record.fontStyle = style.fontStyle;
+	return record;
+}
+
+
+void
+DataBundleWriter::AddGlobalStyle(const std::string& name,
+	const GlobalStyleTable& table)
+{
+	Entry& entry = _AddEntry(name);
+	entry.value = table.hasDefault ? 1 : 0;
+	entry.styles = fStyles.size();
+	if(table.hasDefault == true)
+		_AddStyle(table.defaultStyle);
+	for(const auto& it : table.styles)
+		_AddStyle(it.second);
+	for(const auto& it : table.special)
+		_AddStyle(it.second, _String(it.first));
+	entry.styleCount = fStyles.size() - entry.styles;
+}
+
+
+void
+DataBundleWriter::AddLanguageStyle(const std::string& name,
+	const LanguageStyleTable& table)
+{
+	Entry& entry = _AddEntry(name);
+	entry.styles = fStyles.size();
+	for(const auto& it : table.styles)
+		_AddStyle(it.second);
+	entry.styleCount = fStyles.size() - entry.styles;
+}
+
+
+void
+DataBundleWriter::AddLanguage(const std::string& name,
+	const LanguageTable& table)
+{
+	Entry& entry = _AddEntry(name);
+	entry.value = table.lexer;
+	entry.option = table.identifiers;
+	entry.folding = table.foldByIndentation;
+	entry.brackets = table.bracketStyle;
+	entry.pairs = fPairs.size();
+	for(const auto& it : table.properties)
+		_AddPair(_String(it.first), _String(it.second));
+	entry.pairCount = fPairs.size() - entry.pairs;
+	entry.extraPairs = fPairs.size();
+	for(const auto& it : table.keywords)
+		_AddPair(it.first, _String(it.second));
+	entry.extraPairCount = fPairs.size() - entry.extraPairs;
+	entry.profiles = fProfiles.size();
+	for(const auto& it : table.profiles) {
+		Profile profile = { _String(it.name), it.size, it.lineLength,
+			it.lexer, (uint32) fPairs.size(), 0 };
+		for(const auto& property : it.properties)
+			_AddPair(_String(property.first), _String(property.second));
+		profile.pairCount = fPairs.size() - profile.pairs;
+		fProfiles.push_back(profile);
+	}
+	entry.profileCount = fProfiles.size() - entry.profiles;
+}
+
+
+void
+DataBundleWriter::AddLanguageList(const LanguageListTable& table)
+{
+	Entry& entry = _AddEntry("languages");
+	entry.pairs = fPairs.size();
+	for(const auto& it : table.languages)
+		_AddPair(_String(it.first), _String(it.second));
+	entry.pairCount = fPairs.size() - entry.pairs;
+	entry.extraPairs = fPairs.size();
+	for(const auto& it : table.extensions)
+		_AddPair(_String(it.first), _String(it.second));
+	entry.extraPairCount = fPairs.size() - entry.extraPairs;
+	entry.rules = fRules.size();
+	for(const auto& it : table.filenames)
+		_AddRule(DataBundle::FILENAME, it.first, it.second);
+	for(const auto& it : table.aliases)
+		_AddRule(DataBundle::ALIAS, it.first, it.second);
+	for(const auto& it : table.firstLines)
+		_AddRule(DataBundle::FIRST_LINE, it.first, it.second);
+	entry.ruleCount = fRules.size() - entry.rules;
+}
+
+
+bool
+DataBundleWriter::Write(const char* path)
+{
+	_String("");
+	DataBundle::Header header;
+	memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = DataBundle::kVersion;
+	header.entryCount = fEntries.size();
+	header.pairCount = fPairs.size();
+	header.styleCount = fStyles.size();
+	header.profileCount = fProfiles.size();
+	header.ruleCount = fRules.size();
+	header.stringsSize = fStrings.size();
+	header.size = sizeof(header)
+		+ header.entryCount * sizeof(Entry)
+		+ header.pairCount * sizeof(Pair)
+		+ header.styleCount * sizeof(Style)
+		+ header.profileCount * sizeof(Profile)
+		+ header.ruleCount * sizeof(Rule)
+		+ header.stringsSize;
+
+	// Write next to the target and rename, so a running Koder never maps
+	// a half written bundle.
+	const std::string temporary = std::string(path) + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if(file == NULL)
+		return false;
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+	for(const auto& it : fEntries)
+		written = written && fwrite(&it.second, sizeof(Entry), 1, file) == 1;
+	if(!fPairs.empty())
+		written = written && fwrite(fPairs.data(), sizeof(Pair), fPairs.size(), file) == fPairs.size();
+	if(!fStyles.empty())
+		written = written && fwrite(fStyles.data(), sizeof(Style), fStyles.size(), file) == fStyles.size();
+	if(!fProfiles.empty())
+		written = written && fwrite(fProfiles.data(), sizeof(Profile), fProfiles.size(), file) == fProfiles.size();
+	if(!fRules.empty())
+		written = written && fwrite(fRules.data(), sizeof(Rule), fRules.size(), file) == fRules.size();
+	written = written && fwrite(fStrings.data(), 1, fStrings.size(), file) == fStrings.size();
+	written = (fclose(file) == 0) && written;
+	if(written == false || rename(temporary.c_str(), path) != 0) {
+		unlink(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+DataBundleWriter::Entry&
+DataBundleWriter::_AddEntry(const std::string& name)
+{
+	Entry& entry = fEntries[name];
+	memset(&entry, 0, sizeof(entry));
+	entry.name = _String(name);
+	return entry;
+}
+
+
+uint32
+DataBundleWriter::_String(const std::string& string)
+{
+	if(fStrings.empty()) {
+		// offset 0 is the empty string, also used for "no name"
+		fStrings.push_back('\0');
+		fStringOffsets[""] = 0;
+	}
+	auto found = fStringOffsets.find(string);
+	if(found != fStringOffsets.end())
+		return found->second;
+	const uint32 offset = fStrings.size();
+	fStrings.append(string);
+	fStrings.push_back('\0');
+	fStringOffsets[string] = offset;
+	return offset;
+}
+
+
+void
+DataBundleWriter::_AddPair(uint32 key, uint32 value)
+{
+	Pair pair = { key, value };
+	fPairs.push_back(pair);
+}
+
+
+void
+DataBundleWriter::_AddStyle(const StyleRecord& record, uint32 name)
+{
+	Style style = { record.id, record.fgColor, record.bgColor,
+		record.fontStyle, name };
+	fStyles.push_back(style);
+}
+
+
+void
+DataBundleWriter::_AddRule(uint32 kind, const std::string& pattern,
+	const std::string& language)
+{
+	Rule rule = { kind, _String(pattern), _String(language) };
+	fRules.push_back(rule);
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef DATABUNDLE_H
+#define DATABUNDLE_H
+
+
+#include <SupportDefs.h>
+
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "DataTables.h"
+
+
+/*
+ * data.bundle holds all data files of a directory compiled by koder-datac,
+ * so they can be mapped instead of parsed. Layout, in native byte order:
+ *
+ *	Header
+ *	Entry[entryCount]		sorted by name
+ *	Pair[pairCount]
+ *	Style[styleCount]
+ *	Profile[profileCount]
+ *	Rule[ruleCount]
+ *	char strings[]			NUL-terminated, referenced by offset
+ *
+ * Entries are named after data files without extension:
+ *	"languages"				pairs: language, menu item;
+ *							extra: extension, language;
+ *							rules: detection rules and their kind
+ *	"languages/<lang>"		value: lexer; pairs: property, value;
+ *							extra: keyword set number, keywords;
+ *							option: keyword set for project identifiers;
+ *							folding: fold by indentation, -1 if not set;
+ *							brackets: style of brackets, -1 if not set;
+ *							profiles: with their own properties
+ *	"styles/<s>"			value: has Default; styles: Default first,
+ *							then the rest, special ones carry a name
+ *	"styles/<s>/<lang>"		styles
+ */
+class DataBundle {
+public:
+	static	const uint32	kVersion = 6;
+
+							DataBundle();
+							~DataBundle();
+
+			bool			Open(const char* path);
+			bool			IsOpen() const { return fData != NULL; }
+			time_t			ModificationTime() const { return fModified; }
+
+			bool			GetGlobalStyle(const std::string& name,
+								GlobalStyleTable& table) const;
+			bool			GetLanguageStyle(const std::string& name,
+								LanguageStyleTable& table) const;
+			bool			GetLanguage(const std::string& name,
+								LanguageTable& table) const;
+			bool			GetLanguageList(LanguageListTable& table) const;
+			// Appends names of entries directly under prefix, like styles
+			// for "styles/".
+			void			GetNames(const std::string& prefix,
+								std::vector<std::string>& names) const;
+
+private:
+	friend class DataBundleWriter;
+
+	struct Header {
+		char		magic[4];
+		uint32		version;
+		uint32		size;
+		uint32		entryCount;
+		uint32		pairCount;
+		uint32		styleCount;
+		uint32		profileCount;
+		uint32		ruleCount;
+		uint32		stringsSize;
+	};
+	struct Entry {
+		uint32		name;
+		int32		value;
+		uint32		pairs;
+		uint32		pairCount;
+		uint32		extraPairs;
+		uint32		extraPairCount;
+		uint32		styles;
+		uint32		styleCount;
+		uint32		profiles;
+		uint32		profileCount;
+		uint32		rules;
+		uint32		ruleCount;
+		int32		option;
+		int32		folding;
+		int32		brackets;
+	};
+	struct Pair {
+		uint32		key;
+		uint32		value;
+	};
+	struct Style {
+		int32		id;
+		int32		fgColor;
+		int32		bgColor;
+		int32		fontStyle;
+		uint32		name;
+	};
+	struct Profile {
+		uint32		name;
+		int32		size;
+		int32		lineLength;
+		int32		lexer;
+		uint32		pairs;
+		uint32		pairCount;
+	};
+	enum RuleKind {
+		FILENAME	= 0,
+		ALIAS		= 1,
+		FIRST_LINE	= 2
+	};
+	struct Rule {
+		uint32		kind;
+		uint32		pattern;
+		uint32		language;
+	};
+
+			const Entry*	_Find(const std::string& name) const;
+			const char*		_String(uint32 offset) const;
+			StyleRecord		_Record(const Style& style) const;
+
+			void*			fData;
+			size_t			fSize;
+			time_t			fModified;
+			const Header*	fHeader;
+			const Entry*	fEntries;
+			const Pair*		fPairs;
+			const Style*	fStyles;
+			const Profile*	fProfiles;
+			const Rule*		fRules;
+			const char*		fStrings;
+};
+
+
+class DataBundleWriter {
+public:
+			void			AddGlobalStyle(const std::string& name,
+								const GlobalStyleTable& table);
+			void			AddLanguageStyle(const std::string& name,
+								const LanguageStyleTable& table);
+			void			AddLanguage(const std::string& name,
+								const LanguageTable& table);
+			void			AddLanguageList(const LanguageListTable& table);
+
+			bool			Write(const char* path);
+
+private:
+	typedef DataBundle::Entry Entry;
+	typedef DataBundle::Pair Pair;
+	typedef DataBundle::Style Style;
+	typedef DataBundle::Profile Profile;
+	typedef DataBundle::Rule Rule;
+
+			Entry&			_AddEntry(const std::string& name);
+			uint32			_String(const std::string& string);
+			void			_AddPair(uint32 key, uint32 value);
+			void			_AddStyle(const StyleRecord& record,
+								uint32 name = 0);
+			void			_AddRule(uint32 kind, const std::string& pattern,
+								const std::string& language);
+
+			std::map<std::string, Entry>	fEntries;
+			std::vector<Pair>				fPairs;
+			std::vector<Style>				fStyles;
+			std::vector<Profile>			fProfiles;
+			std::vector<Rule>				fRules;
+			std::string						fStrings;
+			std::map<std::string, uint32>	fStringOffsets;
+};
+
+
+#endif // DATABUNDLE_H
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "DataLoader.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <Autolock.h>
+#include <FindDirectory.h>
+#include <Path.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <yaml.h>
+
+#include "DataBundle.h"
+#include "EditorWindow.h"
+
+
+BLocker DataLoader::sLock("DataLoader");
+std::vector<DataLoader::Directory> DataLoader::sDirectories;
+bool DataLoader::sInitialized = false;
+std::atomic<uint32> DataLoader::sParseCount(0);
+std::map<std::string, std::string> DataLoader::sLastGood;
+std::map<std::string, std::string> DataLoader::sErrors;
+std::string DataLoader::sNewErrors;
+
+
+/* static */ GlobalStyleTable
+DataLoader::LoadGlobalStyle(const std::string& style)
+{
+	return _Load<GlobalStyleTable>("styles/" + style,
+		[](const DataBundle* bundle, const std::string& name, GlobalStyleTable& table) {
+			return bundle->GetGlobalStyle(name, table); });
+}
+
+
+/* static */ LanguageStyleTable
+DataLoader::LoadLanguageStyle(const std::string& style, const std::string& lang)
+{
+	return _Load<LanguageStyleTable>("styles/" + style + "/" + lang,
+		[](const DataBundle* bundle, const std::string& name, LanguageStyleTable& table) {
+			return bundle->GetLanguageStyle(name, table); });
+}
+
+
+/* static */ LanguageTable
+DataLoader::LoadLanguage(const std::string& lang)
+{
+	return _Load<LanguageTable>("languages/" + lang,
+		[](const DataBundle* bundle, const std::string& name, LanguageTable& table) {
+			return bundle->GetLanguage(name, table); });
+}
+
+
+/* static */ LanguageListTable
+DataLoader::LoadLanguageList()
+{
+	return _Load<LanguageListTable>("languages",
+		[](const DataBundle* bundle, const std::string&, LanguageListTable& table) {
+			return bundle->GetLanguageList(table); });
+}
+
+
+/* static */ std::vector<std::string>
+DataLoader::StyleNames()
+{
+	std::vector<std::string> names;
+	for(const auto& directory : _Directories()) {
+		if(directory.bundle != NULL)
+			directory.bundle->GetNames("styles/", names);
+		DIR* dir = opendir((directory.path + "/styles").c_str());
+		if(dir == NULL)
+			continue;
+		while(dirent* entry = readdir(dir)) {
+			const std::string name = entry->d_name;
+			if(name.size() > 5 && name.compare(name.size() - 5, 5, ".yaml") == 0)
+				names.push_back(name.substr(0, name.size() - 5));
+		}
+		closedir(dir);
+	}
+	std::sort(names.begin(), names.end());
+	names.erase(std::unique(names.begin(), names.end()), names.end());
+	return names;
+}
+
+
+/* static */ std::string
+DataLoader::TakeErrors()
+{
+	BAutolock lock(sLock);
+	std::string errors;
+	errors.swap(sNewErrors);
+	return errors;
+}
+
+
+/* static */ std::vector<std::string>
+DataLoader::Directories()
+{
+	std::vector<std::string> paths;
+	for(const auto& directory : _Directories())
+		paths.push_back(directory.path);
+	return paths;
+}
+
+
+template<typename Table, typename BundleGetter>
+/* static */ Table
+DataLoader::_Load(const std::string& name, BundleGetter fromBundle)
+{
+	Table merged;
+	for(const auto& directory : _Directories()) {
+		const std::string file = directory.path + "/" + name + ".yaml";
+		Table layer;
+		if(directory.bundle != NULL && !_IsOverridden(directory, file)
+				&& fromBundle(directory.bundle, name, layer)) {
+			merged.Merge(layer);
+			continue;
+		}
+		// most layers have no such file
+		std::ifstream stream(file);
+		if(!stream)
+			continue;
+		std::stringstream text;
+		text << stream.rdbuf();
+		// A file being edited may be broken for a while, it is then used as
+		// it was last parsed.
+		try {
+			layer = Table::FromYAML(YAML::Load(text.str()));
+			_Parsed(file, text.str());
+			sParseCount++;
+		} catch(YAML::Exception& e) {
+			std::string lastGood;
+			if(!_Failed(file, e.what(), lastGood))
+				continue;
+			layer = Table::FromYAML(YAML::Load(lastGood));
+		}
+		merged.Merge(layer);
+	}
+	return merged;
+}
+
+
+/* static */ const std::vector<DataLoader::Directory>&
+DataLoader::_Directories()
+{
+	BAutolock lock(sLock);
+	if(sInitialized == true)
+		return sDirectories;
+
+	// lowest priority first
+	const directory_which directories[] = {
+		B_SYSTEM_DATA_DIRECTORY,
+		B_USER_DATA_DIRECTORY,
+		B_SYSTEM_NONPACKAGED_DATA_DIRECTORY,
+		B_USER_NONPACKAGED_DATA_DIRECTORY
+	};
+	for(auto which : directories) {
+		BPath path;
+		if(find_directory(which, &path) != B_OK)
+			continue;
+		path.Append(gAppName);
+		Directory directory;
+		directory.path = path.Path();
+		// Bundles stay mapped until the process exits.
+		directory.bundle = new DataBundle;
+		if(!directory.bundle->Open((directory.path + "/data.bundle").c_str())) {
+			delete directory.bundle;
+			directory.bundle = NULL;
+		}
+		sDirectories.push_back(directory);
+	}
+	sInitialized = true;
+	return sDirectories;
+}
+
+
+/* static */ void
+DataLoader::_Parsed(const std::string& file, const std::string& text)
+{
+	BAutolock lock(sLock);
+	sLastGood[file] = text;
+	sErrors.erase(file);
+}
+
+
+// Records error unless it was reported already. Returns true and sets
+// lastGood if the file was parsed before.
+/* static */ bool
+DataLoader::_Failed(const std::string& file, const std::string& error,
+	std::string& lastGood)
+{
+	BAutolock lock(sLock);
+	std::string& reported = sErrors[file];
+	if(reported != error) {
+		reported = error;
+		sNewErrors += file + ": " + error + "\n";
+	}
+	auto text = sLastGood.find(file);
+	if(text == sLastGood.end())
+		return false;
+	lastGood = text->second;
+	return true;
+}
+
+
+/* static */ bool
+DataLoader::_IsOverridden(const Directory& directory, const std::string& file)
+{
+	struct stat st;
+	if(stat(file.c_str(), &st) != 0)
+		return false;
+	return st.st_mtime > directory.bundle->ModificationTime();
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef DATALOADER_H
+#define DATALOADER_H
+
+
+#include <Locker.h>
+#include <SupportDefs.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "DataTables.h"
+
+
+class DataBundle;
+
+
+/*
+ * Reads data files from system, user and non-packaged data directories and
+ * merges them, lowest priority first. In every directory data.bundle made
+ * by koder-datac is used if present, a YAML file is parsed only when the
+ * bundle lacks it or it was modified after the bundle was built. A file that
+ * fails to parse is used as it was last parsed.
+ * Results are meant to be cached by callers; ParseCount() tells how many
+ * YAML files were parsed in this process.
+ */
+class DataLoader {
+public:
+	static	GlobalStyleTable	LoadGlobalStyle(const std::string& style);
+	static	LanguageStyleTable	LoadLanguageStyle(const std::string& style,
+									const std::string& lang);
+	static	LanguageTable		LoadLanguage(const std::string& lang);
+	static	LanguageListTable	LoadLanguageList();
+
+	// Errors in data files not reported yet, one per line.
+	static	std::string			TakeErrors();
+
+	// Names of styles in all data directories, sorted.
+	static	std::vector<std::string>	StyleNames();
+
+	// Paths of data directories, lowest priority first.
+	static	std::vector<std::string>	Directories();
+
+	static	uint32				ParseCount() { return sParseCount; }
+
+private:
+	struct Directory {
+		std::string		path;
+		DataBundle*		bundle;
+	};
+
+	template<typename Table, typename BundleGetter>
+	static	Table				_Load(const std::string& name,
+									BundleGetter fromBundle);
+	static	const std::vector<Directory>&	_Directories();
+	static	bool				_IsOverridden(const Directory& directory,
+									const std::string& file);
+	static	void				_Parsed(const std::string& file,
+									const std::string& text);
+	static	bool				_Failed(const std::string& file,
+									const std::string& error,
+									std::string& lastGood);
+
+	static	BLocker					sLock;
+	static	std::vector<Directory>	sDirectories;
+	static	bool					sInitialized;
+	static	std::atomic<uint32>		sParseCount;
+	static	std::map<std::string, std::string>	sLastGood;
+		// text of files by path
+	static	std::map<std::string, std::string>	sErrors;
+		// last error of files by path, until they parse again
+	static	std::string				sNewErrors;
+};
+
+
+#endif // DATALOADER_H
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "DataMonitor.h"
+
+#include <Directory.h>
+#include <Entry.h>
+#include <Message.h>
+#include <NodeMonitor.h>
+
+#include <cstring>
+
+#include "DataLoader.h"
+
+
+DataMonitor::DataMonitor(const BMessenger& target)
+	:
+	fTarget(target)
+{
+}
+
+
+DataMonitor::~DataMonitor()
+{
+	stop_watching(fTarget);
+}
+
+
+void
+DataMonitor::Start()
+{
+	for(const auto& path : DataLoader::Directories())
+		_WatchDirectory(path, "");
+}
+
+
+bool
+DataMonitor::Changed(BMessage* message, std::vector<std::string>& names)
+{
+	names.clear();
+	node_ref nref;
+	nref.device = message->GetInt32("device", -1);
+	const int32 opcode = message->GetInt32("opcode", 0);
+	switch(opcode) {
+		case B_STAT_CHANGED:
+		case B_ENTRY_REMOVED: {
+			nref.node = message->GetInt64("node", -1);
+			auto file = fFiles.find(nref);
+			if(file == fFiles.end())
+				return false;
+			names.push_back(file->second);
+			if(opcode == B_ENTRY_REMOVED) {
+				watch_node(&nref, B_STOP_WATCHING, fTarget);
+				fFiles.erase(file);
+			}
+			return true;
+		}
+		case B_ENTRY_MOVED: {
+			// File moved away or renamed is gone under its old name.
+			nref.node = message->GetInt64("node", -1);
+			auto file = fFiles.find(nref);
+			if(file != fFiles.end()) {
+				names.push_back(file->second);
+				watch_node(&nref, B_STOP_WATCHING, fTarget);
+				fFiles.erase(file);
+			}
+		}
+		// fall through
+		case B_ENTRY_CREATED: {
+			// Editors often save by renaming a temporary file over the
+			// original one, so the node changes.
+			nref.node = message->GetInt64(
+				opcode == B_ENTRY_MOVED ? "to directory" : "directory", -1);
+			auto directory = fDirectories.find(nref);
+			const char* leaf = message->GetString("name", NULL);
+			std::string name;
+			if(directory != fDirectories.end() && leaf != NULL
+					&& _WatchEntry(fPaths[nref], directory->second, leaf, name))
+				names.push_back(name);
+			return names.empty() == false;
+		}
+	}
+	return false;
+}
+
+
+void
+DataMonitor::_WatchDirectory(const std::string& path, const std::string& prefix)
+{
+	BDirectory directory(path.c_str());
+	if(directory.InitCheck() != B_OK)
+		return;
+	node_ref nref;
+	directory.GetNodeRef(&nref);
+	if(fDirectories.count(nref) > 0)
+		return;
+	if(watch_node(&nref, B_WATCH_DIRECTORY, fTarget) != B_OK)
+		return;
+	fDirectories[nref] = prefix;
+	fPaths[nref] = path;
+
+	BEntry entry;
+	std::string name;
+	while(directory.GetNextEntry(&entry) == B_OK) {
+		char leaf[B_FILE_NAME_LENGTH];
+		entry.GetName(leaf);
+		_WatchEntry(path, prefix, leaf, name);
+	}
+}
+
+
+// Starts watching a file or subdirectory of a watched directory. Returns
+// true and sets name if it is a data file.
+bool
+DataMonitor::_WatchEntry(const std::string& path, const std::string& prefix,
+	const char* leaf, std::string& name)
+{
+	// only languages/, styles/ and styles/<style>/ contain data files
+	const std::string entryPath = path + "/" + leaf;
+	BEntry entry(entryPath.c_str());
+	if(entry.IsDirectory()) {
+		if((prefix.empty() && (strcmp(leaf, "languages") == 0
+				|| strcmp(leaf, "styles") == 0)) || prefix == "styles/")
+			_WatchDirectory(entryPath, prefix + leaf + "/");
+		return false;
+	}
+	const size_t length = strlen(leaf);
+	if(length <= 5 || strcmp(leaf + length - 5, ".yaml") != 0)
+		return false;
+	node_ref nref;
+	entry.GetNodeRef(&nref);
+	name = prefix + std::string(leaf, length - 5);
+	if(fFiles.count(nref) == 0 && watch_node(&nref, B_WATCH_STAT, fTarget) != B_OK)
+		return false;
+	fFiles[nref] = name;
+	return true;
+}
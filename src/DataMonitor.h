@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef DATAMONITOR_H
+#define DATAMONITOR_H
+
+
+#include <Messenger.h>
+#include <Node.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+class BMessage;
+
+
+enum {
+	DATAMONITOR_CHANGED	= 'dmch'
+};
+
+
+/*
+ * Watches YAML files in data directories. Node monitor messages go to the
+ * target, which passes them to Changed() to learn the names of the data
+ * files, as used by DataLoader, that were modified.
+ */
+class DataMonitor {
+public:
+							DataMonitor(const BMessenger& target);
+							~DataMonitor();
+
+			void			Start();
+			bool			Changed(BMessage* message,
+								std::vector<std::string>& names);
+
+private:
+			void			_WatchDirectory(const std::string& path,
+								const std::string& prefix);
+			bool			_WatchEntry(const std::string& path,
+								const std::string& prefix, const char* leaf,
+								std::string& name);
+
+			BMessenger		fTarget;
+			std::map<node_ref, std::string>	fDirectories;
+				// directory and prefix of names in it, like "styles/"
+			std::map<node_ref, std::string>	fFiles;
+			std::map<node_ref, std::string>	fPaths;
+				// of directories
+};
+
+
+#endif // DATAMONITOR_H
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "DataTables.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+
+void
+StyleRecord::Merge(const StyleRecord& layer)
+{
+	id = layer.id;
+	if(layer.fgColor != -1)
+		fgColor = layer.fgColor;
+	if(layer.bgColor != -1)
+		bgColor = layer.bgColor;
+	if(layer.fontStyle != -1) {
+		// styles are only ever turned on
+		fontStyle = (fontStyle == -1 ? 0 : fontStyle) | layer.fontStyle;
+	}
+}
+
+
+/* static */ StyleRecord
+StyleRecord::FromYAML(const YAML::Node& node)
+{
+	StyleRecord record;
+	if(node["id"]) {
+		record.id = node["id"].as<int>();
+	}
+	if(node["foreground"]) {
+		record.fgColor = strtol(node["foreground"].as<std::string>().c_str(), NULL, 16);
+	}
+	if(node["background"]) {
+		record.bgColor = strtol(node["background"].as<std::string>().c_str(), NULL, 16);
+	}
+	if(node["style"]) {
+		record.fontStyle = 0;
+		auto styles = node["style"].as<std::vector<std::string>>();
+		for(auto style : styles) {
+			if(style == "bold") record.fontStyle |= 1;
+			else if(style == "italic") record.fontStyle |= 2;
+			else if(style == "underline") record.fontStyle |= 4;
+		}
+	}
+	return record;
+}
+
+
+void
+GlobalStyleTable::Merge(const GlobalStyleTable& layer)
+{
+	// Default is followed by SCI_STYLECLEARALL, which resets everything set
+	// by lower layers.
+	if(layer.hasDefault == true) {
+		defaultStyle.Merge(layer.defaultStyle);
+		hasDefault = true;
+		styles.clear();
+	}
+	for(const auto& it : layer.styles)
+		styles[it.first].Merge(it.second);
+	for(const auto& it : layer.special)
+		special[it.first].Merge(it.second);
+}
+
+
+/* static */ GlobalStyleTable
+GlobalStyleTable::FromYAML(const YAML::Node& node)
+{
+	GlobalStyleTable table;
+	if(node["Default"]) {
+		table.defaultStyle = StyleRecord::FromYAML(node["Default"]);
+		table.hasDefault = true;
+	}
+	for(YAML::const_iterator it = node.begin(); it != node.end(); ++it) {
+		StyleRecord record = StyleRecord::FromYAML(it->second);
+		if(record.id != -1)
+			table.styles[record.id].Merge(record);
+		else
+			table.special[it->first.as<std::string>()].Merge(record);
+	}
+	return table;
+}
+
+
+void
+LanguageStyleTable::Merge(const LanguageStyleTable& layer)
+{
+	for(const auto& it : layer.styles)
+		styles[it.first].Merge(it.second);
+}
+
+
+/* static */ LanguageStyleTable
+LanguageStyleTable::FromYAML(const YAML::Node& node)
+{
+	LanguageStyleTable table;
+	for(YAML::const_iterator it = node.begin(); it != node.end(); ++it) {
+		StyleRecord record = StyleRecord::FromYAML(it->second);
+		table.styles[record.id].Merge(record);
+	}
+	return table;
+}
+
+
+void
+LanguageTable::Merge(const LanguageTable& layer)
+{
+	if(layer.lexer != -1)
+		lexer = layer.lexer;
+	for(const auto& it : layer.properties)
+		properties[it.first] = it.second;
+	for(const auto& it : layer.keywords)
+		keywords[it.first] = it.second;
+	if(layer.identifiers != -1)
+		identifiers = layer.identifiers;
+	if(layer.foldByIndentation != -1)
+		foldByIndentation = layer.foldByIndentation;
+	if(layer.bracketStyle != -1)
+		bracketStyle = layer.bracketStyle;
+	if(!layer.profiles.empty())
+		profiles = layer.profiles;
+}
+
+
+/* static */ LanguageTable
+LanguageTable::FromYAML(const YAML::Node& node)
+{
+	LanguageTable table;
+	if(node["lexer"]) {
+		table.lexer = node["lexer"].as<int>();
+	}
+	const YAML::Node properties = node["properties"];
+	for(YAML::const_iterator it = properties.begin(); it != properties.end(); ++it) {
+		table.properties[it->first.as<std::string>()] = it->second.as<std::string>();
+	}
+	const YAML::Node keywords = node["keywords"];
+	for(YAML::const_iterator it = keywords.begin(); it != keywords.end(); ++it) {
+		table.keywords[it->first.as<int>()] = it->second.as<std::string>();
+	}
+	if(node["identifiers"]) {
+		table.identifiers = node["identifiers"].as<int>();
+	}
+	if(node["fold by indentation"]) {
+		table.foldByIndentation = node["fold by indentation"].as<bool>() ? 1 : 0;
+	}
+	if(node["bracket style"]) {
+		table.bracketStyle = node["bracket style"].as<int>();
+	}
+	const YAML::Node profiles = node["profiles"];
+	for(YAML::const_iterator it = profiles.begin(); it != profiles.end(); ++it) {
+		const YAML::Node& item = *it;
+		LanguageTable::Profile profile;
+		profile.name = item["name"].as<std::string>();
+		if(item["size"]) {
+			// given in MiB
+			profile.size = static_cast<int>(item["size"].as<double>() * 1024);
+		}
+		if(item["line length"]) {
+			profile.lineLength = item["line length"].as<int>();
+		}
+		if(item["lexer"]) {
+			profile.lexer = item["lexer"].as<int>();
+		}
+		const YAML::Node itemProperties = item["properties"];
+		for(YAML::const_iterator p = itemProperties.begin(); p != itemProperties.end(); ++p) {
+			profile.properties[p->first.as<std::string>()] = p->second.as<std::string>();
+		}
+		table.profiles.push_back(profile);
+	}
+	return table;
+}
+
+
+void
+LanguageListTable::Merge(const LanguageListTable& layer)
+{
+	for(const auto& language : layer.languages) {
+		auto existing = std::find_if(languages.begin(), languages.end(),
+			[&language](const std::pair<std::string, std::string>& item) {
+				return item.first == language.first; });
+		if(existing != languages.end())
+			existing->second = language.second;
+		else
+			languages.push_back(language);
+	}
+	for(const auto& it : layer.extensions)
+		extensions[it.first] = it.second;
+	filenames.insert(filenames.begin(), layer.filenames.begin(),
+		layer.filenames.end());
+	for(const auto& it : layer.aliases)
+		aliases[it.first] = it.second;
+	firstLines.insert(firstLines.begin(), layer.firstLines.begin(),
+		layer.firstLines.end());
+}
+
+
+/* static */ LanguageListTable
+LanguageListTable::FromYAML(const YAML::Node& node)
+{
+	LanguageListTable table;
+	for(YAML::const_iterator it = node.begin(); it != node.end(); ++it) {
+		auto name = it->first.as<std::string>();
+		auto menuitem = it->second["name"].as<std::string>();
+		auto extensions = it->second["extensions"].as<std::vector<std::string>>();
+		for(auto extension : extensions) {
+			table.extensions[extension] = name;
+		}
+		if(it->second["filenames"]) {
+			for(auto glob : it->second["filenames"].as<std::vector<std::string>>())
+				table.filenames.push_back(std::make_pair(glob, name));
+		}
+		if(it->second["aliases"]) {
+			for(auto alias : it->second["aliases"].as<std::vector<std::string>>())
+				table.aliases[alias] = name;
+		}
+		if(it->second["first line"]) {
+			for(auto regex : it->second["first line"].as<std::vector<std::string>>())
+				table.firstLines.push_back(std::make_pair(regex, name));
+		}
+		table.languages.push_back(std::make_pair(name, menuitem));
+	}
+	return table;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef DATATABLES_H
+#define DATATABLES_H
+
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <yaml.h>
+
+
+/*
+ * In-memory form of the data files. Each table can be built from a single
+ * YAML layer or read from the data bundle, and Merge() puts a higher
+ * priority layer on top with the same result as applying both layers to an
+ * editor one after another.
+ *
+ * This file does not depend on Haiku API, koder-datac builds it too.
+ */
+
+struct StyleRecord {
+					StyleRecord() : id(-1), fgColor(-1), bgColor(-1), fontStyle(-1) {}
+
+	void			Merge(const StyleRecord& layer);
+	static	StyleRecord	FromYAML(const YAML::Node& node);
+
+	int				id;
+	int				fgColor;
+	int				bgColor;
+	int				fontStyle;
+		// bit field: 1 bold, 2 italic, 4 underline
+};
+
+
+// styles/<style>.yaml
+struct GlobalStyleTable {
+					GlobalStyleTable() : hasDefault(false) {}
+
+	void			Merge(const GlobalStyleTable& layer);
+	static	GlobalStyleTable	FromYAML(const YAML::Node& node);
+
+	bool							hasDefault;
+	StyleRecord						defaultStyle;
+	std::map<int, StyleRecord>		styles;
+	std::map<std::string, StyleRecord>	special;
+		// entries without id, like "Caret"
+};
+
+
+// styles/<style>/<language>.yaml
+struct LanguageStyleTable {
+	void			Merge(const LanguageStyleTable& layer);
+	static	LanguageStyleTable	FromYAML(const YAML::Node& node);
+
+	std::map<int, StyleRecord>		styles;
+};
+
+
+// languages/<language>.yaml
+struct LanguageTable {
+	// Overrides for big documents, see Languages::ApplyLanguage.
+	struct Profile {
+					Profile() : size(0), lineLength(0), lexer(-1) {}
+
+		std::string							name;
+		int									size;
+			// in KiB, 0 if not set
+		int									lineLength;
+			// 0 if not set
+		int									lexer;
+		std::map<std::string, std::string>	properties;
+	};
+
+					LanguageTable() : lexer(-1), identifiers(-1), foldByIndentation(-1),
+						bracketStyle(-1) {}
+
+	void			Merge(const LanguageTable& layer);
+	static	LanguageTable	FromYAML(const YAML::Node& node);
+
+	int									lexer;
+	std::map<std::string, std::string>	properties;
+	std::map<int, std::string>			keywords;
+	int									identifiers;
+		// keyword set of names defined in the project, -1 if none
+	int									foldByIndentation;
+		// for lexers which do not fold, -1 if not set
+	int									bracketStyle;
+		// style of brackets in code, as opposed to comments and strings,
+		// -1 if not set
+	std::vector<Profile>				profiles;
+		// ordered by size, replaced as a whole by higher layers
+};
+
+
+// languages.yaml
+struct LanguageListTable {
+	void			Merge(const LanguageListTable& layer);
+	static	LanguageListTable	FromYAML(const YAML::Node& node);
+
+	std::vector<std::pair<std::string, std::string>>	languages;
+		// name and menu item, in file order
+	std::map<std::string, std::string>	extensions;
+	// rules for LanguageDetector, higher layers come first
+	std::vector<std::pair<std::string, std::string>>	filenames;
+		// glob and language
+	std::map<std::string, std::string>	aliases;
+		// names used in shebang lines and modelines
+	std::vector<std::pair<std::string, std::string>>	firstLines;
+		// regular expression and language
+};
+
+
+#endif // DATATABLES_H
@@ -5,43 +5,173 @@
 
 #include "Editor.h"
 
+#include <MessageRunner.h>
 #include <Messenger.h>
+#include <OS.h>
 
 #include <algorithm>
 
 #include "Preferences.h"
 
 
+namespace {
+
+const Sci_Position kBackgroundStylingThreshold = 1024 * 1024;
+const Sci_Position kStylingChunk = 16 * 1024;
+const int32 kStylingLookAhead = 200;
+	// lines past the bottom of the screen styled with priority
+const bigtime_t kPrioritySlice = 8000;
+const bigtime_t kPriorityInterval = 16000;
+const bigtime_t kIdleSlice = 2000;
+const bigtime_t kIdleInterval = 50000;
+const bigtime_t kTextChangeInterval = 500000;
+
+}
+
+
 Editor::Editor()
 	:
-	BScintillaView("EditorView", 0, true, true, B_NO_BORDER)
+	BScintillaView("EditorView", 0, true, true, B_NO_BORDER),
+	fBackgroundStyling(false),
+	fStylingRunner(NULL),
+	fStylingInterval(0),
+	fStylingPriorityEnd(0),
+	fStylingTime(0),
+	fStylingLongestSlice(0),
+	fStylingSlices(0),
+	fSymbols(this),
+	fTags(this),
+	fFolder(this),
+	fBrackets(this),
+	fIndexer(this),
+	fSharing(NULL),
+	fHighlightedCaret(-1),
+	fHighlightedBraces(false),
+	fTextChangePosted(0),
+	fLineNumberDigits(0)
 {
+	fDirect.SetView(this);
+	// fold levels set by lexers and the folder are not worth a notification,
+	// styling is followed by the bracket index
+	SendMessage(SCI_SETMODEVENTMASK, SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT
+		| SC_MOD_CHANGESTYLE, 0);
+	fHighlightedScope[0] = fHighlightedScope[1] = -1;
+	for(Sci_CharacterRange& range : fHighlightedTags)
+		range.cpMin = range.cpMax = -1;
+	for(int indicator : { TAG_ATTRIBUTES, TAG_MATCH, SCOPE }) {
+		SendMessage(SCI_INDICSETSTYLE, indicator, INDIC_STRAIGHTBOX);
+		SendMessage(SCI_INDICSETALPHA, indicator, 100);
+		SendMessage(SCI_INDICSETUNDER, indicator, true);
+	}
+}
+
+
+Editor::~Editor()
+{
+	if(fSharing != NULL)
+		fSharing->fSharing = NULL;
+	delete fStylingRunner;
+}
+
+
+void
+Editor::MessageReceived(BMessage* message)
+{
+	switch(message->what) {
+		case EDITOR_STYLE_CHUNK:
+			_StyleChunk();
+		break;
+		case SYMBOLINDEX_SCANNED:
+			if(fSymbols.Finish(message) == true)
+				Window()->PostMessage(EDITOR_SYMBOLS_CHANGED);
+		break;
+		default:
+			BScintillaView::MessageReceived(message);
+		break;
+	}
 }
 
 
 void
 Editor::NotificationReceived(SCNotification* notification)
 {
-	BMessenger window_msg(NULL, (BLooper*) Window());
+	const int64 messageCount = fDirect.Calls();
 	switch(notification->nmhdr.code) {
 		case SCN_SAVEPOINTLEFT:
-			window_msg.SendMessage(EDITOR_SAVEPOINT_LEFT);
+			Window()->PostMessage(EDITOR_SAVEPOINT_LEFT);
 		break;
 		case SCN_SAVEPOINTREACHED:
-			window_msg.SendMessage(EDITOR_SAVEPOINT_REACHED);
+			Window()->PostMessage(EDITOR_SAVEPOINT_REACHED);
 		break;
 		case SCN_CHARADDED: {
 			char ch = static_cast<char>(notification->ch);
 			_MaintainIndentation(ch);
 		} break;
-		case SCN_UPDATEUI:
-			_BraceHighlight();
-			_UpdateLineNumberWidth();
-		break;
+		case SCN_FOCUSIN: {
+			// the other view may have drawn indicators in the meantime,
+			// -2 is never looked up so they are drawn again
+			fHighlightedScope[0] = fHighlightedScope[1] = -2;
+			for(Sci_CharacterRange& range : fHighlightedTags)
+				range.cpMin = range.cpMax = -2;
+			const Sci_Position caret = SendMessage(SCI_GETCURRENTPOS, 0, 0);
+			_ScopeHighlight(caret);
+			_TagHighlight(caret);
+		} break;
+		case SCN_UPDATEUI: {
+			// sent for scrolling too, and again for the same caret
+			const int updated = notification->updated;
+			const bool content = (updated & SC_UPDATE_CONTENT) != 0;
+			if(content == true || (updated & SC_UPDATE_SELECTION) != 0) {
+				const Sci_Position caret = SendMessage(SCI_GETCURRENTPOS, 0, 0);
+				if(content == true || caret != fHighlightedCaret
+						|| fPreferences->fBracesHighlighting != fHighlightedBraces) {
+					fHighlightedCaret = caret;
+					fHighlightedBraces = fPreferences->fBracesHighlighting;
+					_BraceHighlight(caret);
+					_ScopeHighlight(caret);
+					_TagHighlight(caret);
+				}
+			}
+			if(content == true)
+				_UpdateLineNumberWidth(false);
+			if(fBackgroundStyling == true
+					&& (content == true || (updated & SC_UPDATE_V_SCROLL) != 0))
+				_UpdateStylingPriority();
+		} break;
 		case SCN_MARGINCLICK:
 			_MarginClick(notification->margin, notification->position);
 		break;
+		case SCN_MODIFIED:
+			// not sent to views sharing the document of another one
+			fBrackets.Modified(notification);
+			fTags.Modified(notification);
+			fFolder.Modified(notification);
+			if(fSymbols.Modified(notification) == true)
+				Window()->PostMessage(EDITOR_SYMBOLS_CHANGED);
+			if((notification->modificationType
+					& (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) != 0
+					&& system_time() - fTextChangePosted > kTextChangeInterval) {
+				fTextChangePosted = system_time();
+				Window()->PostMessage(EDITOR_TEXT_CHANGED);
+			}
+		break;
 	}
+	NotificationCost& cost = fNotificationCosts[notification->nmhdr.code];
+	cost.count++;
+	cost.messages += fDirect.Calls() - messageCount;
+}
+
+
+void
+Editor::ShareDocument(Editor* owner)
+{
+	// adds a reference to the document, released when the view is deleted
+	SendMessage(SCI_SETDOCPOINTER, 0, owner->SendMessage(SCI_GETDOCPOINTER, 0, 0));
+	// the owner keeps the indexes current
+	SendMessage(SCI_SETMODEVENTMASK, 0, 0);
+	fIndexer = owner;
+	fSharing = owner;
+	owner->fSharing = this;
 }
 
 
@@ -52,20 +182,93 @@ Editor::SetPreferences(Preferences* preferences)
 }
 
 
+void
+Editor::UpdateLineNumberWidth()
+{
+	_UpdateLineNumberWidth(true);
+}
+
+
+bool
+Editor::GoToMatchingTag()
+{
+	TagIndex& tags = Tags();
+	if(tags.IsEnabled() == false)
+		return false;
+	const int32 index = tags.IndexAt(SendMessage(SCI_GETCURRENTPOS, 0, 0));
+	if(index < 0)
+		return false;
+	const int32 match = tags.MatchOf(index);
+	if(match < 0 || match == index)
+		return false;
+	const TagIndex::Tag tag = tags.TagAt(match);
+	// before the name, so going back finds this tag
+	SendMessage(SCI_GOTOPOS, tag.start + (tag.kind == TagIndex::CLOSE ? 2 : 1), 0);
+	return true;
+}
+
+
+bool
+Editor::GoToEnclosingBracket()
+{
+	const Sci_Position bracket = Brackets().Enclosing(
+		SendMessage(SCI_GETCURRENTPOS, 0, 0));
+	if(bracket < 0)
+		return false;
+	SendMessage(SCI_GOTOPOS, bracket, 0);
+	return true;
+}
+
+
+void
+Editor::UpdateStyling()
+{
+	fBackgroundStyling = SendMessage(SCI_GETLENGTH, 0, 0) >= kBackgroundStylingThreshold;
+	// the styling runner is the only one working in background
+	SendMessage(SCI_SETIDLESTYLING, SC_IDLESTYLING_NONE, 0);
+	fStylingTime = 0;
+	fStylingLongestSlice = 0;
+	fStylingSlices = 0;
+	if(fBackgroundStyling == true)
+		_UpdateStylingPriority();
+	else
+		_SetStylingInterval(0);
+}
+
+
+// Average cost of a call in nanoseconds, through the view as index classes
+// used to make them and through the direct function.
+void
+Editor::MeasureCalls(float& view, float& direct)
+{
+	const int32 kCalls = 10000;
+	bigtime_t start = system_time();
+	for(int32 i = 0; i < kCalls; i++)
+		BScintillaView::SendMessage(SCI_GETCURRENTPOS, 0, 0);
+	view = (system_time() - start) * 1000.0f / kCalls;
+	ScintillaDirect counted(fDirect);
+		// calls made here are not counted against notifications
+	start = system_time();
+	for(int32 i = 0; i < kCalls; i++)
+		counted.CurrentPos();
+	direct = (system_time() - start) * 1000.0f / kCalls;
+}
+
+
 // borrowed from SciTE
 // Copyright (c) Neil Hodgson
 void
 Editor::_MaintainIndentation(char ch)
 {
-	int eolMode = SendMessage(SCI_GETEOLMODE, 0, 0);
-	int currentLine = SendMessage(SCI_LINEFROMPOSITION, SendMessage(SCI_GETCURRENTPOS, 0, 0), 0);
+	int eolMode = fDirect.EOLMode();
+	int currentLine = fDirect.LineFromPosition(fDirect.CurrentPos());
 	int lastLine = currentLine - 1;
 
 	if(((eolMode == SC_EOL_CRLF || eolMode == SC_EOL_LF) && ch == '\n') ||
 		(eolMode == SC_EOL_CR && ch == '\r')) {
 		int indentAmount = 0;
 		if(lastLine >= 0) {
-			indentAmount = SendMessage(SCI_GETLINEINDENTATION, lastLine, 0);
+			indentAmount = fDirect.LineIndentation(lastLine);
 		}
 		if(indentAmount > 0) {
 			_SetLineIndentation(currentLine, indentAmount);
@@ -75,25 +278,46 @@ Editor::_MaintainIndentation(char ch)
 
 
 void
-Editor::_UpdateLineNumberWidth()
+Editor::_UpdateLineNumberWidth(bool force)
 {
-	if(fPreferences->fLineNumbers) {
-		int numLines = SendMessage(SCI_GETLINECOUNT, 0, 0);
-		int i;
-		for(i = 1; numLines > 0; numLines /= 10, ++i);
-		int charWidth = SendMessage(SCI_TEXTWIDTH, STYLE_LINENUMBER, (sptr_t) "0");
-		SendMessage(SCI_SETMARGINWIDTHN, Margin::NUMBER, std::max(i, 3) * charWidth);
-	}
+	if(fPreferences->fLineNumbers == false)
+		return;
+	// room for one more digit, at least 3
+	int digits = 2;
+	for(int lines = SendMessage(SCI_GETLINECOUNT, 0, 0); lines >= 10; lines /= 10)
+		digits++;
+	digits = std::max(digits, 3);
+	if(digits == fLineNumberDigits && force == false)
+		return;
+	fLineNumberDigits = digits;
+	SendMessage(SCI_SETMARGINWIDTHN, Margin::NUMBER,
+		digits * _CharWidth(STYLE_LINENUMBER));
+}
+
+
+int
+Editor::_CharWidth(int style)
+{
+	char font[256] = {};
+	if(SendMessage(SCI_STYLEGETFONT, style, 0) < (sptr_t) sizeof(font))
+		SendMessage(SCI_STYLEGETFONT, style, (sptr_t) font);
+	std::string key(font);
+	key.append(" ").append(std::to_string(style))
+		.append(" ").append(std::to_string(SendMessage(SCI_STYLEGETSIZE, style, 0)))
+		.append(SendMessage(SCI_STYLEGETBOLD, style, 0) ? " bold" : "");
+	auto cached = fCharWidths.find(key);
+	if(cached != fCharWidths.end())
+		return cached->second;
+	return fCharWidths[key] = SendMessage(SCI_TEXTWIDTH, style, (sptr_t) "0");
 }
 
 
 void
-Editor::_BraceHighlight()
+Editor::_BraceHighlight(Sci_Position caret)
 {
 	if(fPreferences->fBracesHighlighting == true) {
-		int pos = SendMessage(SCI_GETCURRENTPOS, 0, 0);
-		if(_BraceMatch(pos - 1) == false) {
-			_BraceMatch(pos);
+		if(_BraceMatch(caret - 1) == false) {
+			_BraceMatch(caret);
 		}
 	} else {
 		SendMessage(SCI_BRACEBADLIGHT, -1, 0);
@@ -101,12 +325,26 @@ Editor::_BraceHighlight()
 }
 
 
+// Brackets are paired by the index. Text which is not styled yet is not in
+// it, there Scintilla looks for the match. Brackets in comments and strings
+// are not paired.
 bool
 Editor::_BraceMatch(int pos)
 {
 	char ch = SendMessage(SCI_GETCHARAT, pos, 0);
 	if(ch == '(' || ch == ')' || ch == '[' || ch == ']' || ch == '{' || ch == '}') {
-		int match = SendMessage(SCI_BRACEMATCH, pos, 0);
+		const Sci_Position endStyled = SendMessage(SCI_GETENDSTYLED, 0, 0);
+		int match = -1;
+		if(Brackets().Contains(pos) == true) {
+			match = Brackets().MatchOf(pos);
+			if(match == -1 && endStyled < SendMessage(SCI_GETLENGTH, 0, 0))
+				match = SendMessage(SCI_BRACEMATCH, pos, 0);
+		} else if(pos >= endStyled) {
+			match = SendMessage(SCI_BRACEMATCH, pos, 0);
+		} else {
+			SendMessage(SCI_BRACEBADLIGHT, -1, 0);
+			return false;
+		}
 		if(match == -1) {
 			SendMessage(SCI_BRACEBADLIGHT, pos, 0);
 		} else {
@@ -120,6 +358,116 @@ Editor::_BraceMatch(int pos)
 }
 
 
+// Of two views of a document, the focused one draws indicators. If the
+// focus is elsewhere, like in the Find window, the owner of the document
+// does.
+bool
+Editor::_DrawsIndicators()
+{
+	if(fSharing == NULL || _IsFocused(this) == true)
+		return true;
+	return fIndexer == this && _IsFocused(fSharing) == false;
+}
+
+
+// Focus is held by the view Scintilla draws in, a child of the editor.
+bool
+Editor::_IsFocused(Editor* editor)
+{
+	BView* focus = Window() != NULL ? Window()->CurrentFocus() : NULL;
+	return focus != NULL && (focus == editor || focus->Parent() == editor);
+}
+
+
+void
+Editor::_ScopeHighlight(Sci_Position caret)
+{
+	if(_DrawsIndicators() == false)
+		return;
+	Sci_Position scope[2] = { -1, -1 };
+	if(fPreferences->fBracesHighlighting == true) {
+		scope[0] = Brackets().Enclosing(caret, '{');
+		if(scope[0] >= 0)
+			scope[1] = Brackets().MatchOf(scope[0]);
+	}
+	if(scope[0] == fHighlightedScope[0] && scope[1] == fHighlightedScope[1])
+		return;
+	SendMessage(SCI_SETINDICATORCURRENT, SCOPE, 0);
+	SendMessage(SCI_INDICATORCLEARRANGE, 0, SendMessage(SCI_GETLENGTH, 0, 0));
+	for(Sci_Position brace : scope) {
+		if(brace >= 0)
+			SendMessage(SCI_INDICATORFILLRANGE, brace, 1);
+	}
+	fHighlightedScope[0] = scope[0];
+	fHighlightedScope[1] = scope[1];
+}
+
+
+void
+Editor::_TagHighlight(Sci_Position caret)
+{
+	if(_DrawsIndicators() == false)
+		return;
+	TagIndex& tagIndex = Tags();
+	Sci_CharacterRange tags[2];
+	for(Sci_CharacterRange& range : tags)
+		range.cpMin = range.cpMax = -1;
+	int32 index = -1, match = -1;
+	if(fPreferences->fBracesHighlighting == true && tagIndex.IsEnabled() == true) {
+		index = tagIndex.IndexAt(caret);
+		if(index >= 0)
+			match = tagIndex.MatchOf(index);
+	}
+	if(match >= 0) {
+		const TagIndex::Tag tag = tagIndex.TagAt(std::min(index, match));
+		const TagIndex::Tag other = tagIndex.TagAt(std::max(index, match));
+		tags[0].cpMin = tag.start;
+		tags[0].cpMax = tag.end;
+		if(match != index) {
+			tags[1].cpMin = other.start;
+			tags[1].cpMax = other.end;
+		}
+	}
+	bool changed = false;
+	for(int i = 0; i < 2; i++) {
+		changed = changed || tags[i].cpMin != fHighlightedTags[i].cpMin
+			|| tags[i].cpMax != fHighlightedTags[i].cpMax;
+	}
+	if(changed == false)
+		return;
+
+	const Sci_Position length = SendMessage(SCI_GETLENGTH, 0, 0);
+	for(int indicator : { TAG_ATTRIBUTES, TAG_MATCH }) {
+		SendMessage(SCI_SETINDICATORCURRENT, indicator, 0);
+		SendMessage(SCI_INDICATORCLEARRANGE, 0, length);
+	}
+	if(match >= 0) {
+		_HighlightTag(tagIndex.TagAt(index));
+		if(match != index)
+			_HighlightTag(tagIndex.TagAt(match));
+	}
+	fHighlightedTags[0] = tags[0];
+	fHighlightedTags[1] = tags[1];
+}
+
+
+// Name with brackets as a match, the rest as attributes.
+void
+Editor::_HighlightTag(const TagIndex::Tag& tag)
+{
+	const Sci_Position nameEnd = tag.start + (tag.kind == TagIndex::CLOSE ? 2 : 1)
+		+ tag.name.size();
+	const Sci_Position closeStart = tag.end - (tag.kind == TagIndex::EMPTY ? 2 : 1);
+	SendMessage(SCI_SETINDICATORCURRENT, TAG_MATCH, 0);
+	SendMessage(SCI_INDICATORFILLRANGE, tag.start, nameEnd - tag.start);
+	SendMessage(SCI_INDICATORFILLRANGE, closeStart, tag.end - closeStart);
+	if(closeStart > nameEnd) {
+		SendMessage(SCI_SETINDICATORCURRENT, TAG_ATTRIBUTES, 0);
+		SendMessage(SCI_INDICATORFILLRANGE, nameEnd, closeStart - nameEnd);
+	}
+}
+
+
 void
 Editor::_MarginClick(int margin, int pos)
 {
@@ -132,6 +480,74 @@ Editor::_MarginClick(int margin, int pos)
 }
 
 
+// Lexing is sequential, so text up to the screen has to be styled before
+// it. That part and a look-ahead below it is styled in bigger slices, the
+// rest in small ones so typing stays responsive.
+void
+Editor::_StyleChunk()
+{
+	const bigtime_t start = system_time();
+	const Sci_Position length = SendMessage(SCI_GETLENGTH, 0, 0);
+	Sci_Position endStyled = SendMessage(SCI_GETENDSTYLED, 0, 0);
+	const bool priority = endStyled < fStylingPriorityEnd;
+	const bigtime_t slice = priority ? kPrioritySlice : kIdleSlice;
+	while(endStyled < length && system_time() - start < slice) {
+		SendMessage(SCI_COLOURISE, endStyled,
+			std::min(endStyled + kStylingChunk, length));
+		const Sci_Position styled = SendMessage(SCI_GETENDSTYLED, 0, 0);
+		if(styled <= endStyled)
+			break;
+		endStyled = styled;
+	}
+	const bigtime_t elapsed = system_time() - start;
+	fStylingTime += elapsed;
+	fStylingLongestSlice = std::max(fStylingLongestSlice, elapsed);
+	fStylingSlices++;
+
+	if(endStyled >= length) {
+		_SetStylingInterval(0);
+	} else if(priority && endStyled >= fStylingPriorityEnd) {
+		_SetStylingInterval(kIdleInterval);
+	}
+}
+
+
+// Called when the view scrolls or the text changes.
+void
+Editor::_UpdateStylingPriority()
+{
+	const int32 firstLine = SendMessage(SCI_DOCLINEFROMVISIBLE,
+		SendMessage(SCI_GETFIRSTVISIBLELINE, 0, 0), 0);
+	const int32 lastLine = firstLine + SendMessage(SCI_LINESONSCREEN, 0, 0)
+		+ kStylingLookAhead;
+	fStylingPriorityEnd = SendMessage(SCI_GETLINEENDPOSITION, lastLine, 0);
+	const Sci_Position endStyled = SendMessage(SCI_GETENDSTYLED, 0, 0);
+	if(endStyled < fStylingPriorityEnd)
+		_SetStylingInterval(kPriorityInterval);
+	else if(endStyled < SendMessage(SCI_GETLENGTH, 0, 0))
+		_SetStylingInterval(kIdleInterval);
+}
+
+
+// 0 stops styling in background.
+void
+Editor::_SetStylingInterval(bigtime_t interval)
+{
+	if(interval == fStylingInterval)
+		return;
+	fStylingInterval = interval;
+	if(interval == 0) {
+		delete fStylingRunner;
+		fStylingRunner = NULL;
+	} else if(fStylingRunner == NULL) {
+		BMessage message(EDITOR_STYLE_CHUNK);
+		fStylingRunner = new BMessageRunner(BMessenger(this), &message, interval);
+	} else {
+		fStylingRunner->SetInterval(interval);
+	}
+}
+
+
 // borrowed from SciTE
 // Copyright (c) Neil Hodgson
 void
@@ -142,9 +558,9 @@ Editor::_SetLineIndentation(int line, int indent)
 
 	Sci_CharacterRange crange = _GetSelection();
 	Sci_CharacterRange crangeStart = crange;
-	int posBefore = SendMessage(SCI_GETLINEINDENTPOSITION, line, 0);
-	SendMessage(SCI_SETLINEINDENTATION, line, indent);
-	int posAfter = SendMessage(SCI_GETLINEINDENTPOSITION, line, 0);
+	int posBefore = fDirect.LineIndentPosition(line);
+	fDirect.SetLineIndentation(line, indent);
+	int posAfter = fDirect.LineIndentPosition(line);
 	int posDifference = posAfter - posBefore;
 	if(posAfter > posBefore) {
 		if(crange.cpMin >= posBefore) {
@@ -179,8 +595,8 @@ Sci_CharacterRange
 Editor::_GetSelection()
 {
 	Sci_CharacterRange crange;
-	crange.cpMin = SendMessage(SCI_GETSELECTIONSTART, 0, 0);
-	crange.cpMax = SendMessage(SCI_GETSELECTIONEND, 0, 0);
+	crange.cpMin = fDirect.SelectionStart();
+	crange.cpMax = fDirect.SelectionEnd();
 	return crange;
 }
 
@@ -188,5 +604,5 @@ Editor::_GetSelection()
 void
 Editor::_SetSelection(int anchor, int currentPos)
 {
-	SendMessage(SCI_SETSEL, anchor, currentPos);
+	fDirect.SetSel(anchor, currentPos);
 }
@@ -9,14 +9,30 @@
 
 #include <ScintillaView.h>
 #include <SciLexer.h>
+#include <SupportDefs.h>
 
+#include <map>
+#include <string>
 
+#include "BracketIndex.h"
+#include "IndentFolder.h"
+#include "ScintillaDirect.h"
+#include "Styler.h"
+#include "SymbolIndex.h"
+#include "TagIndex.h"
+
+
+class BMessageRunner;
 class Preferences;
 
 
 enum {
 	EDITOR_SAVEPOINT_LEFT		= 'svpl',
-	EDITOR_SAVEPOINT_REACHED	= 'svpr'
+	EDITOR_SAVEPOINT_REACHED	= 'svpr',
+	EDITOR_STYLE_CHUNK			= 'edsc',
+	EDITOR_SYMBOLS_CHANGED		= 'edsy',
+	EDITOR_TEXT_CHANGED			= 'edtc'
+		// at most every kTextChangeInterval
 };
 
 
@@ -26,25 +42,120 @@ public:
 		NUMBER 		= 0,
 		FOLD
 	};
+	// Numbers match style ids in themes, where their colours come from.
+	enum Indicator {
+		TAG_ATTRIBUTES	= 26,
+		TAG_MATCH		= 27,
+		SCOPE			= 30
+			// braces of the block the caret is in
+	};
 
 						Editor();
+						~Editor();
 
+	void				MessageReceived(BMessage* message);
 	void				NotificationReceived(SCNotification* notification);
+	// Goes through the direct function, as do the index classes calling
+	// it. Counted to tell how many messages each kind of notification
+	// costs.
+	sptr_t				SendMessage(unsigned int message, uptr_t wParam = 0,
+							sptr_t lParam = 0)
+		{ return fDirect.Call(message, wParam, lParam); }
+	ScintillaDirect&	Direct() { return fDirect; }
+
+	// Big documents are styled as far as they are painted, the rest is
+	// lexed in time slices afterwards, text below the screen first. Call
+	// after setting the text or the lexer.
+	void				UpdateStyling();
+	// Of background styling since the last UpdateStyling(), the longest
+	// slice bounds how long input waits.
+	int32				StylingSlices() const { return fStylingSlices; }
+	bigtime_t			StylingTime() const { return fStylingTime; }
+	bigtime_t			StylingLongestSlice() const
+							{ return fStylingLongestSlice; }
 
 	void				SetPreferences(Preferences* preferences);
+	// Call when the font or line number preference changes, otherwise the
+	// margin is only resized when the line count gets another digit.
+	void				UpdateLineNumberWidth();
+	void				MeasureCalls(float& view, float& direct);
+	struct NotificationCost {
+		int32			count;
+		int64			messages;
+	};
+	// By notification code.
+	const std::map<int, NotificationCost>&	NotificationCosts() const
+		{ return fNotificationCosts; }
+
+	Styler::EditorState&	StyleState() { return fStyleState; }
+	// Makes this view show the document of owner and use its indexes, so
+	// they are kept once per document. Indicators belong to the document
+	// too, of the two views only the focused one draws those following
+	// the caret.
+	void				ShareDocument(Editor* owner);
+	// Follow edits, the window sets their language.
+	SymbolIndex&		Symbols() { return fIndexer->fSymbols; }
+	TagIndex&			Tags() { return fIndexer->fTags; }
+	IndentFolder&		Folder() { return fIndexer->fFolder; }
+	BracketIndex&		Brackets() { return fIndexer->fBrackets; }
+	// Moves the caret to the other tag of the element it is in.
+	bool				GoToMatchingTag();
+	// Moves the caret before the innermost bracket it is in, pressed again
+	// it goes to the next outer one.
+	bool				GoToEnclosingBracket();
 
 private:
 	void				_MaintainIndentation(char ch);
-	void				_UpdateLineNumberWidth();
-	void				_BraceHighlight();
+	void				_UpdateLineNumberWidth(bool force);
+	int					_CharWidth(int style);
+	void				_BraceHighlight(Sci_Position caret);
 	bool				_BraceMatch(int pos);
+	bool				_DrawsIndicators();
+	bool				_IsFocused(Editor* editor);
+	void				_ScopeHighlight(Sci_Position caret);
+	void				_TagHighlight(Sci_Position caret);
+	void				_HighlightTag(const TagIndex::Tag& tag);
 	void				_MarginClick(int margin, int pos);
+	void				_StyleChunk();
+	void				_UpdateStylingPriority();
+	void				_SetStylingInterval(bigtime_t interval);
 
 	void				_SetLineIndentation(int line, int indent);
 	Sci_CharacterRange	_GetSelection();
 	void				_SetSelection(int anchor, int currentPos);
 
 	Preferences*		fPreferences;
+
+	bool				fBackgroundStyling;
+	BMessageRunner*		fStylingRunner;
+	bigtime_t			fStylingInterval;
+	Sci_Position		fStylingPriorityEnd;
+		// styled with larger slices, it is on screen or close to it
+	bigtime_t			fStylingTime;
+	bigtime_t			fStylingLongestSlice;
+	int32				fStylingSlices;
+	Styler::EditorState	fStyleState;
+	SymbolIndex			fSymbols;
+	TagIndex			fTags;
+	IndentFolder		fFolder;
+	BracketIndex		fBrackets;
+	Editor*				fIndexer;
+		// whose indexes are used, this one unless the document is shared
+	Editor*				fSharing;
+		// the other view of the document, NULL if there is none
+	Sci_Position		fHighlightedScope[2];
+	Sci_CharacterRange	fHighlightedTags[2];
+		// whole tags, to highlight them again only when they change
+	Sci_Position		fHighlightedCaret;
+	bool				fHighlightedBraces;
+		// braces and tags are looked up again only when these change
+		// or the text does
+	bigtime_t			fTextChangePosted;
+	int					fLineNumberDigits;
+	std::map<std::string, int>	fCharWidths;
+		// of '0' by style and font
+	ScintillaDirect		fDirect;
+	std::map<int, NotificationCost>	fNotificationCosts;
 };
 
 
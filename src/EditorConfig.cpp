@@ -0,0 +1,456 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "EditorConfig.h"
+
+#include <Autolock.h>
+#include <File.h>
+#include <Message.h>
+#include <NodeMonitor.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include <Scintilla.h>
+
+
+namespace {
+
+const char* kFileName = ".editorconfig";
+const off_t kMaxFileSize = 1024 * 1024;
+
+
+std::string
+Trim(const std::string& text)
+{
+	const size_t start = text.find_first_not_of(" \t\r");
+	if(start == std::string::npos)
+		return std::string();
+	return text.substr(start, text.find_last_not_of(" \t\r") - start + 1);
+}
+
+
+std::string
+ToLower(std::string text)
+{
+	for(char& c : text)
+		c = tolower(static_cast<unsigned char>(c));
+	return text;
+}
+
+
+void
+AppendLiteral(std::string& regex, char c)
+{
+	if(strchr(".^$|()[]{}*+?\\", c) != NULL)
+		regex += '\\';
+	regex += c;
+}
+
+
+// Returns position of '}' closing the brace at start, or npos.
+size_t
+ClosingBrace(const std::string& glob, size_t start, bool& alternatives)
+{
+	alternatives = false;
+	int depth = 0;
+	for(size_t i = start; i < glob.size(); i++) {
+		if(glob[i] == '\\')
+			i++;
+		else if(glob[i] == '{')
+			depth++;
+		else if(glob[i] == ',' && depth == 1)
+			alternatives = true;
+		else if(glob[i] == '}' && --depth == 0)
+			return i;
+	}
+	return std::string::npos;
+}
+
+
+bool
+ParseRange(const std::string& text, long& from, long& to)
+{
+	const size_t dots = text.find("..");
+	if(dots == std::string::npos || dots == 0 || dots + 2 == text.size())
+		return false;
+	char* end;
+	from = strtol(text.c_str(), &end, 10);
+	if(end != text.c_str() + dots)
+		return false;
+	to = strtol(text.c_str() + dots + 2, &end, 10);
+	return *end == '\0';
+}
+
+
+// Translates an EditorConfig glob. Number ranges become groups checked
+// after the match.
+std::string
+GlobToRegex(const std::string& glob, std::vector<std::pair<long, long>>& ranges)
+{
+	std::string regex;
+	std::vector<bool> braces;
+		// open braces, true for alternatives and false for literal ones
+	for(size_t i = 0; i < glob.size(); i++) {
+		const char c = glob[i];
+		switch(c) {
+			case '\\':
+				if(i + 1 < glob.size())
+					AppendLiteral(regex, glob[++i]);
+			break;
+			case '/':
+				if(glob.compare(i, 4, "/**/") == 0) {
+					// also matches a single slash
+					regex += "(?:/|/.*/)";
+					i += 3;
+				} else
+					regex += '/';
+			break;
+			case '*':
+				if(i + 1 < glob.size() && glob[i + 1] == '*') {
+					regex += ".*";
+					i++;
+				} else
+					regex += "[^/]*";
+			break;
+			case '?':
+				regex += "[^/]";
+			break;
+			case '[': {
+				const size_t close = glob.find(']', i + 2);
+				if(close == std::string::npos
+						|| glob.find('/', i) < close) {
+					AppendLiteral(regex, c);
+					break;
+				}
+				regex += '[';
+				size_t j = i + 1;
+				if(glob[j] == '!' || glob[j] == '^') {
+					regex += '^';
+					j++;
+				}
+				for(; j < close; j++) {
+					if(glob[j] == '\\' || glob[j] == '[')
+						regex += '\\';
+					regex += glob[j];
+				}
+				regex += ']';
+				i = close;
+			} break;
+			case '{': {
+				bool alternatives;
+				const size_t close = ClosingBrace(glob, i, alternatives);
+				long from, to;
+				if(close != std::string::npos && alternatives == false
+						&& ParseRange(glob.substr(i + 1, close - i - 1), from, to)) {
+					ranges.push_back(std::make_pair(from, to));
+					regex += "([+-]?[0-9]+)";
+					i = close;
+				} else if(close != std::string::npos && alternatives == true) {
+					braces.push_back(true);
+					regex += "(?:";
+				} else {
+					braces.push_back(false);
+					AppendLiteral(regex, c);
+				}
+			} break;
+			case '}':
+				if(!braces.empty() && braces.back() == true)
+					regex += ')';
+				else
+					AppendLiteral(regex, c);
+				if(!braces.empty())
+					braces.pop_back();
+			break;
+			case ',':
+				if(!braces.empty() && braces.back() == true)
+					regex += '|';
+				else
+					regex += c;
+			break;
+			default:
+				AppendLiteral(regex, c);
+			break;
+		}
+	}
+	return regex;
+}
+
+
+int
+ParseNumber(const std::string& text)
+{
+	char* end;
+	const long number = strtol(text.c_str(), &end, 10);
+	return end != text.c_str() && *end == '\0' && number > 0 ? number : -1;
+}
+
+
+int
+ParseBool(const std::string& text)
+{
+	if(text == "true")
+		return 1;
+	return text == "false" ? 0 : -1;
+}
+
+}
+
+
+BLocker EditorConfig::sLock("EditorConfig");
+BMessenger EditorConfig::sTarget;
+std::map<std::string, EditorConfig::FilePtr> EditorConfig::sFiles;
+std::map<node_ref, std::string> EditorConfig::sDirectories;
+std::map<node_ref, std::string> EditorConfig::sConfigFiles;
+
+
+/* static */ void
+EditorConfig::Start(const BMessenger& target)
+{
+	BAutolock lock(sLock);
+	sTarget = target;
+}
+
+
+/* static */ void
+EditorConfig::Stop()
+{
+	BAutolock lock(sLock);
+	stop_watching(sTarget);
+	sTarget = BMessenger();
+	sFiles.clear();
+	sDirectories.clear();
+	sConfigFiles.clear();
+}
+
+
+// Files from the document's directory up to the root or one which says it
+// is the root are applied, the closest last.
+/* static */ EditorConfig::Settings
+EditorConfig::Resolve(const char* path)
+{
+	const std::string document(path);
+	std::vector<FilePtr> files;
+	{
+		BAutolock lock(sLock);
+		std::string directory(document);
+		size_t slash;
+		while((slash = directory.rfind('/')) != std::string::npos) {
+			directory.erase(slash);
+			files.push_back(_File(directory));
+			if(files.back()->root == true)
+				break;
+		}
+	}
+
+	std::map<std::string, std::string> properties;
+	for(auto file = files.rbegin(); file != files.rend(); ++file) {
+		for(const Section& section : (*file)->sections) {
+			std::smatch match;
+			if(std::regex_match(document, match, section.pattern) == false)
+				continue;
+			bool inRange = true;
+			for(size_t i = 0; inRange == true && i < section.ranges.size(); i++) {
+				const long number = strtol(match[i + 1].str().c_str(), NULL, 10);
+				inRange = number >= section.ranges[i].first
+					&& number <= section.ranges[i].second;
+			}
+			if(inRange == false)
+				continue;
+			for(const auto& property : section.properties) {
+				if(property.second == "unset")
+					properties.erase(property.first);
+				else
+					properties[property.first] = property.second;
+			}
+		}
+	}
+
+	Settings settings;
+	for(const auto& property : properties) {
+		const std::string& key = property.first;
+		const std::string& value = property.second;
+		if(key == "indent_style") {
+			if(value == "tab" || value == "space")
+				settings.useTabs = value == "tab";
+		} else if(key == "indent_size") {
+			settings.indentSize = value == "tab" ? 0 : ParseNumber(value);
+		} else if(key == "tab_width") {
+			settings.tabWidth = ParseNumber(value);
+		} else if(key == "end_of_line") {
+			if(value == "lf")
+				settings.eolMode = SC_EOL_LF;
+			else if(value == "crlf")
+				settings.eolMode = SC_EOL_CRLF;
+			else if(value == "cr")
+				settings.eolMode = SC_EOL_CR;
+		} else if(key == "charset") {
+			settings.charset = value;
+		} else if(key == "trim_trailing_whitespace") {
+			settings.trimTrailingWhitespace = ParseBool(value);
+		} else if(key == "insert_final_newline") {
+			settings.insertFinalNewline = ParseBool(value);
+		}
+	}
+	// defaults the specification gives for one another
+	if(settings.useTabs == 1 && settings.indentSize == -1)
+		settings.indentSize = 0;
+	if(settings.indentSize > 0 && settings.tabWidth == -1)
+		settings.tabWidth = settings.indentSize;
+	return settings;
+}
+
+
+/* static */ bool
+EditorConfig::Changed(BMessage* message)
+{
+	BAutolock lock(sLock);
+	node_ref nref;
+	nref.device = message->GetInt32("device", -1);
+	const int32 opcode = message->GetInt32("opcode", 0);
+	switch(opcode) {
+		case B_STAT_CHANGED: {
+			nref.node = message->GetInt64("node", -1);
+			auto file = sConfigFiles.find(nref);
+			return file != sConfigFiles.end() && _Invalidate(file->second);
+		}
+		case B_ENTRY_CREATED:
+		case B_ENTRY_REMOVED: {
+			nref.node = message->GetInt64("directory", -1);
+			auto directory = sDirectories.find(nref);
+			if(directory == sDirectories.end())
+				return false;
+			const char* name = message->GetString("name", NULL);
+			if(name != NULL && strcmp(name, kFileName) != 0)
+				return false;
+			// removed entries may come without a name, the node tells
+			nref.node = message->GetInt64("node", -1);
+			if(name == NULL && sConfigFiles.count(nref) == 0)
+				return false;
+			return _Invalidate(directory->second);
+		}
+		case B_ENTRY_MOVED: {
+			bool changed = false;
+			for(const char* field : { "from directory", "to directory" }) {
+				nref.node = message->GetInt64(field, -1);
+				auto directory = sDirectories.find(nref);
+				if(directory != sDirectories.end()
+						&& (strcmp(message->GetString("name", ""), kFileName) == 0
+						|| strcmp(message->GetString("from name", ""), kFileName) == 0))
+					changed = _Invalidate(directory->second) || changed;
+			}
+			return changed;
+		}
+	}
+	return false;
+}
+
+
+// Directory without a trailing slash, the root is an empty string.
+/* static */ EditorConfig::FilePtr
+EditorConfig::_File(const std::string& directory)
+{
+	auto cached = sFiles.find(directory);
+	if(cached != sFiles.end())
+		return cached->second;
+
+	const std::string path = directory.empty() ? "/" : directory;
+	BNode node(path.c_str());
+	node_ref nref;
+	if(sTarget.IsValid() && node.GetNodeRef(&nref) == B_OK
+			&& sDirectories.count(nref) == 0
+			&& watch_node(&nref, B_WATCH_DIRECTORY, sTarget) == B_OK)
+		sDirectories[nref] = directory;
+
+	std::shared_ptr<File> parsed;
+	BFile file((directory + "/" + kFileName).c_str(), B_READ_ONLY);
+	off_t size;
+	if(file.InitCheck() == B_OK && file.GetSize(&size) == B_OK
+			&& size <= kMaxFileSize) {
+		std::string text(size, '\0');
+		if(file.Read(&text[0], size) == size)
+			parsed = _Parse(directory, text);
+	}
+	if(!parsed) {
+		// kept as well, most directories have none
+		parsed = std::make_shared<File>();
+	} else if(sTarget.IsValid() && file.GetNodeRef(&parsed->node) == B_OK
+			&& watch_node(&parsed->node, B_WATCH_STAT, sTarget) == B_OK)
+		sConfigFiles[parsed->node] = directory;
+	else
+		parsed->node.node = -1;
+	return sFiles[directory] = parsed;
+}
+
+
+/* static */ std::shared_ptr<EditorConfig::File>
+EditorConfig::_Parse(const std::string& directory, const std::string& text)
+{
+	std::shared_ptr<File> file = std::make_shared<File>();
+	bool inSection = false;
+	bool validSection = false;
+	size_t start = 0;
+	while(start < text.size()) {
+		size_t end = text.find('\n', start);
+		if(end == std::string::npos)
+			end = text.size();
+		const std::string line = Trim(text.substr(start, end - start));
+		start = end + 1;
+		if(line.empty() || line[0] == '#' || line[0] == ';')
+			continue;
+		if(line[0] == '[' && line[line.size() - 1] == ']') {
+			// globs without a slash match file names in any subdirectory
+			std::string glob = line.substr(1, line.size() - 2);
+			if(glob.find('/') == std::string::npos)
+				glob = "/**/" + glob;
+			else if(glob[0] != '/')
+				glob = "/" + glob;
+			std::string prefix;
+			for(char c : directory)
+				AppendLiteral(prefix, c);
+			Section section;
+			inSection = true;
+			try {
+				section.pattern = std::regex(prefix
+					+ GlobToRegex(glob, section.ranges),
+					std::regex::ECMAScript | std::regex::optimize);
+				validSection = true;
+				file->sections.push_back(section);
+			} catch(const std::regex_error&) {
+				validSection = false;
+			}
+			continue;
+		}
+		const size_t equals = line.find('=');
+		if(equals == std::string::npos)
+			continue;
+		const std::string key = ToLower(Trim(line.substr(0, equals)));
+		const std::string value = ToLower(Trim(line.substr(equals + 1)));
+		if(inSection == false) {
+			if(key == "root")
+				file->root = value == "true";
+		} else if(validSection == true)
+			file->sections.back().properties.push_back(std::make_pair(key, value));
+	}
+	return file;
+}
+
+
+// Drops the cached file, it is parsed again when needed.
+/* static */ bool
+EditorConfig::_Invalidate(const std::string& directory)
+{
+	auto cached = sFiles.find(directory);
+	if(cached == sFiles.end())
+		return false;
+	const node_ref nref = cached->second->node;
+	if(nref.node != -1) {
+		watch_node(&nref, B_STOP_WATCHING, sTarget);
+		sConfigFiles.erase(nref);
+	}
+	sFiles.erase(cached);
+	return true;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef EDITORCONFIG_H
+#define EDITORCONFIG_H
+
+
+#include <Locker.h>
+#include <Messenger.h>
+#include <Node.h>
+
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+class BMessage;
+
+
+enum {
+	EDITORCONFIG_CHANGED	= 'ecch'
+};
+
+
+/*
+ * Settings from .editorconfig files for documents. Every directory looked
+ * at is parsed once, with globs compiled, and kept along with the fact that
+ * it has no .editorconfig. Directories and files are node monitored with
+ * the target, which passes the messages to Changed() to drop what was
+ * edited and tells windows to resolve their settings again.
+ */
+class EditorConfig {
+public:
+	// -1 where not set.
+	struct Settings {
+					Settings() : useTabs(-1), indentSize(-1), tabWidth(-1),
+						eolMode(-1), trimTrailingWhitespace(-1),
+						insertFinalNewline(-1) {}
+
+		int			useTabs;
+		int			indentSize;
+			// 0 to follow the tab width
+		int			tabWidth;
+		int			eolMode;
+			// SC_EOL_*
+		std::string	charset;
+		int			trimTrailingWhitespace;
+		int			insertFinalNewline;
+	};
+
+	static	void					Start(const BMessenger& target);
+	static	void					Stop();
+
+	static	Settings				Resolve(const char* path);
+	// Returns true if a cached .editorconfig was dropped.
+	static	bool					Changed(BMessage* message);
+
+private:
+	struct Section {
+		std::regex									pattern;
+			// matches whole paths
+		std::vector<std::pair<long, long>>			ranges;
+			// of numbers captured by the pattern
+		std::vector<std::pair<std::string, std::string>>	properties;
+	};
+	struct File {
+								File() : root(false) {}
+
+		bool					root;
+		node_ref				node;
+			// node.node is -1 if the directory has no .editorconfig
+		std::vector<Section>	sections;
+	};
+	typedef std::shared_ptr<const File>	FilePtr;
+
+	static	FilePtr					_File(const std::string& directory);
+	static	std::shared_ptr<File>	_Parse(const std::string& directory,
+										const std::string& text);
+	static	bool					_Invalidate(const std::string& directory);
+
+	static	BLocker					sLock;
+	static	BMessenger				sTarget;
+	static	std::map<std::string, FilePtr>	sFiles;
+		// by directory
+	static	std::map<node_ref, std::string>	sDirectories;
+		// watched for .editorconfig being created or removed
+	static	std::map<node_ref, std::string>	sConfigFiles;
+		// and their directories
+};
+
+
+#endif // EDITORCONFIG_H
@@ -14,6 +14,7 @@
 #include <GroupLayout.h>
 #include <LayoutBuilder.h>
 #include <MenuBar.h>
+#include <MessageRunner.h>
 #include <MimeType.h>
 #include <Node.h>
 #include <NodeInfo.h>
@@ -21,17 +22,34 @@
 #include <ObjectList.h>
 #include <Path.h>
 #include <Roster.h>
+#include <ScrollView.h>
+#include <SplitView.h>
 #include <String.h>
+#include <StringView.h>
+#include <UTF8.h>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <yaml.h>
 
 #include "AppPreferencesWindow.h"
+#include "DataLoader.h"
+#include "DataMonitor.h"
 #include "Editor.h"
+#include "EditorConfig.h"
+#include "FilterLinesWindow.h"
 #include "FindWindow.h"
 #include "GoToLineWindow.h"
+#include "GoToSymbolWindow.h"
+#include "IdentifierIndex.h"
+#include "IndentationDetector.h"
 #include "Languages.h"
+#include "LineFilter.h"
+#include "OutlineView.h"
 #include "Preferences.h"
+#include "Searcher.h"
+#include "SearchResultsView.h"
 #include "Styler.h"
 
 
@@ -39,6 +57,70 @@
 #define B_TRANSLATION_CONTEXT "EditorWindow"
 
 
+namespace {
+
+const bigtime_t kOutlineUpdateDelay = 300000;
+const bigtime_t kIdentifiersUpdateDelay = 2000000;
+	// after typing stops
+const char kUTF8BOM[] = "\xEF\xBB\xBF";
+
+
+// Converts text of a file in charset to UTF-8. Returns false if it already
+// is that.
+bool
+DecodeText(const char* data, size_t length, const std::string& charset,
+	std::string& text)
+{
+	if(charset == "utf-8-bom") {
+		if(length < 3 || memcmp(data, kUTF8BOM, 3) != 0)
+			return false;
+		text.assign(data + 3, length - 3);
+		return true;
+	}
+	if(charset == "latin1") {
+		text.resize(length * 2);
+		int32 sourceLength = length;
+		int32 textLength = text.size();
+		int32 state = 0;
+		if(convert_to_utf8(B_ISO1_CONVERSION, data, &sourceLength, &text[0],
+				&textLength, &state) != B_OK)
+			return false;
+		text.resize(textLength);
+		return true;
+	}
+	// UTF-16 is not supported, the file is shown as it is
+	return false;
+}
+
+
+// Reverse of DecodeText().
+bool
+EncodeText(const char* text, size_t length, const std::string& charset,
+	std::string& data)
+{
+	if(charset == "utf-8-bom") {
+		if(length >= 3 && memcmp(text, kUTF8BOM, 3) == 0)
+			return false;
+		data.assign(kUTF8BOM).append(text, length);
+		return true;
+	}
+	if(charset == "latin1") {
+		data.resize(length);
+		int32 textLength = length;
+		int32 dataLength = data.size();
+		int32 state = 0;
+		if(convert_from_utf8(B_ISO1_CONVERSION, text, &textLength, &data[0],
+				&dataLength, &state) != B_OK)
+			return false;
+		data.resize(dataLength);
+		return true;
+	}
+	return false;
+}
+
+}
+
+
 Preferences* EditorWindow::fPreferences = NULL;
 
 
@@ -55,7 +137,17 @@ EditorWindow::EditorWindow()
 	fSearchLastResultStart = -1;
 	fSearchLastResultEnd = -1;
 
+	fLanguageMenuVersion = 0;
+	fLanguageMenuCompact = false;
+	fIdentifiersVersion = 0;
+
 	fGoToLineWindow = NULL;
+	fGoToSymbolWindow = NULL;
+	fOutlineUpdatePending = false;
+	fIdentifiersUpdatePending = false;
+	fLastTextChange = 0;
+	fFilterLinesWindow = NULL;
+	fLineFilter = NULL;
 	fOpenedFilePath = NULL;
 	fOpenedFileMimeType.SetTo("text/plain");
 
@@ -99,42 +191,78 @@ EditorWindow::EditorWindow()
 				.AddItem(B_TRANSLATE("Show white space"), MAINMENU_VIEW_SPECIAL_WHITESPACE)
 				.AddItem(B_TRANSLATE("Show EOLs"), MAINMENU_VIEW_SPECIAL_EOL)
 			.End()
+			.AddItem(B_TRANSLATE("Search results"), MAINMENU_VIEW_SEARCHRESULTS)
+			.AddItem(B_TRANSLATE("Outline"), MAINMENU_VIEW_OUTLINE)
+			.AddItem(B_TRANSLATE("Split view"), MAINMENU_VIEW_SPLIT)
 		.End()
 		.AddMenu(B_TRANSLATE("Search"))
 			.AddItem(B_TRANSLATE("Find/Replace" B_UTF8_ELLIPSIS), MAINMENU_SEARCH_FINDREPLACE, 'F')
 			.AddSeparator()
 			.AddItem(B_TRANSLATE("Go to line" B_UTF8_ELLIPSIS), MAINMENU_SEARCH_GOTOLINE, 'G')
+			.AddItem(B_TRANSLATE("Go to symbol" B_UTF8_ELLIPSIS), MAINMENU_SEARCH_GOTOSYMBOL, 'G', B_SHIFT_KEY)
+			.AddItem(B_TRANSLATE("Go to matching tag"), MAINMENU_SEARCH_MATCHINGTAG, 'M')
+			.AddItem(B_TRANSLATE("Go to enclosing bracket"), MAINMENU_SEARCH_ENCLOSINGBRACKET, 'M', B_SHIFT_KEY)
+			.AddSeparator()
+			.AddItem(B_TRANSLATE("Next hunk"), MAINMENU_SEARCH_NEXTHUNK, ']')
+			.AddItem(B_TRANSLATE("Previous hunk"), MAINMENU_SEARCH_PREVHUNK, '[')
+			.AddItem(B_TRANSLATE("Next file"), MAINMENU_SEARCH_NEXTFILE, ']', B_SHIFT_KEY)
+			.AddItem(B_TRANSLATE("Previous file"), MAINMENU_SEARCH_PREVFILE, '[', B_SHIFT_KEY)
+			.AddSeparator()
+			.AddItem(B_TRANSLATE("Filter lines" B_UTF8_ELLIPSIS), MAINMENU_SEARCH_FILTERLINES)
+			.AddItem(B_TRANSLATE("Remove last filter"), MAINMENU_SEARCH_REMOVEFILTER)
+			.AddItem(B_TRANSLATE("Show all lines"), MAINMENU_SEARCH_SHOWALLLINES)
 		.End()
 		.AddMenu(B_TRANSLATE("Language"))
 			.AddItem("Dummy", MAINMENU_LANGUAGE)
 		.End()
 		.AddMenu(B_TRANSLATE("Help"))
+			.AddItem(B_TRANSLATE("Performance counters" B_UTF8_ELLIPSIS), MAINMENU_HELP_COUNTERS)
+			.AddSeparator()
 			.AddItem(B_TRANSLATE("About" B_UTF8_ELLIPSIS), B_ABOUT_REQUESTED)
 		.End();
 
 	fLanguageMenu = fMainMenu->FindItem(MAINMENU_LANGUAGE)->Menu();
-	_PopulateLanguageMenu(fLanguageMenu);
+		// populated when menus are first opened
 
 	fEditor = new Editor();
 	fEditor->SetPreferences(fPreferences);
+	fSecondEditor = NULL;
+
+	fSearchResultsView = new SearchResultsView(fEditor);
+	fSearchResultsLabel = new BStringView("searchResultsLabel", "");
+	BScrollView* searchResultsScroll = new BScrollView("searchResultsScroll",
+		fSearchResultsView, 0, false, true);
+	fOutlineView = new OutlineView();
+	BScrollView* outlineScroll = new BScrollView("outlineScroll",
+		fOutlineView, 0, false, true);
 
 	BGroupLayout *layout = new BGroupLayout(B_VERTICAL, 0);
 	SetLayout(layout);
-	layout->AddView(fMainMenu);
-	layout->AddView(fEditor);
+	BLayoutBuilder::Group<>(layout)
+		.Add(fMainMenu)
+		.AddSplit(B_HORIZONTAL, 0)
+			.GetSplitView(&fOutlineSplitView)
+			.Add(outlineScroll, 1)
+			.AddSplit(B_VERTICAL, 0, 4)
+				.GetSplitView(&fSplitView)
+				.AddSplit(B_VERTICAL, 0, 3)
+					.GetSplitView(&fEditorSplitView)
+					.Add(fEditor)
+				.End()
+				.AddGroup(B_VERTICAL, 0, 1)
+					.Add(fSearchResultsLabel)
+					.Add(searchResultsScroll)
+				.End()
+			.End()
+		.End();
 	layout->SetInsets(0, 0, -1, -1);
+	fSplitView->SetItemCollapsed(1, true);
+		// search results are shown when there are any
+	fOutlineSplitView->SetItemCollapsed(0, true);
 	SetKeyMenuBar(fMainMenu);
 
 	_SyncWithPreferences();
-
-	fEditor->SendMessage(SCI_SETADDITIONALSELECTIONTYPING, true, 0);
-	fEditor->SendMessage(SCI_SETIMEINTERACTION, SC_IME_INLINE, 0);
-
-	fEditor->SendMessage(SCI_USEPOPUP, 0, 0);
-
-	Styler::ApplyGlobal(fEditor, fPreferences->fStyle);
-	fEditor->SendMessage(SCI_STYLESETFORE, 253, 0xFF00000);
-	fEditor->SendMessage(SCI_STYLESETFORE, 254, 0x00000FF);
+	_SetUpView(fEditor);
 
 	RefreshTitle();
 }
@@ -150,6 +278,8 @@ EditorWindow::New()
 void
 EditorWindow::OpenFile(entry_ref* ref)
 {
+	_StopFilter();
+	fFilters.clear();
 	fEditor->SendMessage(SCI_SETREADONLY, false, 0);
 		// let us load new file
 	if(fOpenedFilePath != NULL) {
@@ -181,19 +311,28 @@ EditorWindow::OpenFile(entry_ref* ref)
 		alert->Go();
 	}
 
+	BPath path(&entry);
+	fEditorConfig = EditorConfig::Resolve(path.Path());
+
 	BFile file(&entry, B_READ_ONLY);
 	off_t size;
 	file.GetSize(&size);
 	char* buffer = new char[size + 1];
 	file.Read(buffer, size);
 	buffer[size] = 0;
-	fEditor->SetText(buffer);
+	std::string decoded;
+	if(DecodeText(buffer, size, fEditorConfig.charset, decoded) == true)
+		fEditor->SetText(decoded.c_str());
+	else
+		fEditor->SetText(buffer);
 	fEditor->SendMessage(SCI_SETSAVEPOINT, 0, 0);
 	fEditor->SendMessage(SCI_EMPTYUNDOBUFFER, 0, 0);
 	delete []buffer;
 
 	fEditor->SendMessage(SCI_GOTOPOS, caretPos, 0);
 	fOpenedFileMimeType.SetTo(mimeType);
+	fDetectedIndentation = IndentationDetector::Detect(fEditor);
+	_ApplyDocumentSettings();
 
 	char name[B_FILE_NAME_LENGTH];
 	entry.GetName(name);
@@ -207,6 +346,7 @@ EditorWindow::OpenFile(entry_ref* ref)
 		fOpenedFilePath = new BPath(&entry);
 	else
 		fOpenedFilePath->SetTo(&entry);
+	_IndexIdentifiers();
 	RefreshTitle();
 }
 
@@ -229,6 +369,9 @@ EditorWindow::RefreshTitle()
 	if(fReadOnly) {
 		title << " " << B_TRANSLATE("[read-only]");
 	}
+	if(!fLanguageProfile.empty()) {
+		title << " [" << fLanguageProfile.c_str() << "]";
+	}
 	SetTitle(title);
 }
 
@@ -236,6 +379,16 @@ EditorWindow::RefreshTitle()
 void
 EditorWindow::SaveFile(entry_ref* ref)
 {
+	if(fLineFilter != NULL) {
+		// the filter reads the text, which must not change until it is done
+		BAlert* alert = new BAlert(B_TRANSLATE("Save"),
+			B_TRANSLATE("The file cannot be saved while lines are being "
+				"filtered. Save it again when the filter is done."),
+			B_TRANSLATE("OK"), nullptr, nullptr, B_WIDTH_AS_USUAL, B_WARNING_ALERT);
+		alert->SetShortcut(0, B_ESCAPE);
+		alert->Go(nullptr);
+		return;
+	}
 	// TODO error checking
 	BFile file(ref, B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
 	if(file.InitCheck() == B_PERMISSION_DENIED) {
@@ -247,10 +400,18 @@ EditorWindow::SaveFile(entry_ref* ref)
 	}
 	BNode node(ref);
 	_MonitorFile(&node, false);
+	BPath path(ref);
+	fEditorConfig = EditorConfig::Resolve(path.Path());
+	_ApplyDocumentSettings();
+	_PrepareForSave();
 	int length = fEditor->TextLength() + 1;
 	char* buffer = new char[length];
 	fEditor->GetText(0, length, buffer);
-	file.Write(buffer, length - 1);
+	std::string encoded;
+	if(EncodeText(buffer, length - 1, fEditorConfig.charset, encoded) == true)
+		file.Write(encoded.data(), encoded.size());
+	else
+		file.Write(buffer, length - 1);
 	fEditor->SendMessage(SCI_SETSAVEPOINT, 0, 0);
 	delete []buffer;
 
@@ -262,9 +423,12 @@ EditorWindow::SaveFile(entry_ref* ref)
 	nodeInfo.SetType(mimeType);
 
 	if(fOpenedFilePath != NULL) {
+		if(strcmp(fOpenedFilePath->Path(), path.Path()) != 0)
+			IdentifierIndex::CloseDocument(fOpenedFilePath->Path());
 		delete fOpenedFilePath;
 	}
-	fOpenedFilePath = new BPath(ref);
+	fOpenedFilePath = new BPath(path);
+	_IndexIdentifiers();
 	RefreshTitle();
 }
 
@@ -291,12 +455,22 @@ EditorWindow::QuitRequested()
 			int32 caretPos = fEditor->SendMessage(SCI_GETCURRENTPOS, 0, 0);
 			BNode node(fOpenedFilePath->Path());
 			node.WriteAttr("be:caret_position", B_INT32_TYPE, 0, &caretPos, 4);
+			IdentifierIndex::CloseDocument(fOpenedFilePath->Path());
 		}
 
 		if(fGoToLineWindow != NULL) {
 			fGoToLineWindow->LockLooper();
 			fGoToLineWindow->Quit();
 		}
+		if(fGoToSymbolWindow != NULL) {
+			fGoToSymbolWindow->LockLooper();
+			fGoToSymbolWindow->Quit();
+		}
+		if(fFilterLinesWindow != NULL) {
+			fFilterLinesWindow->LockLooper();
+			fFilterLinesWindow->Quit();
+		}
+		_StopFilter();
 		
 		delete fOpenPanel;
 		delete fSavePanel;
@@ -374,18 +548,100 @@ EditorWindow::MessageReceived(BMessage* message)
 			}
 			fGoToLineWindow->ShowCentered(Frame());
 		} break;
+		case MAINMENU_SEARCH_GOTOSYMBOL: {
+			if(fGoToSymbolWindow == NULL) {
+				fGoToSymbolWindow = new GoToSymbolWindow(this);
+			}
+			fGoToSymbolWindow->ShowCentered(Frame(), fEditor->Symbols().Symbols());
+		} break;
+		case MAINMENU_SEARCH_MATCHINGTAG: {
+			_FocusedEditor()->GoToMatchingTag();
+		} break;
+		case MAINMENU_SEARCH_ENCLOSINGBRACKET: {
+			_FocusedEditor()->GoToEnclosingBracket();
+		} break;
+		case MAINMENU_SEARCH_NEXTHUNK:
+		case MAINMENU_SEARCH_PREVHUNK:
+		case MAINMENU_SEARCH_NEXTFILE:
+		case MAINMENU_SEARCH_PREVFILE: {
+			const bool hunk = message->what == MAINMENU_SEARCH_NEXTHUNK
+				|| message->what == MAINMENU_SEARCH_PREVHUNK;
+			const bool forward = message->what == MAINMENU_SEARCH_NEXTHUNK
+				|| message->what == MAINMENU_SEARCH_NEXTFILE;
+			Editor* editor = _FocusedEditor();
+			const int32 line = editor->SendMessage(SCI_LINEFROMPOSITION,
+				editor->SendMessage(SCI_GETCURRENTPOS, 0, 0), 0);
+			const SymbolIndex::Symbol* symbol = editor->Symbols().Next(line,
+				hunk ? SymbolIndex::HUNK : SymbolIndex::FILE, forward);
+			if(symbol != NULL) {
+				BMessage go(GTLW_GO);
+				go.AddInt32("line", symbol->line + 1);
+				PostMessage(&go);
+			}
+		} break;
+		case MAINMENU_SEARCH_FILTERLINES: {
+			if(fFilterLinesWindow == NULL) {
+				fFilterLinesWindow = new FilterLinesWindow(this);
+			}
+			fFilterLinesWindow->ShowCentered(Frame());
+		} break;
+		case MAINMENU_SEARCH_REMOVEFILTER: {
+			if(fFilters.empty() == false) {
+				fFilters.pop_back();
+				_ApplyFilters();
+			}
+		} break;
+		case MAINMENU_SEARCH_SHOWALLLINES: {
+			_StopFilter();
+			fFilters.clear();
+			_ApplyFilters();
+		} break;
 		case MAINMENU_VIEW_SPECIAL_WHITESPACE: {
 			fPreferences->fWhiteSpaceVisible = !fPreferences->fWhiteSpaceVisible;
 			fMainMenu->FindItem(message->what)->SetMarked(fPreferences->fWhiteSpaceVisible);
-			fEditor->SendMessage(SCI_SETVIEWWS, fPreferences->fWhiteSpaceVisible, 0);
+			_ApplyViewPreferences(fEditor);
+			if(fSecondEditor != NULL)
+				_ApplyViewPreferences(fSecondEditor);
 		} break;
 		case MAINMENU_VIEW_SPECIAL_EOL: {
 			fPreferences->fEOLVisible = !fPreferences->fEOLVisible;
 			fMainMenu->FindItem(message->what)->SetMarked(fPreferences->fEOLVisible);
-			fEditor->SendMessage(SCI_SETVIEWEOL, fPreferences->fEOLVisible, 0);
+			_ApplyViewPreferences(fEditor);
+			if(fSecondEditor != NULL)
+				_ApplyViewPreferences(fSecondEditor);
+		} break;
+		case MAINMENU_VIEW_SEARCHRESULTS: {
+			_ShowSearchResults(fSplitView->IsItemCollapsed(1));
+		} break;
+		case MAINMENU_VIEW_OUTLINE: {
+			_ShowOutline(fOutlineSplitView->IsItemCollapsed(0));
+		} break;
+		case MAINMENU_VIEW_SPLIT: {
+			_ShowSecondView(message->GetBool("show", fSecondEditor == NULL));
+		} break;
+		case EDITOR_SYMBOLS_CHANGED: {
+			_ScheduleOutlineUpdate();
+		} break;
+		case EDITOR_TEXT_CHANGED: {
+			fLastTextChange = system_time();
+			_ScheduleIdentifiersUpdate(kIdentifiersUpdateDelay);
+		} break;
+		case IDENTIFIERS_UPDATE: {
+			fIdentifiersUpdatePending = false;
+			const bigtime_t idle = system_time() - fLastTextChange;
+			if(idle < kIdentifiersUpdateDelay)
+				_ScheduleIdentifiersUpdate(kIdentifiersUpdateDelay - idle);
+			else
+				_IndexIdentifiers();
+		} break;
+		case OUTLINE_UPDATE: {
+			fOutlineUpdatePending = false;
+			if(fOutlineSplitView->IsItemCollapsed(0) == false)
+				fOutlineView->SetSymbols(fEditor->Symbols().Symbols());
 		} break;
 		case MAINMENU_LANGUAGE: {
 			_SetLanguage(message->GetString("lang", "text"));
+			RefreshTitle();
 		} break;
 		case B_SAVE_REQUESTED: {
 			entry_ref ref;
@@ -400,23 +656,23 @@ EditorWindow::MessageReceived(BMessage* message)
 			}
 		} break;
 		case B_CUT: {
-			fEditor->SendMessage(SCI_CUT, 0, 0);
+			_FocusedEditor()->SendMessage(SCI_CUT, 0, 0);
 		} break;
 		case B_COPY: {
-			fEditor->SendMessage(SCI_COPY, 0, 0);
+			_FocusedEditor()->SendMessage(SCI_COPY, 0, 0);
 		} break;
 		case B_PASTE: {
-			fEditor->SendMessage(SCI_PASTE, 0, 0);
+			_FocusedEditor()->SendMessage(SCI_PASTE, 0, 0);
 		} break;
 		case B_SELECT_ALL: {
-			fEditor->SendMessage(SCI_SELECTALL, 0, 0);
+			_FocusedEditor()->SendMessage(SCI_SELECTALL, 0, 0);
 		} break;
 		case B_UNDO: {
-			fEditor->SendMessage(SCI_UNDO, 0, 0);
+			_FocusedEditor()->SendMessage(SCI_UNDO, 0, 0);
 			// TODO: disable menuitem
 		} break;
 		case B_REDO: {
-			fEditor->SendMessage(SCI_REDO, 0, 0);
+			_FocusedEditor()->SendMessage(SCI_REDO, 0, 0);
 		} break;
 		case EDITOR_SAVEPOINT_LEFT: {
 			fModified = true;
@@ -429,6 +685,9 @@ EditorWindow::MessageReceived(BMessage* message)
 		case B_ABOUT_REQUESTED:
 			be_app->PostMessage(message);
 		break;
+		case MAINMENU_HELP_COUNTERS: {
+			_ShowCounters();
+		} break;
 		case B_REFS_RECEIVED: {
 			entry_ref ref;
 			if(message->FindRef("refs", &ref) == B_OK) {
@@ -461,7 +720,8 @@ EditorWindow::MessageReceived(BMessage* message)
 
 				bool canWrite = _CheckPermissions(&entry, S_IWUSR | S_IWGRP | S_IWOTH);
 				fReadOnly = !canWrite;
-				fEditor->SendMessage(SCI_SETREADONLY, fReadOnly, 0);
+				fEditor->SendMessage(SCI_SETREADONLY,
+					fReadOnly || fLineFilter != NULL, 0);
 				RefreshTitle();
 				// Notification about this is sent when window is activated
 			} else if(opcode == B_ENTRY_MOVED) {
@@ -473,6 +733,7 @@ EditorWindow::MessageReceived(BMessage* message)
 				ref.set_name(name);
 				_ReloadFile(&ref);
 			} else if(opcode == B_ENTRY_REMOVED) {
+				IdentifierIndex::CloseDocument(fOpenedFilePath->Path());
 				delete fOpenedFilePath;
 				fOpenedFilePath = NULL;
 				fModified = true;
@@ -482,10 +743,46 @@ EditorWindow::MessageReceived(BMessage* message)
 		case GTLW_GO: {
 			int32 line;
 			if(message->FindInt32("line", &line) == B_OK) {
-				fEditor->SendMessage(SCI_ENSUREVISIBLEENFORCEPOLICY, line - 1, 0);
-				fEditor->SendMessage(SCI_GOTOLINE, line - 1, 0);
+				Editor* editor = _FocusedEditor();
+				editor->SendMessage(SCI_ENSUREVISIBLEENFORCEPOLICY, line - 1, 0);
+				editor->SendMessage(SCI_GOTOLINE, line - 1, 0);
+			}
+		} break;
+		case DATAMONITOR_CHANGED: {
+			_ReloadData(message->GetString("name", ""));
+		} break;
+		case EDITORCONFIG_CHANGED: {
+			if(fOpenedFilePath != NULL) {
+				fEditorConfig = EditorConfig::Resolve(fOpenedFilePath->Path());
+				_ApplyDocumentSettings();
 			}
 		} break;
+		case IDENTIFIERINDEX_CHANGED: {
+			if(IdentifierIndex::Version() != fIdentifiersVersion
+					&& _UpdateIdentifiers() == true)
+				fEditor->UpdateStyling();
+		} break;
+		case FLW_FILTER: {
+			_StartFilter(message);
+		} break;
+		case LINEFILTER_FINISHED: {
+			_FinishFilter(message);
+		} break;
+		case FINDWINDOW_FINDALL: {
+			_FindAll(message);
+		} break;
+		case SEARCHRESULTS_CLEAR: {
+			fSearchResultsView->Clear();
+			_ShowSearchResults(true);
+			_UpdateSearchResultsLabel(false);
+		} break;
+		case SEARCHRESULTS_ADD: {
+			fSearchResultsView->AddResults(message);
+			_UpdateSearchResultsLabel(false);
+		} break;
+		case SEARCHRESULTS_DONE: {
+			_UpdateSearchResultsLabel(true);
+		} break;
 		case FINDWINDOW_FIND:
 		case FINDWINDOW_REPLACE:
 		case FINDWINDOW_REPLACEALL: {
@@ -504,6 +801,21 @@ EditorWindow::MessageReceived(BMessage* message)
 }
 
 
+void
+EditorWindow::MenusBeginning()
+{
+	if(fLanguageMenuVersion != Languages::CatalogVersion()
+			|| fLanguageMenuCompact != fPreferences->fCompactLangMenu)
+		_PopulateLanguageMenu(fLanguageMenu);
+	fMainMenu->FindItem(MAINMENU_SEARCH_MATCHINGTAG)->SetEnabled(
+		fEditor->Tags().IsEnabled());
+	for(uint32 what : { MAINMENU_SEARCH_NEXTHUNK, MAINMENU_SEARCH_PREVHUNK,
+			MAINMENU_SEARCH_NEXTFILE, MAINMENU_SEARCH_PREVFILE })
+		fMainMenu->FindItem(what)->SetEnabled(fCurrentLanguage == "diff");
+	BWindow::MenusBeginning();
+}
+
+
 void
 EditorWindow::WindowActivated(bool active)
 {
@@ -550,6 +862,13 @@ EditorWindow::OpenedFilePath()
 }
 
 
+bool
+EditorWindow::IsFileOpened(const char* path)
+{
+	return fOpenedFilePath != nullptr && strcmp(fOpenedFilePath->Path(), path) == 0;
+}
+
+
 /* static */ void
 EditorWindow::SetPreferences(Preferences* preferences)
 {
@@ -586,20 +905,39 @@ EditorWindow::_FindReplace(BMessage* message)
 	bool matchWord = message->GetBool("matchWord");
 	bool wrapAround = message->GetBool("wrapAround");
 	bool backwards = message->GetBool("backwards");
+	bool regex = message->GetBool("regex");
 	const char* findText = message->GetString("findText", "");
 	const char* replaceText = message->GetString("replaceText", "");
+	ScintillaDirect& direct = _FocusedEditor()->Direct();
+
+	// Document is read-only while lines are filtered, replacing would
+	// silently do nothing. Replace in files lands here too.
+	if(message->what != FINDWINDOW_FIND && fLineFilter != NULL) {
+		BAlert* alert = new BAlert(B_TRANSLATE("Replace"),
+			B_TRANSLATE("Lines are being filtered, so the document cannot be "
+				"changed. Nothing was replaced."),
+			B_TRANSLATE("OK"), nullptr, nullptr, B_WIDTH_AS_USUAL, B_WARNING_ALERT);
+		alert->SetShortcut(0, B_ESCAPE);
+		alert->Go(nullptr);
+		return;
+	}
 
-	int searchFlags = 0;
-	if(matchCase == true)
-		searchFlags |= SCFIND_MATCHCASE;
-	if(matchWord == true)
-		searchFlags |= SCFIND_WHOLEWORD;
-	fEditor->SendMessage(SCI_SETSEARCHFLAGS, searchFlags, 0);
+	const Searcher& searcher = _Searcher(message, replaceText);
+	if(searcher.IsValid() == false) {
+		if(regex == true && findText[0] != '\0') {
+			BAlert* alert = new BAlert(B_TRANSLATE("Searching finished"),
+				B_TRANSLATE("Regular expression is not valid."),
+				B_TRANSLATE("OK"), nullptr, nullptr, B_WIDTH_AS_USUAL, B_OFFSET_SPACING, B_STOP_ALERT);
+			alert->SetShortcut(0, B_ESCAPE);
+			alert->Go();
+		}
+		return;
+	}
 
 	if(message->what != FINDWINDOW_REPLACEALL) {
 		// Detect if user has changed cursor position
-		Sci_Position anchor = fEditor->SendMessage(SCI_GETANCHOR, 0, 0);
-		Sci_Position current = fEditor->SendMessage(SCI_GETCURRENTPOS, 0, 0);
+		Sci_Position anchor = direct.Anchor();
+		Sci_Position current = direct.CurrentPos();
 		if(anchor != fSearchLastResultStart || current != fSearchLastResultEnd) {
 			newSearch = true;
 		}
@@ -607,11 +945,11 @@ EditorWindow::_FindReplace(BMessage* message)
 		if(newSearch == true) {
 			if(inSelection == true) {
 				if(backwards == false) {
-					fSearchTargetStart = fEditor->SendMessage(SCI_GETSELECTIONSTART, 0, 0);
-					fSearchTargetEnd = fEditor->SendMessage(SCI_GETSELECTIONEND, 0, 0);
+					fSearchTargetStart = direct.SelectionStart();
+					fSearchTargetEnd = direct.SelectionEnd();
 				} else {
-					fSearchTargetStart = fEditor->SendMessage(SCI_GETSELECTIONEND, 0, 0);
-					fSearchTargetEnd = fEditor->SendMessage(SCI_GETSELECTIONSTART, 0, 0);
+					fSearchTargetStart = direct.SelectionEnd();
+					fSearchTargetEnd = direct.SelectionStart();
 				}
 			} else {
 				if(backwards == true) {
@@ -619,20 +957,25 @@ EditorWindow::_FindReplace(BMessage* message)
 					fSearchTargetEnd = 0;
 				} else {
 					fSearchTargetStart = current;
-					fSearchTargetEnd = fEditor->SendMessage(SCI_GETLENGTH, 0, 0);
+					fSearchTargetEnd = direct.Length();
 				}
 			}
-			fEditor->SendMessage(SCI_SETTARGETRANGE, fSearchTargetStart, fSearchTargetEnd);
+			direct.SetTargetRange(fSearchTargetStart, fSearchTargetEnd);
 		}
 
 		switch(message->what) {
 			case FINDWINDOW_FIND: {
-				Sci_Position pos = fEditor->SendMessage(SCI_SEARCHINTARGET, (uptr_t) strlen(findText), (sptr_t) findText);
-				if(pos != -1) {
-					fSearchLastResultStart = pos;
-					fSearchLastResultEnd = pos + strlen(findText);
-					fEditor->SendMessage(SCI_SETSEL, fSearchLastResultStart, fSearchLastResultEnd);
-					fEditor->SendMessage(SCI_SETTARGETRANGE, (backwards == false ? pos + strlen(findText) : pos), fSearchTargetEnd);
+				Searcher::Match match;
+				if(_FindInTarget(searcher, match) == true) {
+					fSearchLastResultStart = match.start;
+					fSearchLastResultEnd = match.end;
+					direct.SetSel(fSearchLastResultStart, fSearchLastResultEnd);
+					Sci_Position next = (backwards == false ? match.end : match.start);
+					if(match.start == match.end) {
+						// empty regex match, do not find it again
+						next += (backwards == false ? 1 : -1);
+					}
+					direct.SetTargetRange(next, fSearchTargetEnd);
 				} else {
 					// TODO: _method?
 					BAlert* alert = new BAlert(B_TRANSLATE("Searching finished"),
@@ -646,47 +989,390 @@ EditorWindow::_FindReplace(BMessage* message)
 							s = fSearchTargetStart;
 						} else {
 							if(backwards == true) {
-								s = fEditor->SendMessage(SCI_GETLENGTH, 0, 0);
+								s = direct.Length();
 							} else {
 								s = 0;
 							}
 						}
-						fEditor->SendMessage(SCI_SETTARGETRANGE, s, fSearchTargetEnd);
+						direct.SetTargetRange(s, fSearchTargetEnd);
 					}
 				}
 			} break;
 			case FINDWINDOW_REPLACE: {
 				if(fSearchLastResultStart != -1 && fSearchLastResultEnd != -1) {
-					fEditor->SendMessage(SCI_SETSEL, fSearchLastResultStart, fSearchLastResultEnd);
-					fEditor->SendMessage(SCI_REPLACESEL, 0, (sptr_t) replaceText);
+					Searcher::Match match;
+					match.start = fSearchLastResultStart;
+					match.end = fSearchLastResultEnd;
+					if(regex == true) {
+						// capture groups are needed to expand the replacement
+						Sci_Position length = direct.Length();
+						const char* text = direct.CharacterPointer();
+						Searcher::Match found;
+						if(searcher.Find(text, length, match.start, length, found) == true
+								&& found.start == match.start && found.end == match.end) {
+							match.groups = found.groups;
+						}
+					}
+					std::string replacement;
+					searcher.Expand(match, replacement);
+					direct.SetSel(fSearchLastResultStart, fSearchLastResultEnd);
+					direct.ReplaceSel(replacement.c_str());
 					fSearchLastResultStart = -1;
 					fSearchLastResultEnd = -1;
 				}
 			} break;
 		}
 	} else {
+		Sci_Position length = direct.Length();
+		Sci_Position targetStart = 0;
+		Sci_Position targetEnd = length;
 		if(inSelection == true) {
-			fEditor->SendMessage(SCI_TARGETFROMSELECTION, 0, 0);
-		} else {
-			fEditor->SendMessage(SCI_TARGETWHOLEDOCUMENT, 0, 0);
+			targetStart = direct.SelectionStart();
+			targetEnd = direct.SelectionEnd();
+		}
+		// Build replaced text in one pass over the document and swap it in
+		// with a single message, instead of searching and replacing target
+		// for every occurrence.
+		const char* text = direct.CharacterPointer();
+		std::string output;
+		Searcher::Match replaced;
+		size_t count = searcher.ReplaceAll(text, length, targetStart, targetEnd,
+			output, replaced);
+		if(count > 0) {
+			direct.BeginUndoAction();
+			direct.SetTargetRange(replaced.start, replaced.end);
+			direct.ReplaceTarget(output.data(), output.size());
+			direct.EndUndoAction();
 		}
-		Sci_Position pos;
-		Sci_Position targetEnd = fEditor->SendMessage(SCI_GETTARGETEND, 0, 0);
-		fEditor->SendMessage(SCI_BEGINUNDOACTION, 0, 0);
-		do {
-			pos = fEditor->SendMessage(SCI_SEARCHINTARGET, (uptr_t) strlen(findText), (sptr_t) findText);
-			if(pos != -1) {
-				fEditor->SendMessage(SCI_REPLACETARGET, -1, (sptr_t) replaceText);
-				fEditor->SendMessage(SCI_SETTARGETRANGE, pos + strlen(replaceText), targetEnd);
-			}
-		} while(pos != -1);
-		fEditor->SendMessage(SCI_ENDUNDOACTION, 0, 0);
 		fSearchLastResultStart = -1;
 		fSearchLastResultEnd = -1;
 	}
 }
 
 
+bool
+EditorWindow::_FindInTarget(const Searcher& searcher, Searcher::Match& match)
+{
+	// Scintilla target marks the remaining search range, it is reversed when
+	// searching backwards.
+	ScintillaDirect& direct = _FocusedEditor()->Direct();
+	Sci_Position start = direct.TargetStart();
+	Sci_Position end = direct.TargetEnd();
+	Sci_Position length = direct.Length();
+	const char* text = direct.CharacterPointer();
+	if(start <= end)
+		return searcher.Find(text, length, start, end, match);
+	return searcher.FindLast(text, length, end, start, match);
+}
+
+
+// Find next is repeated with the same options, the pattern is compiled
+// only when they change.
+const Searcher&
+EditorWindow::_Searcher(const BMessage* message, const char* replaceText)
+{
+	const char* findText = message->GetString("findText", "");
+	std::string key;
+	key += message->GetBool("matchCase") ? 'c' : '-';
+	key += message->GetBool("matchWord") ? 'w' : '-';
+	key += message->GetBool("regex") ? 'r' : '-';
+	key.append(findText).append(1, '\0').append(replaceText);
+	if(fSearcher == nullptr || key != fSearcherKey) {
+		fSearcher.reset(new Searcher(findText, replaceText,
+			message->GetBool("matchCase"), message->GetBool("matchWord"),
+			message->GetBool("regex")));
+		fSearcherKey = key;
+	}
+	return *fSearcher;
+}
+
+
+void
+EditorWindow::_FindAll(BMessage* message)
+{
+	const Searcher& searcher = _Searcher(message, "");
+	fSearchResultsView->Clear();
+	_ShowSearchResults(true);
+
+	const char* text = reinterpret_cast<const char*>(
+		fEditor->SendMessage(SCI_GETCHARACTERPOINTER, 0, 0));
+	const size_t length = fEditor->SendMessage(SCI_GETLENGTH, 0, 0);
+	std::vector<SearchResultsView::Match> matches;
+	Searcher::Match match;
+	size_t pos = 0;
+	while(pos <= length && searcher.Find(text, length, pos, length, match) == true) {
+		pos = (match.end > match.start) ? match.end : match.end + 1;
+		const int32 line = fEditor->SendMessage(SCI_LINEFROMPOSITION, match.start, 0);
+		const size_t lineStart = fEditor->SendMessage(SCI_POSITIONFROMLINE, line, 0);
+		const size_t lineEnd = fEditor->SendMessage(SCI_GETLINEENDPOSITION, line, 0);
+		SearchResultsView::Match result;
+		result.offset = lineStart;
+		result.line = line;
+		result.column = match.start - lineStart;
+		result.length = std::min(match.end, lineEnd) - match.start;
+		matches.push_back(result);
+	}
+	fSearchResultsView->AddResults("", matches.data(), matches.size());
+	_UpdateSearchResultsLabel(true);
+}
+
+
+void
+EditorWindow::_ShowSearchResults(bool show)
+{
+	fSplitView->SetItemCollapsed(1, !show);
+	fMainMenu->FindItem(MAINMENU_VIEW_SEARCHRESULTS)->SetMarked(show);
+}
+
+
+void
+EditorWindow::_ShowOutline(bool show)
+{
+	fOutlineSplitView->SetItemCollapsed(0, !show);
+	fMainMenu->FindItem(MAINMENU_VIEW_OUTLINE)->SetMarked(show);
+	if(show == true)
+		fOutlineView->SetSymbols(fEditor->Symbols().Symbols());
+}
+
+
+// The second view shares the document of the first one, text and undo
+// history are kept once and edits in one view show in the other.
+void
+EditorWindow::_ShowSecondView(bool show)
+{
+	fMainMenu->FindItem(MAINMENU_VIEW_SPLIT)->SetMarked(show);
+	if(show == (fSecondEditor != NULL))
+		return;
+	if(show == true) {
+		fSecondEditor = new Editor();
+		fSecondEditor->SetPreferences(fPreferences);
+		fEditorSplitView->AddChild(fSecondEditor);
+		fSecondEditor->ShareDocument(fEditor);
+		_ApplyViewPreferences(fSecondEditor);
+		_SetUpView(fSecondEditor);
+		if(fCurrentLanguage.empty() == false)
+			_SetViewLanguage(fSecondEditor);
+		if(fFilters.empty() == false)
+			_ApplyFilters();
+		fSecondEditor->SendMessage(SCI_GOTOPOS,
+			fEditor->SendMessage(SCI_GETCURRENTPOS, 0, 0), 0);
+		fSecondEditor->MakeFocus();
+	} else {
+		fSecondEditor->RemoveSelf();
+		delete fSecondEditor;
+		fSecondEditor = NULL;
+		fEditor->MakeFocus();
+	}
+}
+
+
+// What the editor measured of its own work, for checking optimizations
+// without a debug build.
+void
+EditorWindow::_ShowCounters()
+{
+	Editor* editor = _FocusedEditor();
+	BString text;
+	float viewCall;
+	float directCall;
+	editor->MeasureCalls(viewCall, directCall);
+	text.SetToFormat(B_TRANSLATE("Scintilla call: %.1f ns through the view, "
+		"%.1f ns direct\n"), viewCall, directCall);
+	BString line;
+	// styles and languages are cached, this should not grow with windows
+	line.SetToFormat(B_TRANSLATE("Data files parsed: %u\n"),
+		(unsigned int) DataLoader::ParseCount());
+	text << line;
+	const Styler::EditorState& style = editor->StyleState();
+	line.SetToFormat(B_TRANSLATE("Last style change: %d messages in %d us\n"),
+		(int) style.messages, (int) style.time);
+	text << line;
+	line.SetToFormat(B_TRANSLATE("Background styling: %d slices, %d us, "
+		"longest %d us\n"), (int) editor->StylingSlices(),
+		(int) editor->StylingTime(), (int) editor->StylingLongestSlice());
+	text << line;
+	for(const auto& it : editor->NotificationCosts()) {
+		line.SetToFormat(B_TRANSLATE("Notification %d: %d times, "
+			"%.1f messages each\n"), it.first, (int) it.second.count,
+			static_cast<double>(it.second.messages) / it.second.count);
+		text << line;
+	}
+
+	BAlert* alert = new BAlert(B_TRANSLATE("Performance counters"),
+		text.String(), B_TRANSLATE("OK"), NULL, NULL, B_WIDTH_AS_USUAL,
+		B_INFO_ALERT);
+	alert->SetShortcut(0, B_ESCAPE);
+	alert->Go(NULL);
+}
+
+
+// Focus stays with the view typed in last when another window is active,
+// e.g. Find/Replace. It is held by the view Scintilla draws in, a child of
+// the editor.
+Editor*
+EditorWindow::_FocusedEditor()
+{
+	BView* focus = CurrentFocus();
+	if(fSecondEditor != NULL && focus != NULL
+			&& (focus == fSecondEditor || focus->Parent() == fSecondEditor))
+		return fSecondEditor;
+	return fEditor;
+}
+
+
+// Symbols can change with every key typed, the outline is rebuilt at most
+// a few times a second.
+void
+EditorWindow::_ScheduleOutlineUpdate()
+{
+	if(fOutlineUpdatePending == true || fOutlineSplitView->IsItemCollapsed(0) == true)
+		return;
+	fOutlineUpdatePending = true;
+	BMessage update(OUTLINE_UPDATE);
+	BMessageRunner::StartSending(BMessenger(this), &update, kOutlineUpdateDelay, 1);
+}
+
+
+// Unsaved text of the document is indexed once typing stops for a while.
+void
+EditorWindow::_ScheduleIdentifiersUpdate(bigtime_t delay)
+{
+	if(fIdentifiersUpdatePending == true || fOpenedFilePath == NULL
+			|| IdentifierIndex::IsSource(fOpenedFilePath->Leaf()) == false)
+		return;
+	fIdentifiersUpdatePending = true;
+	BMessage update(IDENTIFIERS_UPDATE);
+	BMessageRunner::StartSending(BMessenger(this), &update, delay, 1);
+}
+
+
+void
+EditorWindow::_UpdateSearchResultsLabel(bool done)
+{
+	BString label;
+	if(done == true) {
+		label = B_TRANSLATE("%count% results");
+	} else {
+		label = B_TRANSLATE("Searching" B_UTF8_ELLIPSIS " %count% results so far");
+	}
+	BString count;
+	count << (uint64) fSearchResultsView->CountResults();
+	label.ReplaceAll("%count%", count.String());
+	fSearchResultsLabel->SetText(label.String());
+}
+
+
+void
+EditorWindow::_ApplyFilters()
+{
+	const size_t lineCount = fEditor->SendMessage(SCI_GETLINECOUNT, 0, 0);
+	// filters computed before lines were added or removed no longer apply
+	const size_t filterCount = fFilters.size();
+	fFilters.erase(std::remove_if(fFilters.begin(), fFilters.end(),
+		[lineCount](const std::vector<uint8>& filter) {
+			return filter.size() != lineCount; }),
+		fFilters.end());
+
+	std::vector<uint8> visible(lineCount, 1);
+	for(const auto& filter : fFilters) {
+		for(size_t line = 0; line < lineCount; line++)
+			visible[line] &= filter[line];
+	}
+	_ShowLines(fEditor, visible);
+	if(fSecondEditor != NULL)
+		_ShowLines(fSecondEditor, visible);
+
+	if(fFilters.size() != filterCount) {
+		BAlert* alert = new BAlert(B_TRANSLATE("Filter lines"),
+			B_TRANSLATE("Lines were added or removed since some filters were "
+				"applied. Those filters were removed, apply them again to "
+				"filter the text as it is now."),
+			B_TRANSLATE("OK"), nullptr, nullptr, B_WIDTH_AS_USUAL, B_INFO_ALERT);
+		alert->SetShortcut(0, B_ESCAPE);
+		alert->Go(nullptr);
+	}
+}
+
+
+// Hidden line state lives only in the view, so neither the document nor
+// undo history is touched. Runs of lines are changed with single calls.
+// Scintilla cannot hide the first line and ignores runs starting with it.
+void
+EditorWindow::_ShowLines(Editor* editor, const std::vector<uint8>& visible)
+{
+	const size_t lineCount = visible.size();
+	size_t runStart = 0;
+	while(runStart < lineCount) {
+		size_t runEnd = runStart + 1;
+		while(runEnd < lineCount && visible[runEnd] == visible[runStart])
+			runEnd++;
+		if(visible[runStart] != 0)
+			editor->SendMessage(SCI_SHOWLINES, runStart, runEnd - 1);
+		else if(runStart > 0 || runEnd > 1)
+			editor->SendMessage(SCI_HIDELINES, std::max<size_t>(runStart, 1), runEnd - 1);
+		runStart = runEnd;
+	}
+	editor->SendMessage(SCI_SCROLLCARET, 0, 0);
+}
+
+
+void
+EditorWindow::_FinishFilter(BMessage* message)
+{
+	// ignore results of filters which were stopped in the meantime
+	if(fLineFilter == NULL
+			|| message->GetPointer("lineFilter", NULL) != fLineFilter)
+		return;
+	if(message->GetInt32("status", B_ERROR) == B_OK) {
+		fFilters.push_back(fLineFilter->Visible());
+		_ApplyFilters();
+	}
+	_StopFilter();
+}
+
+
+void
+EditorWindow::_StartFilter(BMessage* message)
+{
+	if(fLineFilter != NULL)
+		return;
+
+	// Filter reads the document directly, it is kept read-only until done
+	// so that the buffer does not move.
+	const char* text = reinterpret_cast<const char*>(
+		fEditor->SendMessage(SCI_GETCHARACTERPOINTER, 0, 0));
+	const size_t length = fEditor->SendMessage(SCI_GETLENGTH, 0, 0);
+	const char lineEnd =
+		fEditor->SendMessage(SCI_GETEOLMODE, 0, 0) == SC_EOL_CR ? '\r' : '\n';
+	fLineFilter = new LineFilter(BMessenger(this), text, length, lineEnd,
+		message->GetString("pattern", ""), message->GetBool("matchCase"),
+		message->GetBool("regex"), message->GetInt32("context", 0));
+	if(fLineFilter->Start() != B_OK) {
+		if(fLineFilter->IsValid() == false) {
+			BAlert* alert = new BAlert(B_TRANSLATE("Filter lines"),
+				B_TRANSLATE("Regular expression is not valid."),
+				B_TRANSLATE("OK"), nullptr, nullptr, B_WIDTH_AS_USUAL, B_STOP_ALERT);
+			alert->SetShortcut(0, B_ESCAPE);
+			alert->Go();
+		}
+		_StopFilter();
+		return;
+	}
+	fEditor->SendMessage(SCI_SETREADONLY, true, 0);
+}
+
+
+void
+EditorWindow::_StopFilter()
+{
+	if(fLineFilter == NULL)
+		return;
+	delete fLineFilter;
+	fLineFilter = NULL;
+	fEditor->SendMessage(SCI_SETREADONLY, fReadOnly, 0);
+}
+
+
 status_t
 EditorWindow::_MonitorFile(BStatable* file, bool enable)
 {
@@ -704,41 +1390,82 @@ EditorWindow::_PopulateLanguageMenu(BMenu* languageMenu)
 	int32 count = languageMenu->CountItems();
 	languageMenu->RemoveItems(0, count, true);
 
-	Languages::SortAlphabetically();
-	char submenuName[] = "\0";
-	BObjectList<BMenu> menus;
-	for(int32 i = 0; i < Languages::GetCount(); ++i) {
-		std::string lang = Languages::GetLanguage(i);
-		std::string name = Languages::GetMenuItemName(lang);
-
-		BMessage *msg = new BMessage(MAINMENU_LANGUAGE);
-		msg->AddString("lang", lang.c_str());
-		BMenuItem *menuItem = new BMenuItem(name.c_str(), msg);
-
-		if(fPreferences->fCompactLangMenu == true) {
-			if(submenuName[0] != name[0]) {
-				submenuName[0] = name[0];
-				BMenu *submenu = new BMenu(submenuName);
-				menus.AddItem(submenu);
-			}
-			menus.LastItem()->AddItem(menuItem);
-		} else {
-			languageMenu->AddItem(menuItem);
+	fLanguageMenuVersion = Languages::CatalogVersion();
+	fLanguageMenuCompact = fPreferences->fCompactLangMenu;
+	const Languages::MenuModel model
+		= Languages::GetMenuModel(fLanguageMenuCompact);
+	for(const auto& group : *model) {
+		BMenu* menu = languageMenu;
+		if(!group.submenu.empty()) {
+			menu = new BMenu(group.submenu.c_str());
+			languageMenu->AddItem(menu);
 		}
-	}
-	if(fPreferences->fCompactLangMenu == true) {
-		int32 menusCount = menus.CountItems();
-		for(int32 i = 0; i < menusCount; i++) {
-			if(menus.ItemAt(i)->CountItems() > 1) {
-				languageMenu->AddItem(menus.ItemAt(i));
-			} else {
-				languageMenu->AddItem(menus.ItemAt(i)->RemoveItem((int32) 0));
-			}
+		for(const auto& language : group.items) {
+			BMessage *msg = new BMessage(MAINMENU_LANGUAGE);
+			msg->AddString("lang", language.first.c_str());
+			menu->AddItem(new BMenuItem(language.second.c_str(), msg));
 		}
 	}
 }
 
 
+// Reapplies a data file if it affects this window. Styles are sent as
+// a diff, a changed language is set up again as when it is chosen.
+void
+EditorWindow::_ReloadData(const std::string& name)
+{
+	const std::string style = std::string("styles/") + fPreferences->fStyle.String();
+	if(name == "languages/" + fCurrentLanguage) {
+		_SetLanguage(fCurrentLanguage);
+		RefreshTitle();
+	} else if(name == style || name == style + "/" + fCurrentLanguage) {
+		Styler::Apply(fEditor, fPreferences->fStyle, fCurrentLanguage.c_str());
+		if(fSecondEditor != NULL)
+			Styler::Apply(fSecondEditor, fPreferences->fStyle, fCurrentLanguage.c_str());
+	}
+	// Broken files are reported by the first window reloading them.
+	const std::string errors = DataLoader::TakeErrors();
+	if(errors.empty() == false) {
+		BString text(B_TRANSLATE("Some data files could not be read, they "
+			"are used as they were last read:\n\n"));
+		text << errors.c_str();
+		BAlert* alert = new BAlert(B_TRANSLATE("Error"), text.String(),
+			B_TRANSLATE("OK"), NULL, NULL, B_WIDTH_AS_USUAL, B_WARNING_ALERT);
+		alert->SetShortcut(0, B_ESCAPE);
+		alert->Go(NULL);
+	}
+}
+
+
+// Sources are indexed along with their folder, so that names defined in
+// other files of the project are highlighted too.
+void
+EditorWindow::_IndexIdentifiers()
+{
+	if(fOpenedFilePath == NULL
+			|| IdentifierIndex::IsSource(fOpenedFilePath->Leaf()) == false)
+		return;
+	BPath folder;
+	if(fOpenedFilePath->GetParent(&folder) == B_OK)
+		IdentifierIndex::AddFolder(folder.Path());
+	const char* text = reinterpret_cast<const char*>(
+		fEditor->SendMessage(SCI_GETCHARACTERPOINTER, 0, 0));
+	IdentifierIndex::UpdateDocument(fOpenedFilePath->Path(), text,
+		fEditor->TextLength());
+}
+
+
+// Changing a keyword set only invalidates styling, Scintilla restyles what
+// is visible and the rest as it scrolls into view or in background.
+bool
+EditorWindow::_UpdateIdentifiers()
+{
+	fIdentifiersVersion = IdentifierIndex::Version();
+	return Languages::ApplyIdentifiers(fEditor, fCurrentLanguage.c_str(),
+		IdentifierIndex::Keywords());
+}
+
+
 void
 EditorWindow::_ReloadFile(entry_ref* ref)
 {
@@ -755,7 +1482,9 @@ EditorWindow::_ReloadFile(entry_ref* ref)
 		entry.GetName(name);
 		_SetLanguageByFilename(name);
 
+		IdentifierIndex::CloseDocument(fOpenedFilePath->Path());
 		fOpenedFilePath->SetTo(&entry);
+		_IndexIdentifiers();
 		RefreshTitle();
 	}
 }
@@ -764,23 +1493,45 @@ EditorWindow::_ReloadFile(entry_ref* ref)
 void
 EditorWindow::_SetLanguage(std::string lang)
 {
-	Languages::ApplyLanguage(fEditor, lang.c_str());
-	Styler::ApplyGlobal(fEditor, fPreferences->fStyle);
-	Styler::ApplyLanguage(fEditor, fPreferences->fStyle, lang.c_str());
+	fCurrentLanguage = lang;
+	fLanguageProfile = Languages::ApplyLanguage(fEditor, lang.c_str());
+	// lexer, keywords and indexes belong to the document, the second view
+	// uses those of the first one
+	fEditor->Symbols().SetLanguage(lang);
+	fEditor->Tags().SetLanguage(lang);
+	fEditor->Folder().SetEnabled(Languages::FoldsByIndentation(lang.c_str()));
+	fEditor->Brackets().SetStyle(Languages::BracketStyle(lang.c_str(),
+		fEditor->SendMessage(SCI_GETLEXER, 0, 0)));
+	_SetViewLanguage(fEditor);
+	if(fSecondEditor != NULL)
+		_SetViewLanguage(fSecondEditor);
+	_UpdateIdentifiers();
+}
+
+
+// Each view styles the document for itself.
+void
+EditorWindow::_SetViewLanguage(Editor* editor)
+{
+	Styler::Apply(editor, fPreferences->fStyle, fCurrentLanguage.c_str());
+	editor->UpdateStyling();
 }
 
 
 void
 EditorWindow::_SetLanguageByFilename(const char* filename)
 {
+	// files without a known extension are recognized by their beginning
+	char head[LanguageDetector::kMaxSniffed + 1];
+	Sci_TextRange range;
+	range.chrg.cpMin = 0;
+	range.chrg.cpMax = std::min<Sci_Position>(fEditor->SendMessage(SCI_GETLENGTH, 0, 0),
+		LanguageDetector::kMaxSniffed);
+	range.lpstrText = head;
+	const size_t length = fEditor->SendMessage(SCI_GETTEXTRANGE, 0, (sptr_t) &range);
+
 	std::string lang;
-	// try to match whole filename first, this is needed for e.g. CMake
-	bool found = Languages::GetLanguageForExtension(filename, lang);
-	if(found == false) {
-		const char* extension = strrchr(filename, '.');
-		if(extension != nullptr)
-			Languages::GetLanguageForExtension(extension + 1, lang);
-	}
+	Languages::DetectLanguage(filename, head, length, lang);
 	_SetLanguage(lang);
 }
 
@@ -789,57 +1540,176 @@ void
 EditorWindow::_SyncWithPreferences()
 {
 	if(fPreferences != NULL) {
+		// only what differs from the current style is sent
+		const char* lang = fCurrentLanguage.empty() ? NULL : fCurrentLanguage.c_str();
+		if(fEditor->StyleState().valid == true)
+			Styler::Apply(fEditor, fPreferences->fStyle, lang);
+		if(fSecondEditor != NULL)
+			Styler::Apply(fSecondEditor, fPreferences->fStyle, lang);
+
 		fMainMenu->FindItem(MAINMENU_VIEW_SPECIAL_WHITESPACE)->SetMarked(fPreferences->fWhiteSpaceVisible);
 		fMainMenu->FindItem(MAINMENU_VIEW_SPECIAL_EOL)->SetMarked(fPreferences->fEOLVisible);
 
-		fEditor->SendMessage(SCI_SETVIEWEOL, fPreferences->fEOLVisible, 0);
-		fEditor->SendMessage(SCI_SETVIEWWS, fPreferences->fWhiteSpaceVisible, 0);
-		fEditor->SendMessage(SCI_SETTABWIDTH, fPreferences->fTabWidth, 0);
-		fEditor->SendMessage(SCI_SETUSETABS, !fPreferences->fTabsToSpaces, 0);
-		fEditor->SendMessage(SCI_SETCARETLINEVISIBLE, fPreferences->fLineHighlighting, 0);
+		_ApplyDocumentSettings();
+		_ApplyViewPreferences(fEditor);
+		if(fSecondEditor != NULL)
+			_ApplyViewPreferences(fSecondEditor);
 
-		if(fPreferences->fLineNumbers == true) {
-			fEditor->SendMessage(SCI_SETMARGINTYPEN, Editor::Margin::NUMBER, (long int) SC_MARGIN_NUMBER);
-		} else {
-			fEditor->SendMessage(SCI_SETMARGINWIDTHN, Editor::Margin::NUMBER, 0);
-		}
+		RefreshTitle();
+	}
+}
 
-		if(fPreferences->fLineLimitShow == true) {
-			fEditor->SendMessage(SCI_SETEDGEMODE, fPreferences->fLineLimitMode, 0);
-			fEditor->SendMessage(SCI_SETEDGECOLUMN, fPreferences->fLineLimitColumn, 0);
-		} else {
-			fEditor->SendMessage(SCI_SETEDGEMODE, 0, 0);
-		}
 
-		if(fPreferences->fIndentGuidesShow == true) {
-			fEditor->SendMessage(SCI_SETINDENTATIONGUIDES, fPreferences->fIndentGuidesMode, 0);
-		} else {
-			fEditor->SendMessage(SCI_SETINDENTATIONGUIDES, 0, 0);
-		}
+// Settings of a newly created view which do not come from preferences.
+void
+EditorWindow::_SetUpView(Editor* editor)
+{
+	editor->SendMessage(SCI_SETADDITIONALSELECTIONTYPING, true, 0);
+	editor->SendMessage(SCI_SETIMEINTERACTION, SC_IME_INLINE, 0);
 
-		fEditor->SendMessage(SCI_SETMARGINTYPEN, Editor::Margin::FOLD, SC_MARGIN_SYMBOL);
-		fEditor->SendMessage(SCI_SETMARGINMASKN, Editor::Margin::FOLD, SC_MASK_FOLDERS);
-		fEditor->SendMessage(SCI_SETMARGINWIDTHN, Editor::Margin::FOLD, 20);
-		fEditor->SendMessage(SCI_SETMARGINSENSITIVEN, Editor::Margin::FOLD, 1);
+	editor->SendMessage(SCI_USEPOPUP, 0, 0);
 
-		fEditor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDER, SC_MARK_PLUS);
-		fEditor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDEROPEN, SC_MARK_MINUS);
-		fEditor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDEREND, SC_MARK_EMPTY);
-		fEditor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDERMIDTAIL, SC_MARK_EMPTY);
-		fEditor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDEROPENMID, SC_MARK_EMPTY);
-		fEditor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDERSUB, SC_MARK_EMPTY);
-		fEditor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDERTAIL, SC_MARK_EMPTY);
+	Styler::Apply(editor, fPreferences->fStyle,
+		fCurrentLanguage.empty() ? NULL : fCurrentLanguage.c_str());
+	editor->SendMessage(SCI_STYLESETFORE, 253, 0xFF00000);
+	editor->SendMessage(SCI_STYLESETFORE, 254, 0x00000FF);
+}
 
-		fEditor->SendMessage(SCI_SETFOLDFLAGS, 16, 0);
 
-		RefreshTitle();
+// Preferences which Scintilla keeps for every view of a document.
+void
+EditorWindow::_ApplyViewPreferences(Editor* editor)
+{
+	editor->SendMessage(SCI_SETVIEWEOL, fPreferences->fEOLVisible, 0);
+	editor->SendMessage(SCI_SETVIEWWS, fPreferences->fWhiteSpaceVisible, 0);
+	editor->SendMessage(SCI_SETCARETLINEVISIBLE, fPreferences->fLineHighlighting, 0);
 
-		// TODO Do this only if language menu preference has changed
-		_PopulateLanguageMenu(fLanguageMenu);
+	if(fPreferences->fLineNumbers == true) {
+		editor->SendMessage(SCI_SETMARGINTYPEN, Editor::Margin::NUMBER, (long int) SC_MARGIN_NUMBER);
+		editor->UpdateLineNumberWidth();
+	} else {
+		editor->SendMessage(SCI_SETMARGINWIDTHN, Editor::Margin::NUMBER, 0);
+	}
+
+	if(fPreferences->fLineLimitShow == true) {
+		editor->SendMessage(SCI_SETEDGEMODE, fPreferences->fLineLimitMode, 0);
+		editor->SendMessage(SCI_SETEDGECOLUMN, fPreferences->fLineLimitColumn, 0);
+	} else {
+		editor->SendMessage(SCI_SETEDGEMODE, 0, 0);
+	}
+
+	if(fPreferences->fIndentGuidesShow == true) {
+		editor->SendMessage(SCI_SETINDENTATIONGUIDES, fPreferences->fIndentGuidesMode, 0);
+	} else {
+		editor->SendMessage(SCI_SETINDENTATIONGUIDES, 0, 0);
+	}
+
+	editor->SendMessage(SCI_SETMARGINTYPEN, Editor::Margin::FOLD, SC_MARGIN_SYMBOL);
+	editor->SendMessage(SCI_SETMARGINMASKN, Editor::Margin::FOLD, SC_MASK_FOLDERS);
+	editor->SendMessage(SCI_SETMARGINWIDTHN, Editor::Margin::FOLD, 20);
+	editor->SendMessage(SCI_SETMARGINSENSITIVEN, Editor::Margin::FOLD, 1);
+
+	editor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDER, SC_MARK_PLUS);
+	editor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDEROPEN, SC_MARK_MINUS);
+	editor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDEREND, SC_MARK_EMPTY);
+	editor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDERMIDTAIL, SC_MARK_EMPTY);
+	editor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDEROPENMID, SC_MARK_EMPTY);
+	editor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDERSUB, SC_MARK_EMPTY);
+	editor->SendMessage(SCI_MARKERDEFINE, SC_MARKNUM_FOLDERTAIL, SC_MARK_EMPTY);
+
+	editor->SendMessage(SCI_SETFOLDFLAGS, 16, 0);
+}
+
+
+// Indentation and line endings from .editorconfig of the document, then
+// indentation detected when it was opened, the rest from preferences.
+void
+EditorWindow::_ApplyDocumentSettings()
+{
+	const EditorConfig::Settings& config = fEditorConfig;
+	const IndentationDetector::Result& detected = fDetectedIndentation;
+	int tabWidth = fPreferences->fTabWidth;
+	if(config.tabWidth != -1)
+		tabWidth = config.tabWidth;
+	else if(detected.width != -1)
+		tabWidth = detected.width;
+	int useTabs = !fPreferences->fTabsToSpaces;
+	if(config.useTabs != -1)
+		useTabs = config.useTabs;
+	else if(detected.useTabs != -1)
+		useTabs = detected.useTabs;
+	fEditor->SendMessage(SCI_SETTABWIDTH, tabWidth, 0);
+	fEditor->SendMessage(SCI_SETUSETABS, useTabs, 0);
+	// 0 follows the tab width
+	fEditor->SendMessage(SCI_SETINDENT, std::max(config.indentSize, 0), 0);
+	if(config.eolMode != -1)
+		fEditor->SendMessage(SCI_SETEOLMODE, config.eolMode, 0);
+	fEditor->Folder().TabWidthChanged();
+	if(fSecondEditor != NULL) {
+		// the document is shared, but only the view it is set through
+		// is redrawn
+		fSecondEditor->SendMessage(SCI_SETTABWIDTH, tabWidth, 0);
 	}
 }
 
 
+// Trailing whitespace and final newline are fixed in the document, in one
+// undo action, so what is saved is what is shown.
+void
+EditorWindow::_PrepareForSave()
+{
+	const EditorConfig::Settings& config = fEditorConfig;
+	if(config.trimTrailingWhitespace != 1 && config.insertFinalNewline == -1)
+		return;
+	// the document is read-only for the view when the file is, and the
+	// file may be saved elsewhere
+	fEditor->SendMessage(SCI_SETREADONLY, false, 0);
+	fEditor->SendMessage(SCI_BEGINUNDOACTION, 0, 0);
+	if(config.trimTrailingWhitespace == 1) {
+		// found in the text at once, deleted from the end so that
+		// positions stay valid
+		const char* text = reinterpret_cast<const char*>(
+			fEditor->SendMessage(SCI_GETCHARACTERPOINTER, 0, 0));
+		const Sci_Position length = fEditor->SendMessage(SCI_GETLENGTH, 0, 0);
+		std::vector<std::pair<Sci_Position, Sci_Position>> trailing;
+		Sci_Position lineStart = 0;
+		for(Sci_Position pos = 0; pos <= length; pos++) {
+			if(pos < length && text[pos] != '\n' && text[pos] != '\r')
+				continue;
+			Sci_Position trimmed = pos;
+			while(trimmed > lineStart
+					&& (text[trimmed - 1] == ' ' || text[trimmed - 1] == '\t'))
+				trimmed--;
+			if(trimmed < pos)
+				trailing.push_back(std::make_pair(trimmed, pos - trimmed));
+			lineStart = pos + 1;
+		}
+		for(auto it = trailing.rbegin(); it != trailing.rend(); it++)
+			fEditor->SendMessage(SCI_DELETERANGE, it->first, it->second);
+	}
+	const Sci_Position length = fEditor->SendMessage(SCI_GETLENGTH, 0, 0);
+	const char* text = reinterpret_cast<const char*>(
+		fEditor->SendMessage(SCI_GETCHARACTERPOINTER, 0, 0));
+	auto isEOL = [text](Sci_Position pos) {
+		return text[pos] == '\n' || text[pos] == '\r';
+	};
+	if(config.insertFinalNewline == 1 && length > 0 && isEOL(length - 1) == false) {
+		const int eolMode = fEditor->SendMessage(SCI_GETEOLMODE, 0, 0);
+		const char* eol = eolMode == SC_EOL_CRLF ? "\r\n"
+			: (eolMode == SC_EOL_CR ? "\r" : "\n");
+		fEditor->SendMessage(SCI_APPENDTEXT, strlen(eol), (sptr_t) eol);
+	} else if(config.insertFinalNewline == 0) {
+		Sci_Position end = length;
+		while(end > 0 && isEOL(end - 1) == true)
+			end--;
+		if(end < length)
+			fEditor->SendMessage(SCI_DELETERANGE, end, length - end);
+	}
+	fEditor->SendMessage(SCI_ENDUNDOACTION, 0, 0);
+	fEditor->SendMessage(SCI_SETREADONLY, fReadOnly, 0);
+}
+
+
 int32
 EditorWindow::_ShowModifiedAlert()
 {
@@ -14,9 +14,14 @@
 
 #include <ScintillaView.h>
 
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "EditorConfig.h"
+#include "IndentationDetector.h"
 #include "Languages.h"
+#include "Searcher.h"
 
 
 struct entry_ref;
@@ -24,9 +29,16 @@ class BFilePanel;
 class BMenu;
 class BMenuBar;
 class BPath;
+class BSplitView;
+class BStringView;
 class Editor;
+class FilterLinesWindow;
 class GoToLineWindow;
+class GoToSymbolWindow;
+class LineFilter;
+class OutlineView;
 class Preferences;
+class SearchResultsView;
 
 
 const BString gAppName = B_TRANSLATE_SYSTEM_NAME("Koder");
@@ -55,17 +67,35 @@ enum {
 
 	MAINMENU_SEARCH_FINDREPLACE			= 'msfr',
 	MAINMENU_SEARCH_GOTOLINE			= 'msgl',
+	MAINMENU_SEARCH_GOTOSYMBOL			= 'msgs',
+	MAINMENU_SEARCH_MATCHINGTAG			= 'msmt',
+	MAINMENU_SEARCH_ENCLOSINGBRACKET	= 'mseb',
+	MAINMENU_SEARCH_NEXTHUNK			= 'msnh',
+	MAINMENU_SEARCH_PREVHUNK			= 'msph',
+	MAINMENU_SEARCH_NEXTFILE			= 'msnf',
+	MAINMENU_SEARCH_PREVFILE			= 'mspf',
+	MAINMENU_SEARCH_FILTERLINES			= 'msfl',
+	MAINMENU_SEARCH_REMOVEFILTER		= 'msrf',
+	MAINMENU_SEARCH_SHOWALLLINES		= 'msal',
 
 	MAINMENU_VIEW_LINEHIGHLIGHT			= 'mlhl',
 	MAINMENU_VIEW_LINENUMBERS			= 'mvln',
+	MAINMENU_VIEW_SEARCHRESULTS			= 'mvsr',
+	MAINMENU_VIEW_OUTLINE				= 'mvol',
+	MAINMENU_VIEW_SPLIT					= 'mvsp',
 
 	MAINMENU_LANGUAGE					= 'ml00',
 
+	MAINMENU_HELP_COUNTERS				= 'mhpc',
+
 	FILE_OPEN							= 'flop',
 	FILE_SAVE							= 'flsv',
 
 	WINDOW_NEW							= 'ewnw',
 	WINDOW_CLOSE						= 'ewcl',
+
+	OUTLINE_UPDATE						= 'olup',
+	IDENTIFIERS_UPDATE					= 'idup',
 };
 
 
@@ -80,9 +110,13 @@ public:
 
 			bool			QuitRequested();
 			void			MessageReceived(BMessage* message);
+			void			MenusBeginning();
 			void			WindowActivated(bool active);
 
 			bool			IsModified() { return fModified; }
+			// Whether the window shows the file at path.
+			bool			IsFileOpened(const char* path);
+			bool			IsFileOpened() { return fOpenedFilePath != nullptr; }
 			const char*		OpenedFilePath();
 
 	static	void			SetPreferences(Preferences* preferences);
@@ -98,32 +132,89 @@ private:
 			BMimeType		fOpenedFileMimeType;
 			time_t			fOpenedFileModificationTime;
 			bool			fModifiedOutside;
+			EditorConfig::Settings	fEditorConfig;
+				// of the opened file, override preferences
+			IndentationDetector::Result	fDetectedIndentation;
+				// used where .editorconfig does not say
 			bool			fModified;
 			bool			fReadOnly;
 			Editor*			fEditor;
+			Editor*			fSecondEditor;
+				// another view of the same document, NULL if not split
+			BSplitView*		fEditorSplitView;
+			BSplitView*		fSplitView;
+			BSplitView*		fOutlineSplitView;
+			OutlineView*	fOutlineView;
+			bool			fOutlineUpdatePending;
+			bool			fIdentifiersUpdatePending;
+			bigtime_t		fLastTextChange;
+			SearchResultsView*	fSearchResultsView;
+			BStringView*	fSearchResultsLabel;
 			BFilePanel*		fOpenPanel;
 			BFilePanel*		fSavePanel;
 			BMenu*			fLanguageMenu;
+			uint32			fLanguageMenuVersion;
+			bool			fLanguageMenuCompact;
+			std::string		fCurrentLanguage;
+			std::string		fLanguageProfile;
+				// size profile picked for the document, shown in title
+			uint32			fIdentifiersVersion;
 
 			Sci_Position	fSearchTargetStart;
 			Sci_Position	fSearchTargetEnd;
 			Sci_Position	fSearchLastResultStart;
 			Sci_Position	fSearchLastResultEnd;
+			std::unique_ptr<Searcher>	fSearcher;
+			std::string		fSearcherKey;
+				// options and texts fSearcher was made for
 
 			GoToLineWindow*	fGoToLineWindow;
+			GoToSymbolWindow*	fGoToSymbolWindow;
+			FilterLinesWindow*	fFilterLinesWindow;
+
+			LineFilter*		fLineFilter;
+			std::vector<std::vector<uint8>>	fFilters;
+				// stacked filters, line is shown only if all of them show it
 
 			bool			fActivatedGuard;
 
 	static	Preferences*	fPreferences;
 
 			bool			_CheckPermissions(BStatable* file, mode_t permissions);
+			const Searcher&	_Searcher(const BMessage* message,
+								const char* replaceText);
+			bool			_FindInTarget(const Searcher& searcher,
+								Searcher::Match& match);
 			void			_FindReplace(BMessage* message);
+			void			_FindAll(BMessage* message);
+			void			_ShowSearchResults(bool show);
+			void			_ShowOutline(bool show);
+			void			_ShowSecondView(bool show);
+			void			_ShowCounters();
+			Editor*			_FocusedEditor();
+			void			_SetUpView(Editor* editor);
+			void			_SetViewLanguage(Editor* editor);
+			void			_ApplyViewPreferences(Editor* editor);
+			void			_ScheduleOutlineUpdate();
+			void			_ScheduleIdentifiersUpdate(bigtime_t delay);
+			void			_UpdateSearchResultsLabel(bool done);
+			void			_ApplyFilters();
+			void			_ShowLines(Editor* editor,
+								const std::vector<uint8>& visible);
+			void			_FinishFilter(BMessage* message);
+			void			_StartFilter(BMessage* message);
+			void			_StopFilter();
 			status_t		_MonitorFile(BStatable* file, bool enable);
 			void			_PopulateLanguageMenu(BMenu* languageMenu);
+			void			_ReloadData(const std::string& name);
+			void			_IndexIdentifiers();
+			bool			_UpdateIdentifiers();
 			void			_ReloadFile(entry_ref* ref = nullptr);
 			void			_SetLanguage(std::string lang);
 			void			_SetLanguageByFilename(const char* filename);
 			void			_SyncWithPreferences();
+			void			_ApplyDocumentSettings();
+			void			_PrepareForSave();
 			int32			_ShowModifiedAlert();
 			void			_Save();
 };
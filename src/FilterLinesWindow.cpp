@@ -0,0 +1,110 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "FilterLinesWindow.h"
+
+#include <cstdlib>
+
+#include <Button.h>
+#include <Catalog.h>
+#include <CheckBox.h>
+#include <GroupLayout.h>
+#include <LayoutBuilder.h>
+#include <MessageFilter.h>
+#include <TextControl.h>
+
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "FilterLinesWindow"
+
+
+FilterLinesWindow::FilterLinesWindow(BWindow* owner)
+	:
+	BWindow(BRect(0, 0, 0, 0), B_TRANSLATE("Filter lines"), B_MODAL_WINDOW_LOOK,
+		B_MODAL_SUBSET_WINDOW_FEEL,
+		B_NOT_RESIZABLE | B_NOT_MOVABLE | B_AUTO_UPDATE_SIZE_LIMITS),
+	fOwner(owner)
+{
+	fPattern = new BTextControl("PatternTC", B_TRANSLATE("Show lines containing:"), "", NULL);
+	fContext = new BTextControl("ContextTC", B_TRANSLATE("Context lines:"), "0", NULL);
+	fMatchCase = new BCheckBox("MatchCaseCB", B_TRANSLATE("Match case"), NULL);
+	fRegex = new BCheckBox("RegexCB", B_TRANSLATE("Regular expression"), NULL);
+	fFilter = new BButton("FilterButton", B_TRANSLATE("Filter"), new BMessage(FLW_FILTER));
+	fFilter->MakeDefault(true);
+	fCancel = new BButton("CancelButton", B_TRANSLATE("Cancel"), new BMessage(FLW_CANCEL));
+
+	AddCommonFilter(new BMessageFilter(B_KEY_DOWN, KeyDownFilter));
+
+	AddToSubset(fOwner);
+
+	BGroupLayout* layout = new BGroupLayout(B_VERTICAL, 5);
+	layout->SetInsets(5, 5, 5, 5);
+	SetLayout(layout);
+	layout->View()->SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+	BLayoutBuilder::Group<>(layout)
+		.AddGrid(5, 5)
+			.AddTextControl(fPattern, 0, 0)
+			.AddTextControl(fContext, 0, 1)
+		.End()
+		.Add(fMatchCase)
+		.Add(fRegex)
+		.AddGroup(B_HORIZONTAL, 5)
+			.Add(fCancel)
+			.Add(fFilter)
+		.End();
+}
+
+
+void
+FilterLinesWindow::MessageReceived(BMessage* message)
+{
+	switch(message->what) {
+	case FLW_FILTER: {
+		message->AddString("pattern", fPattern->Text());
+		message->AddInt32("context", atoi(fContext->Text()));
+		message->AddBool("matchCase", fMatchCase->Value() == B_CONTROL_ON);
+		message->AddBool("regex", fRegex->Value() == B_CONTROL_ON);
+		fOwner->PostMessage(message);
+	}
+	case FLW_CANCEL:
+		Hide();
+	break;
+	default:
+		BWindow::MessageReceived(message);
+	break;
+	}
+}
+
+
+void
+FilterLinesWindow::ShowCentered(BRect ownerRect)
+{
+	CenterIn(ownerRect);
+	Show();
+}
+
+
+void
+FilterLinesWindow::WindowActivated(bool active)
+{
+	fPattern->MakeFocus();
+	fPattern->TextView()->SelectAll();
+}
+
+
+filter_result
+FilterLinesWindow::KeyDownFilter(BMessage* message, BHandler** target,
+	BMessageFilter* messageFilter)
+{
+	if(message->what == B_KEY_DOWN) {
+		const char* bytes;
+		message->FindString("bytes", &bytes);
+		if(bytes[0] == B_ESCAPE) {
+			messageFilter->Looper()->PostMessage(FLW_CANCEL);
+			return B_SKIP_MESSAGE;
+		}
+	}
+	return B_DISPATCH_MESSAGE;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef FILTERLINESWINDOW_H
+#define FILTERLINESWINDOW_H
+
+
+#include <MessageFilter.h>
+#include <Window.h>
+
+
+class BButton;
+class BCheckBox;
+class BTextControl;
+
+
+enum {
+	FLW_CANCEL				= 'flwc',
+	FLW_FILTER				= 'flwf'
+};
+
+
+class FilterLinesWindow : public BWindow {
+public:
+							FilterLinesWindow(BWindow* owner);
+
+			void			MessageReceived(BMessage* message);
+			void			ShowCentered(BRect ownerRect);
+			void			WindowActivated(bool active);
+
+	static	filter_result	KeyDownFilter(BMessage* message, BHandler** target,
+								BMessageFilter* messageFilter);
+
+private:
+			BTextControl*	fPattern;
+			BTextControl*	fContext;
+			BCheckBox*		fMatchCase;
+			BCheckBox*		fRegex;
+			BButton*		fFilter;
+			BButton*		fCancel;
+
+			BWindow*		fOwner;
+};
+
+
+#endif // FILTERLINESWINDOW_H
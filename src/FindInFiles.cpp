@@ -0,0 +1,570 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "FindInFiles.h"
+
+#include <Autolock.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
+#include <Message.h>
+#include <Node.h>
+#include <Path.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fnmatch.h>
+#include <unistd.h>
+
+#include "SearchResultsView.h"
+
+
+namespace {
+
+const size_t kMaxPreviewsPerFile = 3;
+const size_t kMaxPreviewLength = 160;
+const size_t kBinaryProbeLength = 8192;
+const size_t kResultsBatchSize = 4096;
+const char* kTemporarySuffix = ".koder-tmp";
+const char* kBackupSuffix = ".koder-bak";
+
+
+std::string
+TrimPreview(const char* start, const char* end)
+{
+	while(start < end && (*start == ' ' || *start == '\t'))
+		start++;
+	while(end > start && (end[-1] == '\r' || end[-1] == '\n'))
+		end--;
+	if(static_cast<size_t>(end - start) > kMaxPreviewLength) {
+		end = start + kMaxPreviewLength;
+		// do not cut multibyte character in half
+		while(end > start && (static_cast<unsigned char>(*end) & 0xC0) == 0x80)
+			end--;
+	}
+	return std::string(start, end);
+}
+
+}
+
+
+FindInFiles::FindInFiles(const BMessenger& target, const char* folder,
+	const char* filter, const char* findText, const char* replaceText,
+	bool matchCase, bool matchWord, bool regex)
+	:
+	fTarget(target),
+	fFolder(folder),
+	fFindText(findText),
+	fReplaceText(replaceText),
+	fMatchCase(matchCase),
+	fMatchWord(matchWord),
+	fRegex(regex),
+	fSearcher(findText, replaceText, matchCase, matchWord, regex),
+	fThread(-1),
+	fCancelled(false),
+	fFailed(false),
+	fNextIndex(0),
+	fJobCount(0),
+	fJob(nullptr),
+	fFailedLock("FindInFiles failure")
+{
+	// filter is a list of globs separated by spaces, commas or semicolons
+	const char* separators = " ,;";
+	std::string filters(filter != nullptr ? filter : "");
+	size_t start = filters.find_first_not_of(separators);
+	while(start != std::string::npos) {
+		size_t end = filters.find_first_of(separators, start);
+		fFilters.push_back(filters.substr(start, end - start));
+		start = filters.find_first_not_of(separators, end);
+	}
+}
+
+
+FindInFiles::~FindInFiles()
+{
+	Cancel();
+	if(fThread >= 0) {
+		status_t exitValue;
+		wait_for_thread(fThread, &exitValue);
+	}
+}
+
+
+status_t
+FindInFiles::Scan()
+{
+	if(fSearcher.IsValid() == false)
+		return B_BAD_VALUE;
+	fThread = spawn_thread(_ScanThread, "find in files", B_LOW_PRIORITY, this);
+	if(fThread < 0)
+		return fThread;
+	return resume_thread(fThread);
+}
+
+
+status_t
+FindInFiles::Replace(const std::set<std::string>& skipPaths)
+{
+	if(fThread >= 0) {
+		// scan thread has already finished, it only needs to be reaped
+		status_t exitValue;
+		wait_for_thread(fThread, &exitValue);
+	}
+	fToReplace.clear();
+	fSkippedPaths = skipPaths;
+	for(size_t i = 0; i < fChanges.size(); i++) {
+		if(skipPaths.count(fChanges[i].path) == 0)
+			fToReplace.push_back(i);
+	}
+	fThread = spawn_thread(_ReplaceThread, "replace in files", B_NORMAL_PRIORITY, this);
+	if(fThread < 0)
+		return fThread;
+	return resume_thread(fThread);
+}
+
+
+void
+FindInFiles::Cancel()
+{
+	fCancelled = true;
+}
+
+
+size_t
+FindInFiles::TotalCount() const
+{
+	size_t count = 0;
+	for(const auto& change : fChanges)
+		count += change.count;
+	return count;
+}
+
+
+/* static */ status_t
+FindInFiles::_ScanThread(void* data)
+{
+	FindInFiles* self = static_cast<FindInFiles*>(data);
+	self->_CollectFiles(self->fFolder);
+	self->fChanges.resize(self->fFiles.size());
+	self->_RunParallel(self->fFiles.size(), &FindInFiles::_ScanFile);
+
+	auto& changes = self->fChanges;
+	changes.erase(std::remove_if(changes.begin(), changes.end(),
+		[](const FileChange& change) { return change.count == 0; }),
+		changes.end());
+
+	BMessage message(FINDINFILES_SCANNED);
+	message.AddPointer("findInFiles", self);
+	message.AddInt32("status", self->fCancelled ? B_CANCELED : B_OK);
+	self->fTarget.SendMessage(&message);
+	return B_OK;
+}
+
+
+/* static */ status_t
+FindInFiles::_ReplaceThread(void* data)
+{
+	FindInFiles* self = static_cast<FindInFiles*>(data);
+	self->fWritten.assign(self->fToReplace.size(), 0);
+
+	// Phase one: write new contents next to the originals. Nothing is
+	// visible to the user yet, so bailing out only means removing temporary
+	// files.
+	self->_RunParallel(self->fToReplace.size(), &FindInFiles::_WriteTemporary);
+
+	// Phase two: swap files, keeping originals as backups until every file
+	// has been swapped successfully.
+	status_t status = B_CANCELED;
+	if(self->fFailed == false && self->fCancelled == false)
+		status = self->_Commit();
+	else if(self->fFailed == true)
+		status = B_ERROR;
+
+	for(size_t i = 0; i < self->fToReplace.size(); i++) {
+		if(self->fWritten[i] == 0)
+			continue;
+		const std::string& path = self->fChanges[self->fToReplace[i]].path;
+		unlink(_SiblingPath(path, kTemporarySuffix).c_str());
+		if(status == B_OK)
+			unlink(_SiblingPath(path, kBackupSuffix).c_str());
+	}
+
+	BMessage message(FINDINFILES_REPLACED);
+	message.AddPointer("findInFiles", self);
+	message.AddInt32("status", status);
+	message.AddString("failedPath", self->fFailedPath.c_str());
+	self->fTarget.SendMessage(&message);
+	return B_OK;
+}
+
+
+/* static */ status_t
+FindInFiles::_WorkerThread(void* data)
+{
+	FindInFiles* self = static_cast<FindInFiles*>(data);
+	size_t index;
+	while((index = self->fNextIndex++) < self->fJobCount) {
+		if(self->fCancelled == true || self->fFailed == true)
+			break;
+		(self->*(self->fJob))(index);
+	}
+	return B_OK;
+}
+
+
+void
+FindInFiles::_RunParallel(size_t count, Job job)
+{
+	if(count == 0)
+		return;
+
+	fJob = job;
+	fJobCount = count;
+	fNextIndex = 0;
+
+	system_info info;
+	get_system_info(&info);
+	size_t workers = std::min(static_cast<size_t>(std::max(info.cpu_count, (uint32) 1)), count);
+	std::vector<thread_id> threads;
+	for(size_t i = 1; i < workers; i++) {
+		thread_id thread = spawn_thread(_WorkerThread, "find in files worker",
+			B_LOW_PRIORITY, this);
+		if(thread >= 0 && resume_thread(thread) == B_OK)
+			threads.push_back(thread);
+	}
+	// calling thread takes part in the work as well
+	_WorkerThread(this);
+	for(auto thread : threads) {
+		status_t exitValue;
+		wait_for_thread(thread, &exitValue);
+	}
+}
+
+
+void
+FindInFiles::_CollectFiles(const std::string& folder)
+{
+	BDirectory directory(folder.c_str());
+	if(directory.InitCheck() != B_OK)
+		return;
+
+	BEntry entry;
+	char name[B_FILE_NAME_LENGTH];
+	while(directory.GetNextEntry(&entry) == B_OK && fCancelled == false) {
+		if(entry.GetName(name) != B_OK || name[0] == '.')
+			continue;
+			// skip hidden files and VCS directories
+		std::string path = folder + "/" + name;
+		if(entry.IsDirectory() == true) {
+			_CollectFiles(path);
+		} else if(entry.IsFile() == true && _MatchesFilter(name) == true) {
+			fFiles.push_back(path);
+		}
+	}
+}
+
+
+bool
+FindInFiles::_MatchesFilter(const char* name) const
+{
+	if(fFilters.empty() == true)
+		return true;
+	for(const auto& filter : fFilters) {
+		if(fnmatch(filter.c_str(), name, 0) == 0)
+			return true;
+	}
+	return false;
+}
+
+
+void
+FindInFiles::_ScanFile(size_t index)
+{
+	FileChange& change = fChanges[index];
+	change.path = fFiles[index];
+	change.count = 0;
+
+	std::string contents;
+	if(_ReadFile(change.path, contents) != B_OK)
+		return;
+	const char* text = contents.data();
+	const size_t length = contents.length();
+	if(memchr(text, '\0', std::min(length, kBinaryProbeLength)) != nullptr)
+		return;
+	if(IsStreaming() == true) {
+		change.count = _StreamMatches(change.path, text, length);
+		return;
+	}
+
+	Searcher::Match match;
+	size_t pos = 0;
+	size_t lineCountedTo = 0;
+	int32 line = 0;
+	size_t lastPreviewLineEnd = 0;
+	bool hasPreview = false;
+	while(pos <= length && fSearcher.Find(text, length, pos, length, match) == true) {
+		change.count++;
+		pos = (match.end > match.start) ? match.end : match.end + 1;
+		if(change.previews.size() == kMaxPreviewsPerFile
+				|| (hasPreview == true && match.start < lastPreviewLineEnd))
+			continue;
+
+		for(const char* nl; (nl = static_cast<const char*>(memchr(text + lineCountedTo,
+				'\n', match.start - lineCountedTo))) != nullptr;) {
+			line++;
+			lineCountedTo = nl - text + 1;
+		}
+		const char* lineStart = text + lineCountedTo;
+		const char* lineEnd = static_cast<const char*>(
+			memchr(text + match.start, '\n', length - match.start));
+		if(lineEnd == nullptr)
+			lineEnd = text + length;
+
+		LinePreview preview;
+		preview.line = line + 1;
+		preview.before = TrimPreview(lineStart, lineEnd);
+		std::string after(lineStart, text + match.start);
+		Searcher::Match replaced;
+		fSearcher.ReplaceAll(text, length, match.start, lineEnd - text,
+			after, replaced);
+		after.append(text + replaced.end, lineEnd);
+		preview.after = TrimPreview(after.data(), after.data() + after.size());
+		change.previews.push_back(preview);
+		hasPreview = true;
+		lastPreviewLineEnd = lineEnd - text;
+	}
+}
+
+
+size_t
+FindInFiles::_StreamMatches(const std::string& path, const char* text,
+	size_t length)
+{
+	std::vector<SearchResultsView::Match> matches;
+	Searcher::Match match;
+	size_t count = 0;
+	size_t pos = 0;
+	size_t lineStart = 0;
+	size_t counted = 0;
+	int32 line = 0;
+	while(pos <= length && fCancelled == false
+			&& fSearcher.Find(text, length, pos, length, match) == true) {
+		count++;
+		pos = (match.end > match.start) ? match.end : match.end + 1;
+
+		for(const char* nl; (nl = static_cast<const char*>(memchr(text + counted,
+				'\n', match.start - counted))) != nullptr;) {
+			line++;
+			counted = lineStart = nl - text + 1;
+		}
+		counted = match.start;
+		const char* lineEnd = static_cast<const char*>(
+			memchr(text + match.start, '\n', length - match.start));
+		const size_t end = (lineEnd != nullptr)
+			? std::min(match.end, static_cast<size_t>(lineEnd - text)) : match.end;
+
+		SearchResultsView::Match result;
+		result.offset = lineStart;
+		result.line = line;
+		result.column = match.start - lineStart;
+		result.length = end - match.start;
+		matches.push_back(result);
+		if(matches.size() == kResultsBatchSize) {
+			BMessage message(SEARCHRESULTS_ADD);
+			SearchResultsView::AddToMessage(&message, path.c_str(), matches);
+			fResultsTarget.SendMessage(&message);
+			matches.clear();
+		}
+	}
+	if(matches.empty() == false) {
+		BMessage message(SEARCHRESULTS_ADD);
+		SearchResultsView::AddToMessage(&message, path.c_str(), matches);
+		fResultsTarget.SendMessage(&message);
+	}
+	return count;
+}
+
+
+void
+FindInFiles::_WriteTemporary(size_t index)
+{
+	const std::string& path = fChanges[fToReplace[index]].path;
+	std::string contents;
+	if(_ReadFile(path, contents) != B_OK) {
+		_Fail(path);
+		return;
+	}
+
+	std::string output;
+	Searcher::Match replaced;
+	size_t count = fSearcher.ReplaceAll(contents.data(), contents.length(), 0,
+		contents.length(), output, replaced);
+	if(count == 0)
+		return;
+		// changed on disk since the scan, nothing to do anymore
+
+	const std::string temporary = _SiblingPath(path, kTemporarySuffix);
+	BFile file(temporary.c_str(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+	fWritten[index] = 1;
+		// from now on there is something to clean up
+	if(file.InitCheck() != B_OK) {
+		_Fail(path);
+		return;
+	}
+	const size_t suffixLength = contents.length() - replaced.end;
+	if(file.Write(contents.data(), replaced.start) != (ssize_t) replaced.start
+		|| file.Write(output.data(), output.size()) != (ssize_t) output.size()
+		|| file.Write(contents.data() + replaced.end, suffixLength) != (ssize_t) suffixLength
+		|| file.Sync() != B_OK
+		|| _CopyMetadata(path, temporary) != B_OK) {
+		_Fail(path);
+	}
+}
+
+
+status_t
+FindInFiles::_Commit()
+{
+	std::vector<size_t> committed;
+	status_t status = B_OK;
+	for(size_t i = 0; i < fToReplace.size(); i++) {
+		if(fWritten[i] == 0)
+			continue;
+		const std::string& path = fChanges[fToReplace[i]].path;
+		const std::string backup = _SiblingPath(path, kBackupSuffix);
+		// the original stays in place until rename() replaces it atomically,
+		// so the path never goes missing
+		unlink(backup.c_str());
+		if(link(path.c_str(), backup.c_str()) != 0
+				&& _CopyFile(path, backup) != B_OK) {
+			status = B_ERROR;
+		} else if(rename(_SiblingPath(path, kTemporarySuffix).c_str(), path.c_str()) != 0) {
+			unlink(backup.c_str());
+			status = B_ERROR;
+		}
+		if(status != B_OK) {
+			_Fail(path);
+			break;
+		}
+		committed.push_back(i);
+	}
+	if(status != B_OK) {
+		// roll back everything swapped so far
+		for(auto it = committed.rbegin(); it != committed.rend(); ++it) {
+			const std::string& path = fChanges[fToReplace[*it]].path;
+			rename(_SiblingPath(path, kBackupSuffix).c_str(), path.c_str());
+		}
+	}
+	return status;
+}
+
+
+void
+FindInFiles::_Fail(const std::string& path)
+{
+	BAutolock lock(fFailedLock);
+	if(fFailed == false)
+		fFailedPath = path;
+	fFailed = true;
+}
+
+
+/* static */ status_t
+FindInFiles::_ReadFile(const std::string& path, std::string& contents)
+{
+	BFile file(path.c_str(), B_READ_ONLY);
+	status_t status = file.InitCheck();
+	if(status != B_OK)
+		return status;
+	off_t size;
+	status = file.GetSize(&size);
+	if(status != B_OK)
+		return status;
+	contents.resize(size);
+	ssize_t bytesRead = file.Read(&contents[0], size);
+	if(bytesRead < 0)
+		return bytesRead;
+	contents.resize(bytesRead);
+	return B_OK;
+}
+
+
+// For file systems without hard links.
+/* static */ status_t
+FindInFiles::_CopyFile(const std::string& from, const std::string& to)
+{
+	std::string contents;
+	status_t status = _ReadFile(from, contents);
+	if(status != B_OK)
+		return status;
+	BFile file(to.c_str(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+	status = file.InitCheck();
+	if(status != B_OK)
+		return status;
+	if(file.Write(contents.data(), contents.size()) != (ssize_t) contents.size()
+			|| file.Sync() != B_OK) {
+		unlink(to.c_str());
+		return B_IO_ERROR;
+	}
+	return _CopyMetadata(from, to);
+}
+
+
+/* static */ status_t
+FindInFiles::_CopyMetadata(const std::string& from, const std::string& to)
+{
+	BNode source(from.c_str());
+	BNode target(to.c_str());
+	// owner first, changing it clears set-user-ID bits; a file of someone
+	// else is not replaced by one of ours
+	uid_t owner;
+	gid_t group;
+	status_t status = source.GetOwner(&owner);
+	if(status == B_OK)
+		status = source.GetGroup(&group);
+	uid_t targetOwner;
+	gid_t targetGroup;
+	if(status == B_OK)
+		status = target.GetOwner(&targetOwner);
+	if(status == B_OK)
+		status = target.GetGroup(&targetGroup);
+	if(status == B_OK && targetOwner != owner)
+		status = target.SetOwner(owner);
+	if(status == B_OK && targetGroup != group)
+		status = target.SetGroup(group);
+	mode_t permissions;
+	if(status == B_OK)
+		status = source.GetPermissions(&permissions);
+	if(status == B_OK)
+		status = target.SetPermissions(permissions);
+	if(status != B_OK)
+		return status;
+
+	// MIME type, caret position and other attributes live in the node, so
+	// they would be lost on rename without copying them over
+	char name[B_ATTR_NAME_LENGTH];
+	std::vector<char> buffer;
+	source.RewindAttrs();
+	while(source.GetNextAttrName(name) == B_OK) {
+		attr_info info;
+		if(source.GetAttrInfo(name, &info) != B_OK)
+			continue;
+		buffer.resize(info.size);
+		ssize_t size = source.ReadAttr(name, info.type, 0, buffer.data(), info.size);
+		if(size >= 0)
+			target.WriteAttr(name, info.type, 0, buffer.data(), size);
+	}
+	return B_OK;
+}
+
+
+/* static */ std::string
+FindInFiles::_SiblingPath(const std::string& path, const char* suffix)
+{
+	size_t slash = path.rfind('/');
+	size_t leaf = (slash == std::string::npos ? 0 : slash + 1);
+	return path.substr(0, leaf) + "." + path.substr(leaf) + suffix;
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef FINDINFILES_H
+#define FINDINFILES_H
+
+
+#include <Locker.h>
+#include <Messenger.h>
+#include <OS.h>
+#include <String.h>
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Searcher.h"
+
+
+enum {
+	FINDINFILES_SCANNED		= 'fifs',
+	FINDINFILES_REPLACED	= 'fifr'
+};
+
+
+/*
+ * Finds matches in all files under a folder and rewrites them on request.
+ * Both passes run on worker threads, results are reported to the target
+ * messenger with a "findInFiles" pointer and "status" of the operation.
+ */
+class FindInFiles {
+public:
+	struct LinePreview {
+		int32		line;
+		std::string	before;
+		std::string	after;
+	};
+	struct FileChange {
+		std::string					path;
+		size_t						count;
+		std::vector<LinePreview>	previews;
+	};
+
+								FindInFiles(const BMessenger& target,
+									const char* folder, const char* filter,
+									const char* findText, const char* replaceText,
+									bool matchCase, bool matchWord, bool regex);
+								~FindInFiles();
+
+			// Sends matches to target as SEARCHRESULTS_ADD messages instead
+			// of collecting replacement previews. Call before Scan().
+			void				StreamResults(const BMessenger& target)
+									{ fResultsTarget = target; }
+			bool				IsStreaming() const
+									{ return fResultsTarget.IsValid(); }
+			const BMessenger&	ResultsTarget() const { return fResultsTarget; }
+
+			status_t			Scan();
+			// Files in skipPaths are left alone, they are open and get
+			// the replacement through their windows once the rest is
+			// written.
+			status_t			Replace(const std::set<std::string>& skipPaths);
+			void				Cancel();
+
+			const char*			Folder() const { return fFolder.c_str(); }
+			const char*			FindText() const { return fFindText.c_str(); }
+			const char*			ReplaceText() const { return fReplaceText.c_str(); }
+			bool				MatchCase() const { return fMatchCase; }
+			bool				MatchWord() const { return fMatchWord; }
+			bool				Regex() const { return fRegex; }
+			bool				IsValid() const { return fSearcher.IsValid(); }
+
+			const std::vector<FileChange>&	Changes() const { return fChanges; }
+			size_t				TotalCount() const;
+			size_t				FilesScanned() const { return fFiles.size(); }
+			const char*			FailedPath() const { return fFailedPath.c_str(); }
+			const std::set<std::string>&	SkippedPaths() const
+									{ return fSkippedPaths; }
+
+private:
+	typedef	void				(FindInFiles::*Job)(size_t index);
+
+	static	status_t			_ScanThread(void* data);
+	static	status_t			_ReplaceThread(void* data);
+	static	status_t			_WorkerThread(void* data);
+
+			void				_RunParallel(size_t count, Job job);
+			void				_CollectFiles(const std::string& folder);
+			bool				_MatchesFilter(const char* name) const;
+			void				_ScanFile(size_t index);
+			size_t				_StreamMatches(const std::string& path,
+										const char* text, size_t length);
+			void				_WriteTemporary(size_t index);
+			status_t			_Commit();
+			void				_Fail(const std::string& path);
+
+	static	status_t			_ReadFile(const std::string& path,
+									std::string& contents);
+	static	status_t			_CopyFile(const std::string& from,
+									const std::string& to);
+	static	status_t			_CopyMetadata(const std::string& from,
+									const std::string& to);
+	static	std::string			_SiblingPath(const std::string& path,
+									const char* suffix);
+
+			BMessenger			fTarget;
+			BMessenger			fResultsTarget;
+			std::string			fFolder;
+			std::vector<std::string>	fFilters;
+			std::string			fFindText;
+			std::string			fReplaceText;
+			bool				fMatchCase;
+			bool				fMatchWord;
+			bool				fRegex;
+			Searcher			fSearcher;
+
+			thread_id			fThread;
+			std::atomic<bool>	fCancelled;
+			std::atomic<bool>	fFailed;
+			std::atomic<size_t>	fNextIndex;
+			size_t				fJobCount;
+			Job					fJob;
+
+			std::vector<std::string>	fFiles;
+			std::vector<FileChange>		fChanges;
+			std::vector<size_t>			fToReplace;
+			std::set<std::string>		fSkippedPaths;
+			std::vector<uint8>			fWritten;
+			BLocker				fFailedLock;
+			std::string			fFailedPath;
+};
+
+
+#endif // FINDINFILES_H
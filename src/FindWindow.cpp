@@ -44,7 +44,10 @@ FindWindow::MessageReceived(BMessage* message)
 		case FINDWINDOW_FIND:
 		case FINDWINDOW_REPLACE:
 		case FINDWINDOW_REPLACEFIND:
-		case FINDWINDOW_REPLACEALL: {
+		case FINDWINDOW_REPLACEALL:
+		case FINDWINDOW_REPLACEINFILES:
+		case FINDWINDOW_FINDALL:
+		case FINDWINDOW_FINDINFILES: {
 			bool newSearch = (fFlagsChanged
 				|| fOldFindText != fFindTC->Text()
 				|| fOldReplaceText != fReplaceTC->Text());
@@ -55,12 +58,19 @@ FindWindow::MessageReceived(BMessage* message)
 				(fMatchCaseCB->Value() == B_CONTROL_ON ? true : false));
 			message->AddBool("matchWord",
 				(fMatchWordCB->Value() == B_CONTROL_ON ? true : false));
+			message->AddBool("regex",
+				(fRegexCB->Value() == B_CONTROL_ON ? true : false));
 			message->AddBool("wrapAround",
 				(fWrapAroundCB->Value() == B_CONTROL_ON ? true : false));
 			message->AddBool("backwards",
 				(fDirectionUpRadio->Value() == B_CONTROL_ON ? true : false));
 			message->AddString("findText", fFindTC->Text());
 			message->AddString("replaceText", fReplaceTC->Text());
+			if(message->what == FINDWINDOW_REPLACEINFILES
+					|| message->what == FINDWINDOW_FINDINFILES) {
+				message->AddString("folder", fFolderTC->Text());
+				message->AddString("filter", fFilterTC->Text());
+			}
 			be_app->PostMessage(message);
 			fOldFindText = fFindTC->Text();
 			fOldReplaceText = fReplaceTC->Text();
@@ -73,6 +83,7 @@ FindWindow::MessageReceived(BMessage* message)
 		} break;
 		case Actions::MATCH_CASE:
 		case Actions::MATCH_WORD:
+		case Actions::REGEX:
 		case Actions::WRAP_AROUND:
 		case Actions::DIRECTION_UP:
 		case Actions::DIRECTION_DOWN:
@@ -110,6 +121,10 @@ FindWindow::_InitInterface()
 	fReplaceString = new BStringView("replaceString", B_TRANSLATE("Replace:"));
 	fFindTC = new BTextControl("findText", "", "", nullptr);
 	fReplaceTC = new BTextControl("replaceText", "", "", nullptr);
+	fFolderString = new BStringView("folderString", B_TRANSLATE("In folder:"));
+	fFilterString = new BStringView("filterString", B_TRANSLATE("Files:"));
+	fFolderTC = new BTextControl("folder", "", "", nullptr);
+	fFilterTC = new BTextControl("filter", "", "*", nullptr);
 
 	fFindButton = new BButton(B_TRANSLATE("Find"), new BMessage((uint32) FINDWINDOW_FIND));
 	fFindButton->MakeDefault(true);
@@ -120,9 +135,16 @@ FindWindow::_InitInterface()
 	fReplaceFindButton->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, B_SIZE_UNSET));
 	fReplaceAllButton = new BButton(B_TRANSLATE("Replace all"), new BMessage((uint32) FINDWINDOW_REPLACEALL));
 	fReplaceAllButton->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, B_SIZE_UNSET));
+	fReplaceInFilesButton = new BButton(B_TRANSLATE("Replace in files" B_UTF8_ELLIPSIS), new BMessage((uint32) FINDWINDOW_REPLACEINFILES));
+	fReplaceInFilesButton->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, B_SIZE_UNSET));
+	fFindAllButton = new BButton(B_TRANSLATE("Find all"), new BMessage((uint32) FINDWINDOW_FINDALL));
+	fFindAllButton->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, B_SIZE_UNSET));
+	fFindInFilesButton = new BButton(B_TRANSLATE("Find in files"), new BMessage((uint32) FINDWINDOW_FINDINFILES));
+	fFindInFilesButton->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, B_SIZE_UNSET));
 
 	fMatchCaseCB = new BCheckBox("matchCase", B_TRANSLATE("Match case"), new BMessage((uint32) Actions::MATCH_CASE));
 	fMatchWordCB = new BCheckBox("matchWord", B_TRANSLATE("Match entire words"), new BMessage((uint32) Actions::MATCH_WORD));
+	fRegexCB = new BCheckBox("regex", B_TRANSLATE("Regular expression"), new BMessage((uint32) Actions::REGEX));
 	fWrapAroundCB = new BCheckBox("wrapAround", B_TRANSLATE("Wrap around"), new BMessage((uint32) Actions::WRAP_AROUND));
 	fInSelectionCB =  new BCheckBox("inSelection", B_TRANSLATE("In selection"), new BMessage((uint32) Actions::IN_SELECTION));
 
@@ -144,20 +166,28 @@ FindWindow::_InitInterface()
 				.Add(fFindTC, 1, 0)
 				.Add(fReplaceString, 0, 1)
 				.Add(fReplaceTC, 1, 1)
+				.Add(fFolderString, 0, 2)
+				.Add(fFolderTC, 1, 2)
+				.Add(fFilterString, 0, 3)
+				.Add(fFilterTC, 1, 3)
 			.End()
 			.AddGrid(1, 1)
 				.Add(fMatchCaseCB, 0, 0)
 				.Add(fWrapAroundCB, 1, 0)
 				.Add(fMatchWordCB, 0, 1)
 				.Add(fInSelectionCB, 1, 1)
-				.Add(fDirectionBox, 0, 2)
+				.Add(fRegexCB, 0, 2)
+				.Add(fDirectionBox, 0, 3)
 			.End()
 		.End()
 		.AddGroup(B_VERTICAL, 5)
 			.Add(fFindButton)
+			.Add(fFindAllButton)
+			.Add(fFindInFilesButton)
 			.Add(fReplaceButton)
 			.Add(fReplaceFindButton)
 			.Add(fReplaceAllButton)
+			.Add(fReplaceInFilesButton)
 			.AddGlue()
 		.End()
 		.SetInsets(5, 5, 5, 5);
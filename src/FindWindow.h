@@ -25,6 +25,9 @@ enum {
 	FINDWINDOW_REPLACE		= 'fwrp',
 	FINDWINDOW_REPLACEFIND	= 'fwrf',
 	FINDWINDOW_REPLACEALL	= 'fwra',
+	FINDWINDOW_REPLACEINFILES	= 'fwri',
+	FINDWINDOW_FINDALL		= 'fwfa',
+	FINDWINDOW_FINDINFILES	= 'fwfi',
 	FINDWINDOW_QUITTING		= 'FWQU'
 };
 
@@ -42,6 +45,7 @@ private:
 	enum Actions {
 		MATCH_CASE		= 'mtcs',
 		MATCH_WORD		= 'mtwd',
+		REGEX			= 'rgex',
 		WRAP_AROUND		= 'wrar',
 		DIRECTION_UP	= 'diru',
 		DIRECTION_DOWN	= 'dird',
@@ -53,14 +57,22 @@ private:
 	BTextControl*	fFindTC;
 	BStringView*	fReplaceString;
 	BTextControl*	fReplaceTC;
+	BStringView*	fFolderString;
+	BTextControl*	fFolderTC;
+	BStringView*	fFilterString;
+	BTextControl*	fFilterTC;
 
 	BButton*		fFindButton;
 	BButton*		fReplaceButton;
 	BButton*		fReplaceFindButton;
 	BButton*		fReplaceAllButton;
+	BButton*		fReplaceInFilesButton;
+	BButton*		fFindAllButton;
+	BButton*		fFindInFilesButton;
 
 	BCheckBox*		fMatchCaseCB;
 	BCheckBox*		fMatchWordCB;
+	BCheckBox*		fRegexCB;
 	BCheckBox*		fWrapAroundCB;
 	BCheckBox*		fBackwardsCB;
 	BCheckBox*		fInSelectionCB;
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "GoToSymbolWindow.h"
+
+#include <algorithm>
+
+#include <Button.h>
+#include <Catalog.h>
+#include <GroupLayout.h>
+#include <LayoutBuilder.h>
+#include <ListItem.h>
+#include <ListView.h>
+#include <MessageFilter.h>
+#include <ScrollView.h>
+#include <String.h>
+#include <TextControl.h>
+
+#include "GoToLineWindow.h"
+
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "GoToSymbolWindow"
+
+
+namespace {
+
+const size_t kMaxListed = 200;
+
+}
+
+
+GoToSymbolWindow::GoToSymbolWindow(BWindow* owner)
+	:
+	BWindow(BRect(0, 0, 0, 0), B_TRANSLATE("Go to symbol"), B_MODAL_WINDOW_LOOK,
+		B_MODAL_SUBSET_WINDOW_FEEL,
+		B_NOT_RESIZABLE | B_NOT_MOVABLE | B_AUTO_UPDATE_SIZE_LIMITS),
+	fOwner(owner)
+{
+	fName = new BTextControl("GoToSymbolTC", B_TRANSLATE("Symbol:"), "", NULL);
+	fName->SetModificationMessage(new BMessage(GTSW_FILTER));
+	fList = new BListView("SymbolsList", B_SINGLE_SELECTION_LIST);
+	fList->SetInvocationMessage(new BMessage(GTSW_GO));
+	BScrollView* listScroll = new BScrollView("SymbolsScroll", fList, 0,
+		false, true);
+	listScroll->SetExplicitMinSize(BSize(360, 240));
+	fGo = new BButton("GoButton", B_TRANSLATE("Go"), new BMessage(GTSW_GO));
+	fGo->MakeDefault(true);
+	fCancel = new BButton("CancelButton", B_TRANSLATE("Cancel"), new BMessage(GTSW_CANCEL));
+
+	AddCommonFilter(new BMessageFilter(B_KEY_DOWN, KeyDownFilter));
+
+	AddToSubset(fOwner);
+
+	BGroupLayout* layout = new BGroupLayout(B_VERTICAL, 5);
+	layout->SetInsets(5, 5, 5, 5);
+	SetLayout(layout);
+	layout->View()->SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+	BLayoutBuilder::Group<>(layout)
+		.Add(fName)
+		.Add(listScroll)
+		.AddGroup(B_HORIZONTAL, 5)
+			.Add(fCancel)
+			.Add(fGo)
+		.End();
+}
+
+
+void
+GoToSymbolWindow::MessageReceived(BMessage* message)
+{
+	switch(message->what) {
+	case GTSW_FILTER:
+		_Filter();
+	break;
+	case GTSW_MOVE:
+		_SelectNext(message->GetInt32("offset", 0));
+	break;
+	case GTSW_GO: {
+		const int32 selected = std::max(fList->CurrentSelection(), (int32) 0);
+		if(selected < static_cast<int32>(fLines.size())) {
+			BMessage go(GTLW_GO);
+			go.AddInt32("line", fLines[selected] + 1);
+			fOwner->PostMessage(&go);
+		}
+	}
+	case GTSW_CANCEL:
+		Hide();
+	break;
+	default:
+		BWindow::MessageReceived(message);
+	break;
+	}
+}
+
+
+void
+GoToSymbolWindow::ShowCentered(BRect ownerRect,
+	const std::vector<SymbolIndex::Symbol>& symbols)
+{
+	fSymbols = symbols;
+	_Filter();
+	CenterIn(ownerRect);
+	Show();
+}
+
+
+void
+GoToSymbolWindow::WindowActivated(bool active)
+{
+	fName->MakeFocus();
+	fName->TextView()->SelectAll();
+}
+
+
+filter_result
+GoToSymbolWindow::KeyDownFilter(BMessage* message, BHandler** target,
+	BMessageFilter* messageFilter)
+{
+	if(message->what == B_KEY_DOWN) {
+		const char* bytes;
+		message->FindString("bytes", &bytes);
+		if(bytes[0] == B_ESCAPE) {
+			messageFilter->Looper()->PostMessage(GTSW_CANCEL);
+			return B_SKIP_MESSAGE;
+		}
+		if(bytes[0] == B_UP_ARROW || bytes[0] == B_DOWN_ARROW) {
+			// the list is moved while typing the name
+			BMessage move(GTSW_MOVE);
+			move.AddInt32("offset", bytes[0] == B_UP_ARROW ? -1 : 1);
+			messageFilter->Looper()->PostMessage(&move);
+			return B_SKIP_MESSAGE;
+		}
+	}
+	return B_DISPATCH_MESSAGE;
+}
+
+
+void
+GoToSymbolWindow::_Filter()
+{
+	std::vector<const SymbolIndex::Symbol*> found;
+	SymbolIndex::Find(fSymbols, fName->Text(), found, kMaxListed);
+
+	for(int32 i = fList->CountItems() - 1; i >= 0; i--)
+		delete fList->RemoveItem(i);
+	fLines.clear();
+	for(const SymbolIndex::Symbol* symbol : found) {
+		BString label;
+		label << symbol->name.c_str() << "  (" << symbol->line + 1 << ")";
+		fList->AddItem(new BStringItem(label.String()));
+		fLines.push_back(symbol->line);
+	}
+	if(!found.empty())
+		fList->Select(0);
+	fGo->SetEnabled(!found.empty());
+}
+
+
+void
+GoToSymbolWindow::_SelectNext(int32 offset)
+{
+	const int32 count = fList->CountItems();
+	if(count == 0)
+		return;
+	const int32 selected = std::min(std::max(fList->CurrentSelection() + offset,
+		(int32) 0), count - 1);
+	fList->Select(selected);
+	fList->ScrollToSelection();
+}
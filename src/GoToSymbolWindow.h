@@ -0,0 +1,64 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef GOTOSYMBOLWINDOW_H
+#define GOTOSYMBOLWINDOW_H
+
+
+#include <MessageFilter.h>
+#include <Window.h>
+
+#include <vector>
+
+#include "SymbolIndex.h"
+
+
+class BButton;
+class BListView;
+class BTextControl;
+
+
+enum {
+	GTSW_CANCEL				= 'gtsc',
+	GTSW_GO					= 'gtsg',
+	GTSW_FILTER				= 'gtsf',
+	GTSW_MOVE				= 'gtsm'
+};
+
+
+/*
+ * Lists symbols matching the typed name and sends GTLW_GO with the line of
+ * the chosen one to the owner.
+ */
+class GoToSymbolWindow : public BWindow {
+public:
+							GoToSymbolWindow(BWindow* owner);
+
+			void			MessageReceived(BMessage* message);
+			// Symbols are copied, the list does not change while shown.
+			void			ShowCentered(BRect ownerRect,
+								const std::vector<SymbolIndex::Symbol>& symbols);
+			void			WindowActivated(bool active);
+
+	static	filter_result	KeyDownFilter(BMessage* message, BHandler** target,
+								BMessageFilter* messageFilter);
+
+private:
+			void			_Filter();
+			void			_SelectNext(int32 offset);
+
+			BTextControl*	fName;
+			BListView*		fList;
+			BButton*		fGo;
+			BButton*		fCancel;
+
+			BWindow*		fOwner;
+			std::vector<SymbolIndex::Symbol>	fSymbols;
+			std::vector<int32>	fLines;
+				// of listed symbols
+};
+
+
+#endif // GOTOSYMBOLWINDOW_H
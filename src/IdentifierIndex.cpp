@@ -0,0 +1,662 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "IdentifierIndex.h"
+
+#include <Autolock.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
+
+#include <cctype>
+#include <cstring>
+#include <vector>
+
+
+namespace {
+
+const int32 kMaxFolderDepth = 8;
+const size_t kMaxFolderFiles = 5000;
+const off_t kMaxFileSize = 4 * 1024 * 1024;
+const bigtime_t kSettleTime = 300000;
+	// changes are reported once no job came for this long, every report
+	// restyles all C and C++ windows
+
+const char* kSourceExtensions[] = {
+	"c", "cc", "cpp", "cxx", "h", "hh", "hpp", "hxx", NULL
+};
+
+
+bool
+IsReserved(const std::string& name)
+{
+	static const std::set<std::string> reserved = {
+		"__attribute__", "__declspec", "alignas", "alignof", "const",
+		"decltype", "final", "for", "if", "noexcept", "operator", "override",
+		"return", "sizeof", "static_assert", "switch", "throw", "typeid",
+		"volatile", "while"
+	};
+	return reserved.count(name) != 0;
+}
+
+
+// Macros are left out, they are usually highlighted by the lexer already.
+void
+AddName(std::set<std::string>& names, const std::string& name)
+{
+	if(name.size() < 2 || IsReserved(name))
+		return;
+	bool lowercase = false;
+	for(size_t i = 0; i < name.size() && lowercase == false; i++)
+		lowercase = islower(static_cast<unsigned char>(name[i]));
+	if(lowercase == false)
+		return;
+	names.insert(name);
+}
+
+
+// Splits C and C++ source into identifiers and punctuation, skipping
+// comments, literals and preprocessor directives.
+class Tokenizer {
+public:
+	enum {
+		IDENTIFIER	= 'a',
+		LITERAL		= '"',
+		SCOPE		= 'S'
+			// "::"
+	};
+
+	Tokenizer(const char* text, size_t length)
+		:
+		fPos(text),
+		fEnd(text + length),
+		fLineStart(true)
+	{
+	}
+
+	// Returns a token kind, the first character for punctuation, or 0 at
+	// the end of text.
+	int Next(std::string& identifier)
+	{
+		while(fPos < fEnd) {
+			const char c = *fPos;
+			if(c == '\n') {
+				fLineStart = true;
+				fPos++;
+			} else if(isspace(static_cast<unsigned char>(c))) {
+				fPos++;
+			} else if(c == '/' && fPos + 1 < fEnd && fPos[1] == '/') {
+				_SkipLine(false);
+			} else if(c == '/' && fPos + 1 < fEnd && fPos[1] == '*') {
+				const char* end = static_cast<const char*>(
+					memmem(fPos + 2, fEnd - fPos - 2, "*/", 2));
+				fPos = end != NULL ? end + 2 : fEnd;
+			} else if(c == '#' && fLineStart == true) {
+				_SkipLine(true);
+			} else
+				break;
+		}
+		if(fPos >= fEnd)
+			return 0;
+
+		fLineStart = false;
+		const char c = *fPos;
+		if(isalpha(static_cast<unsigned char>(c)) || c == '_') {
+			const char* start = fPos;
+			while(fPos < fEnd && (isalnum(static_cast<unsigned char>(*fPos))
+					|| *fPos == '_'))
+				fPos++;
+			identifier.assign(start, fPos - start);
+			return IDENTIFIER;
+		}
+		if(isdigit(static_cast<unsigned char>(c))) {
+			while(fPos < fEnd && (isalnum(static_cast<unsigned char>(*fPos))
+					|| *fPos == '_' || *fPos == '.' || *fPos == '\''))
+				fPos++;
+			return LITERAL;
+		}
+		if(c == '"' || c == '\'') {
+			for(fPos++; fPos < fEnd && *fPos != c && *fPos != '\n'; fPos++) {
+				if(*fPos == '\\')
+					fPos++;
+			}
+			fPos++;
+			return LITERAL;
+		}
+		if(c == ':' && fPos + 1 < fEnd && fPos[1] == ':') {
+			fPos += 2;
+			return SCOPE;
+		}
+		fPos++;
+		return c;
+	}
+
+private:
+	void _SkipLine(bool continued)
+	{
+		for(; fPos < fEnd && *fPos != '\n'; fPos++) {
+			if(continued == true && *fPos == '\\' && fPos + 1 < fEnd
+					&& fPos[1] == '\n')
+				fPos++;
+		}
+	}
+
+	const char*	fPos;
+	const char*	fEnd;
+	bool		fLineStart;
+};
+
+
+// What is known about the declaration being read, at namespace or class
+// scope. Function bodies and initializers are skipped as a whole.
+struct Statement {
+	Statement() { Reset(); }
+
+	void Reset()
+	{
+		collectingType = false;
+		isEnum = false;
+		typeBody = false;
+		typeIdentifiers = 0;
+		typeName.clear();
+		isNamespace = false;
+		isTypedef = false;
+		typedefDepth = 0;
+		typedefName.clear();
+		typedefPointerName.clear();
+		isUsing = false;
+		assigned = false;
+		initializer = false;
+		parens = 0;
+		function.clear();
+	}
+
+	bool		collectingType;
+		// after class, struct, union or enum
+	bool		isEnum;
+	bool		typeBody;
+		// base clause was seen, the body follows
+	int			typeIdentifiers;
+	std::string	typeName;
+	bool		isNamespace;
+		// or extern "C"
+	bool		isTypedef;
+	size_t		typedefDepth;
+	std::string	typedefName;
+	std::string	typedefPointerName;
+		// for function pointers, like typedef void (*name)(int);
+	bool		isUsing;
+	bool		assigned;
+	bool		initializer;
+		// constructor initializer list
+	int			parens;
+	std::string	function;
+};
+
+
+struct Brace {
+	enum Kind { NAMESPACE, TYPE, BLOCK, INITIALIZER };
+
+	Kind		kind;
+	Statement	outer;
+		// continued after a type body
+};
+
+}
+
+
+BLocker IdentifierIndex::sLock("IdentifierIndex");
+BMessenger IdentifierIndex::sTarget;
+thread_id IdentifierIndex::sThread = -1;
+sem_id IdentifierIndex::sJobsSem = -1;
+std::deque<IdentifierIndex::Job> IdentifierIndex::sJobs;
+bool IdentifierIndex::sQuitting = false;
+std::set<std::string> IdentifierIndex::sFolders;
+std::set<std::string> IdentifierIndex::sDocuments;
+std::map<std::string, std::set<std::string>> IdentifierIndex::sSources;
+std::map<std::string, uint32> IdentifierIndex::sNames;
+uint32 IdentifierIndex::sVersion = 0;
+std::string IdentifierIndex::sKeywords;
+uint32 IdentifierIndex::sKeywordsVersion = 0;
+
+
+/* static */ void
+IdentifierIndex::Start(const BMessenger& target)
+{
+	sTarget = target;
+	sJobsSem = create_sem(0, "identifier index jobs");
+	sThread = spawn_thread(&IdentifierIndex::_WorkerThread,
+		"identifier index", B_LOW_PRIORITY, NULL);
+	resume_thread(sThread);
+}
+
+
+/* static */ void
+IdentifierIndex::Stop()
+{
+	if(sThread < 0)
+		return;
+	sLock.Lock();
+	sQuitting = true;
+	sLock.Unlock();
+	release_sem(sJobsSem);
+	status_t result;
+	wait_for_thread(sThread, &result);
+	delete_sem(sJobsSem);
+	sThread = -1;
+}
+
+
+/* static */ void
+IdentifierIndex::AddFolder(const char* folder)
+{
+	BAutolock lock(sLock);
+	if(sFolders.insert(folder).second == false)
+		return;
+	Job job = { Job::FOLDER, folder, std::string() };
+	_Push(job);
+}
+
+
+/* static */ void
+IdentifierIndex::UpdateDocument(const char* path, const char* text,
+	size_t length)
+{
+	if(length > kMaxFileSize)
+		return;
+	BAutolock lock(sLock);
+	sDocuments.insert(path);
+	Job job = { Job::DOCUMENT, path, std::string(text, length) };
+	_Push(job);
+}
+
+
+/* static */ void
+IdentifierIndex::CloseDocument(const char* path)
+{
+	BAutolock lock(sLock);
+	if(sDocuments.erase(path) == 0)
+		return;
+	Job job = { Job::FILE, path, std::string() };
+	_Push(job);
+}
+
+
+/* static */ std::string
+IdentifierIndex::Keywords()
+{
+	BAutolock lock(sLock);
+	if(sKeywordsVersion != sVersion) {
+		sKeywords.clear();
+		for(const auto& name : sNames) {
+			if(!sKeywords.empty())
+				sKeywords += ' ';
+			sKeywords += name.first;
+		}
+		sKeywordsVersion = sVersion;
+	}
+	return sKeywords;
+}
+
+
+/* static */ uint32
+IdentifierIndex::Version()
+{
+	BAutolock lock(sLock);
+	return sVersion;
+}
+
+
+/* static */ bool
+IdentifierIndex::IsSource(const char* filename)
+{
+	const char* extension = strrchr(filename, '.');
+	if(extension == NULL)
+		return false;
+	for(int32 i = 0; kSourceExtensions[i] != NULL; i++) {
+		if(strcasecmp(extension + 1, kSourceExtensions[i]) == 0)
+			return true;
+	}
+	return false;
+}
+
+
+// Only declarations at namespace and class scope are looked at, so local
+// types and variables do not get in.
+/* static */ void
+IdentifierIndex::Scan(const char* text, size_t length,
+	std::set<std::string>& names)
+{
+	Tokenizer tokenizer(text, length);
+	std::vector<Brace> braces;
+	size_t codeDepth = 0;
+		// braces of function bodies and initializers
+	Statement statement;
+	std::string identifier;
+	std::string lastIdentifier;
+	int previous = 0;
+	int token;
+	while((token = tokenizer.Next(identifier)) != 0) {
+		if(codeDepth > 0) {
+			if(token == '{') {
+				braces.push_back(Brace{ Brace::BLOCK, Statement() });
+				codeDepth++;
+			} else if(token == '}') {
+				const Brace::Kind kind = braces.back().kind;
+				braces.pop_back();
+				codeDepth--;
+				if(codeDepth == 0 && kind == Brace::BLOCK)
+					statement.Reset();
+			}
+			previous = token;
+			continue;
+		}
+
+		switch(token) {
+			case Tokenizer::IDENTIFIER: {
+				if(identifier == "class" || identifier == "struct"
+						|| identifier == "union" || identifier == "enum") {
+					if(statement.collectingType == true && statement.isEnum == true)
+						break;
+						// enum class
+					statement.collectingType = true;
+					statement.isEnum = identifier == "enum";
+					statement.typeBody = false;
+					statement.typeIdentifiers = 0;
+					statement.typeName.clear();
+				} else if(identifier == "namespace" || identifier == "extern") {
+					statement.isNamespace = true;
+				} else if(identifier == "typedef") {
+					statement.isTypedef = true;
+					statement.typedefDepth = braces.size();
+				} else if(identifier == "using") {
+					statement.isUsing = true;
+				} else if(statement.collectingType == true) {
+					statement.typeIdentifiers++;
+					if(!IsReserved(identifier))
+						statement.typeName = identifier;
+				} else if(statement.isTypedef == true
+						&& statement.typedefDepth == braces.size()) {
+					if(statement.parens == 0)
+						statement.typedefName = identifier;
+					else if(previous == '*' && statement.typedefPointerName.empty())
+						statement.typedefPointerName = identifier;
+				}
+				lastIdentifier = identifier;
+			} break;
+			case '(': {
+				statement.collectingType = false;
+				if(statement.parens == 0 && previous == Tokenizer::IDENTIFIER
+						&& statement.assigned == false
+						&& statement.initializer == false
+						&& !IsReserved(lastIdentifier))
+					statement.function = lastIdentifier;
+				statement.parens++;
+			} break;
+			case ')': {
+				if(statement.parens > 0)
+					statement.parens--;
+			} break;
+			case '=': {
+				if(statement.parens == 0) {
+					if(statement.isUsing == true && previous == Tokenizer::IDENTIFIER)
+						AddName(names, lastIdentifier);
+					statement.assigned = true;
+				}
+				statement.collectingType = false;
+			} break;
+			case '<':
+			case '>':
+			case ',': {
+				statement.collectingType = false;
+			} break;
+			case ':': {
+				if(previous == Tokenizer::IDENTIFIER && (lastIdentifier == "public"
+						|| lastIdentifier == "protected" || lastIdentifier == "private")) {
+					statement.Reset();
+				} else if(statement.collectingType == true) {
+					if(statement.typeIdentifiers > 0)
+						AddName(names, statement.typeName);
+					statement.collectingType = false;
+					statement.typeBody = true;
+				} else if(statement.parens == 0 && !statement.function.empty()) {
+					statement.initializer = true;
+				}
+			} break;
+			case ';': {
+				if(statement.collectingType == true && statement.typeIdentifiers == 1)
+					AddName(names, statement.typeName);
+						// forward declaration
+				if(statement.isTypedef == true
+						&& statement.typedefDepth == braces.size()) {
+					AddName(names, statement.typedefPointerName.empty()
+						? statement.typedefName : statement.typedefPointerName);
+				}
+				statement.Reset();
+			} break;
+			case '{': {
+				Brace brace = { Brace::BLOCK, Statement() };
+				if(statement.collectingType == true || statement.typeBody == true) {
+					if(statement.collectingType == true && statement.typeIdentifiers > 0)
+						AddName(names, statement.typeName);
+					statement.collectingType = false;
+					brace.kind = statement.isEnum ? Brace::INITIALIZER : Brace::TYPE;
+				} else if(statement.isNamespace == true) {
+					brace.kind = Brace::NAMESPACE;
+				} else if(!statement.function.empty() && statement.assigned == false
+						&& statement.parens == 0) {
+					AddName(names, statement.function);
+				} else if(statement.assigned == true) {
+					brace.kind = Brace::INITIALIZER;
+				}
+				if(brace.kind == Brace::TYPE || brace.kind == Brace::NAMESPACE) {
+					brace.outer = statement;
+					statement.Reset();
+				} else
+					codeDepth++;
+				braces.push_back(brace);
+			} break;
+			case '}': {
+				if(braces.empty())
+					break;
+					// unbalanced, probably because of #if
+				if(braces.back().kind == Brace::TYPE)
+					statement = braces.back().outer;
+				else
+					statement.Reset();
+				braces.pop_back();
+			} break;
+		}
+		previous = token;
+	}
+}
+
+
+/* static */ status_t
+IdentifierIndex::_WorkerThread(void* data)
+{
+	bool changed = false;
+	while(true) {
+		const status_t status = acquire_sem_etc(sJobsSem, 1, B_RELATIVE_TIMEOUT,
+			changed ? kSettleTime : B_INFINITE_TIMEOUT);
+		if(status == B_OK) {
+			sLock.Lock();
+			if(sQuitting == true) {
+				sLock.Unlock();
+				break;
+			}
+			Job job = sJobs.front();
+			sJobs.pop_front();
+			sLock.Unlock();
+			if(_Run(job) == true)
+				changed = true;
+		} else if(status != B_TIMED_OUT && status != B_INTERRUPTED)
+			break;
+
+		if(changed == true && status == B_TIMED_OUT) {
+			sTarget.SendMessage(IDENTIFIERINDEX_CHANGED);
+			changed = false;
+		}
+	}
+	return B_OK;
+}
+
+
+// Called with sLock held.
+/* static */ void
+IdentifierIndex::_Push(Job& job)
+{
+	if(sThread < 0)
+		return;
+	if(job.kind == Job::DOCUMENT) {
+		// only the latest text of a document matters
+		for(auto& queued : sJobs) {
+			if(queued.kind == Job::DOCUMENT && queued.path == job.path) {
+				queued.text.swap(job.text);
+				return;
+			}
+		}
+	}
+	if(job.kind == Job::DOCUMENT)
+		sJobs.push_front(Job());
+	else
+		sJobs.push_back(Job());
+	Job& queued = job.kind == Job::DOCUMENT ? sJobs.front() : sJobs.back();
+	queued.kind = job.kind;
+	queued.path.swap(job.path);
+	queued.text.swap(job.text);
+	release_sem(sJobsSem);
+}
+
+
+/* static */ bool
+IdentifierIndex::_Run(const Job& job)
+{
+	switch(job.kind) {
+		case Job::FOLDER:
+			return _IndexFolder(job.path);
+		case Job::FILE:
+			return _IndexFile(job.path);
+		case Job::DOCUMENT: {
+			std::set<std::string> names;
+			Scan(job.text.data(), job.text.size(), names);
+			BAutolock lock(sLock);
+			if(sDocuments.count(job.path) == 0)
+				return false;
+				// closed in the meantime, the file is queued
+			return _SetNames(job.path, names);
+		}
+	}
+	return false;
+}
+
+
+// Files are queued separately, so that documents being edited do not
+// wait for the whole folder.
+/* static */ bool
+IdentifierIndex::_IndexFolder(const std::string& folder)
+{
+	std::deque<std::string> files;
+	_CollectFiles(folder, 0, files);
+	BAutolock lock(sLock);
+	for(auto& path : files) {
+		Job job = { Job::FILE, std::string(), std::string() };
+		job.path.swap(path);
+		_Push(job);
+	}
+	return false;
+}
+
+
+/* static */ void
+IdentifierIndex::_CollectFiles(const std::string& folder, int32 depth,
+	std::deque<std::string>& files)
+{
+	BDirectory directory(folder.c_str());
+	if(directory.InitCheck() != B_OK)
+		return;
+
+	BEntry entry;
+	char name[B_FILE_NAME_LENGTH];
+	while(directory.GetNextEntry(&entry) == B_OK
+			&& files.size() < kMaxFolderFiles) {
+		if(entry.GetName(name) != B_OK || name[0] == '.')
+			continue;
+			// skip hidden files and VCS directories
+		std::string path = folder + "/" + name;
+		if(entry.IsDirectory() == true) {
+			if(depth < kMaxFolderDepth)
+				_CollectFiles(path, depth + 1, files);
+		} else if(entry.IsFile() == true && IsSource(name) == true) {
+			files.push_back(path);
+		}
+	}
+}
+
+
+/* static */ bool
+IdentifierIndex::_IndexFile(const std::string& path)
+{
+	{
+		BAutolock lock(sLock);
+		if(sDocuments.count(path) != 0)
+			return false;
+	}
+
+	std::set<std::string> names;
+	BFile file(path.c_str(), B_READ_ONLY);
+	off_t size;
+	if(file.InitCheck() == B_OK && file.GetSize(&size) == B_OK
+			&& size <= kMaxFileSize) {
+		std::string contents(size, '\0');
+		const ssize_t bytesRead = file.Read(&contents[0], size);
+		if(bytesRead > 0)
+			Scan(contents.data(), bytesRead, names);
+	}
+
+	BAutolock lock(sLock);
+	if(sDocuments.count(path) != 0)
+		return false;
+		// opened in the meantime
+	return _SetNames(path, names);
+}
+
+
+// Called with sLock held. Returns true if the set of all names changed.
+/* static */ bool
+IdentifierIndex::_SetNames(const std::string& path,
+	std::set<std::string>& names)
+{
+	std::set<std::string>& source = sSources[path];
+	if(source == names) {
+		if(names.empty())
+			sSources.erase(path);
+		return false;
+	}
+
+	bool changed = false;
+	for(const auto& name : source) {
+		if(names.count(name) != 0)
+			continue;
+		auto counted = sNames.find(name);
+		if(--counted->second == 0) {
+			sNames.erase(counted);
+			changed = true;
+		}
+	}
+	for(const auto& name : names) {
+		if(source.count(name) != 0)
+			continue;
+		if(sNames[name]++ == 0)
+			changed = true;
+	}
+	if(names.empty())
+		sSources.erase(path);
+	else
+		source.swap(names);
+	if(changed == true)
+		sVersion++;
+	return changed;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef IDENTIFIERINDEX_H
+#define IDENTIFIERINDEX_H
+
+
+#include <Locker.h>
+#include <Messenger.h>
+#include <OS.h>
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+
+
+enum {
+	IDENTIFIERINDEX_CHANGED	= 'iich'
+};
+
+
+/*
+ * Names of types and functions defined in C and C++ sources of open
+ * documents and folders they live in. Sources are scanned on a worker
+ * thread and only the one that changed is rescanned. The target is sent
+ * IDENTIFIERINDEX_CHANGED once changes settle down, not for every source.
+ */
+class IdentifierIndex {
+public:
+	static	void					Start(const BMessenger& target);
+	static	void					Stop();
+
+	// Indexes sources below folder, each folder is scanned once.
+	static	void					AddFolder(const char* folder);
+	// Indexes text instead of the file at path, which is open for editing.
+	static	void					UpdateDocument(const char* path,
+										const char* text, size_t length);
+	// Goes back to the file at path, if it still exists.
+	static	void					CloseDocument(const char* path);
+
+	// Space separated, as expected by SCI_SETKEYWORDS.
+	static	std::string				Keywords();
+	static	uint32					Version();
+
+	static	bool					IsSource(const char* filename);
+	static	void					Scan(const char* text, size_t length,
+										std::set<std::string>& names);
+
+private:
+	struct Job {
+		enum Kind { FOLDER, FILE, DOCUMENT };
+		Kind						kind;
+		std::string					path;
+		std::string					text;
+	};
+
+	static	status_t				_WorkerThread(void* data);
+	static	void					_Push(Job& job);
+	static	bool					_Run(const Job& job);
+	static	bool					_IndexFolder(const std::string& folder);
+	static	void					_CollectFiles(const std::string& folder,
+										int32 depth, std::deque<std::string>& files);
+	static	bool					_IndexFile(const std::string& path);
+	static	bool					_SetNames(const std::string& path,
+										std::set<std::string>& names);
+
+	static	BLocker					sLock;
+	static	BMessenger				sTarget;
+	static	thread_id				sThread;
+	static	sem_id					sJobsSem;
+	static	std::deque<Job>			sJobs;
+	static	bool					sQuitting;
+	static	std::set<std::string>	sFolders;
+	static	std::set<std::string>	sDocuments;
+		// paths which are indexed from the editor, not from disk
+	static	std::map<std::string, std::set<std::string>>	sSources;
+	static	std::map<std::string, uint32>	sNames;
+		// with the number of sources defining them
+	static	uint32					sVersion;
+	static	std::string				sKeywords;
+	static	uint32					sKeywordsVersion;
+};
+
+
+#endif // IDENTIFIERINDEX_H
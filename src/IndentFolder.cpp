@@ -0,0 +1,162 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "IndentFolder.h"
+
+#include <algorithm>
+
+#include "Editor.h"
+
+
+namespace {
+
+const int kMaxIndentation = SC_FOLDLEVELNUMBERMASK - SC_FOLDLEVELBASE;
+
+
+// Columns taken by spaces and tabs at the beginning of the line, as
+// SCI_GETLINEINDENTATION counts them.
+int
+LineIndentation(const char* text, Sci_Position length, int tabWidth, bool& blank)
+{
+	int indentation = 0;
+	Sci_Position i = 0;
+	for(; i < length; i++) {
+		if(text[i] == ' ')
+			indentation++;
+		else if(text[i] == '\t')
+			indentation = (indentation / tabWidth + 1) * tabWidth;
+		else
+			break;
+	}
+	blank = i == length || text[i] == '\r' || text[i] == '\n';
+	return std::min(indentation, kMaxIndentation);
+}
+
+}
+
+
+IndentFolder::IndentFolder(Editor* editor)
+	:
+	fEditor(editor),
+	fEnabled(false),
+	fTabWidth(8)
+{
+}
+
+
+void
+IndentFolder::SetEnabled(bool enabled)
+{
+	if(enabled == true) {
+		// lexers which fold would overwrite the levels when styling
+		fEditor->SendMessage(SCI_SETPROPERTY, (uptr_t) "fold", (sptr_t) "0");
+	}
+	if(enabled == fEnabled)
+		return;
+	fEnabled = enabled;
+	const int32 lineCount = fEditor->SendMessage(SCI_GETLINECOUNT, 0, 0);
+	if(fEnabled == true) {
+		fTabWidth = fEditor->SendMessage(SCI_GETTABWIDTH, 0, 0);
+		_Refold(0, lineCount - 1);
+	} else {
+		// folded blocks are expanded as their headers go
+		for(int32 line = 0; line < lineCount; line++)
+			fEditor->SendMessage(SCI_SETFOLDLEVEL, line, SC_FOLDLEVELBASE);
+	}
+}
+
+
+void
+IndentFolder::Modified(const SCNotification* notification)
+{
+	const bool inserted = (notification->modificationType & SC_MOD_INSERTTEXT) != 0;
+	if(fEnabled == false || (inserted == false
+			&& (notification->modificationType & SC_MOD_DELETETEXT) == 0))
+		return;
+
+	const int32 first = fEditor->SendMessage(SCI_LINEFROMPOSITION,
+		notification->position, 0);
+	const int32 last = inserted ? fEditor->SendMessage(SCI_LINEFROMPOSITION,
+		notification->position + notification->length, 0) : first;
+	_Refold(first, last);
+}
+
+
+void
+IndentFolder::TabWidthChanged()
+{
+	const int tabWidth = fEditor->SendMessage(SCI_GETTABWIDTH, 0, 0);
+	if(tabWidth == fTabWidth)
+		return;
+	fTabWidth = tabWidth;
+	if(fEnabled == true)
+		_Refold(0, fEditor->SendMessage(SCI_GETLINECOUNT, 0, 0) - 1);
+}
+
+
+int
+IndentFolder::_Indentation(int32 line, bool& blank) const
+{
+	const Sci_Position start = fEditor->SendMessage(SCI_POSITIONFROMLINE, line, 0);
+	const Sci_Position end = fEditor->SendMessage(SCI_GETLINEENDPOSITION, line, 0);
+	const char* text = reinterpret_cast<const char*>(fEditor->SendMessage(
+		SCI_GETRANGEPOINTER, start, end - start));
+	return LineIndentation(text, end - start, fTabWidth, blank);
+}
+
+
+// Lines from first to last have changed. A line has the level of its
+// indentation and is a header when the next non-blank line is indented
+// more. Blank lines take the level of the next non-blank line, so they
+// belong to the block that goes on after them.
+void
+IndentFolder::_Refold(int32 first, int32 last)
+{
+	const int32 lineCount = fEditor->SendMessage(SCI_GETLINECOUNT, 0, 0);
+	// blank lines before the changed ones depend on them, and so does the
+	// header flag of the line before those
+	while(first > 0) {
+		bool blank;
+		_Indentation(--first, blank);
+		if(blank == false)
+			break;
+	}
+	int next = 0;
+		// indentation of the next non-blank line
+	for(int32 line = last + 1; line < lineCount; line++) {
+		bool blank;
+		const int indentation = _Indentation(line, blank);
+		if(blank == false) {
+			next = indentation;
+			break;
+		}
+	}
+
+	const Sci_Position start = fEditor->SendMessage(SCI_POSITIONFROMLINE, first, 0);
+	Sci_Position lineEnd = last + 1 < lineCount
+		? fEditor->SendMessage(SCI_POSITIONFROMLINE, last + 1, 0)
+		: fEditor->SendMessage(SCI_GETLENGTH, 0, 0);
+	const char* text = reinterpret_cast<const char*>(fEditor->SendMessage(
+		SCI_GETRANGEPOINTER, start, lineEnd - start));
+	for(int32 line = last; line >= first; line--) {
+		const Sci_Position lineStart = line == first ? start
+			: fEditor->SendMessage(SCI_POSITIONFROMLINE, line, 0);
+		bool blank;
+		const int indentation = LineIndentation(text + (lineStart - start),
+			lineEnd - lineStart, fTabWidth, blank);
+		int level;
+		if(blank == true)
+			level = (SC_FOLDLEVELBASE + next) | SC_FOLDLEVELWHITEFLAG;
+		else {
+			level = SC_FOLDLEVELBASE + indentation;
+			if(next > indentation)
+				level |= SC_FOLDLEVELHEADERFLAG;
+			next = indentation;
+		}
+		// unchanged levels are not notified by Scintilla
+		fEditor->SendMessage(SCI_SETFOLDLEVEL, line, level);
+		lineEnd = lineStart;
+	}
+}
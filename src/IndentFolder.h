@@ -0,0 +1,47 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef INDENTFOLDER_H
+#define INDENTFOLDER_H
+
+
+#include <SupportDefs.h>
+
+#include <Scintilla.h>
+
+
+class Editor;
+
+
+/*
+ * Sets fold levels from indentation for languages whose lexer does not
+ * fold. A line's level only depends on its own indentation and that of the
+ * next non-blank line, so an edit refolds the lines it touched and the
+ * blank ones before them, never the blocks around.
+ */
+class IndentFolder {
+public:
+							IndentFolder(Editor* editor);
+
+			// Call after the lexer is set, as lexer folding is turned off.
+			void			SetEnabled(bool enabled);
+			bool			IsEnabled() const { return fEnabled; }
+			// Call for SCN_MODIFIED.
+			void			Modified(const SCNotification* notification);
+			// Refolds the document if the tab width is not the one it was
+			// folded with.
+			void			TabWidthChanged();
+
+private:
+			int				_Indentation(int32 line, bool& blank) const;
+			void			_Refold(int32 first, int32 last);
+
+			Editor*			fEditor;
+			bool			fEnabled;
+			int				fTabWidth;
+};
+
+
+#endif // INDENTFOLDER_H
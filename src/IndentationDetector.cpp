@@ -0,0 +1,121 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "IndentationDetector.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "Editor.h"
+
+
+namespace {
+
+const int32 kSamples = 16;
+const int32 kSampleLines = 64;
+	// consecutive lines in each sample, indentation changes between them
+	// are counted
+const int32 kMaxIndentation = 256;
+	// characters looked at, deeper indentation is cut
+const int32 kMaxWidth = 8;
+const int32 kMinChanges = 4;
+
+struct Indentation {
+	int32	tabs;
+	int32	spaces;
+	bool	mixed;
+		// spaces and tabs, likely alignment
+	bool	skipped;
+		// blank or continuing a comment
+};
+
+
+Indentation
+LineIndentation(Editor* editor, int32 line)
+{
+	const Sci_Position start = editor->SendMessage(SCI_POSITIONFROMLINE, line, 0);
+	const Sci_Position end = std::min(start + kMaxIndentation,
+		editor->SendMessage(SCI_GETLINEENDPOSITION, line, 0));
+	const char* text = reinterpret_cast<const char*>(
+		editor->SendMessage(SCI_GETRANGEPOINTER, start, end - start));
+	Indentation indentation = { 0, 0, false, false };
+	Sci_Position i = 0;
+	for(; i < end - start && (text[i] == ' ' || text[i] == '\t'); i++) {
+		if(text[i] == ' ')
+			indentation.spaces++;
+		else
+			indentation.tabs++;
+	}
+	indentation.mixed = indentation.tabs > 0 && indentation.spaces > 0;
+	indentation.skipped = i == end - start || text[i] == '*';
+	return indentation;
+}
+
+}
+
+
+/* static */ const float IndentationDetector::kMinConfidence = 0.6f;
+
+
+// Tabs win if more lines change their indentation by tabs than by spaces.
+// The width is the most common change among lines indented with spaces,
+// and its confidence the share of changes which are multiples of it.
+/* static */ IndentationDetector::Result
+IndentationDetector::Detect(Editor* editor)
+{
+	const int32 lineCount = editor->SendMessage(SCI_GETLINECOUNT, 0, 0);
+	const int32 samples = std::max<int32>(1,
+		std::min<int32>(kSamples, lineCount / kSampleLines));
+	int32 tabChanges = 0;
+	int32 spaceChanges = 0;
+	int32 widths[kMaxWidth + 1] = {};
+	for(int32 sample = 0; sample < samples; sample++) {
+		const int32 first = samples == 1 ? 0
+			: static_cast<int64>(lineCount - kSampleLines) * sample / (samples - 1);
+		const int32 last = std::min(lineCount, first + kSampleLines);
+		Indentation previous = { 0, 0, false, true };
+		for(int32 line = first; line < last; line++) {
+			const Indentation current = LineIndentation(editor, line);
+			if(current.skipped == true)
+				continue;
+			if(previous.skipped == false && current.mixed == false
+					&& previous.mixed == false) {
+				if(current.tabs == 0 && previous.tabs == 0) {
+					const int32 delta = abs(current.spaces - previous.spaces);
+					if(delta > 0) {
+						spaceChanges++;
+						if(delta <= kMaxWidth)
+							widths[delta]++;
+					}
+				} else if(current.spaces == 0 && previous.spaces == 0
+						&& current.tabs != previous.tabs)
+					tabChanges++;
+			}
+			previous = current;
+		}
+	}
+
+	Result result;
+	const int32 changes = tabChanges + spaceChanges;
+	if(changes < kMinChanges)
+		return result;
+	const bool useTabs = tabChanges > spaceChanges;
+	result.confidence = static_cast<float>(std::max(tabChanges, spaceChanges))
+		/ changes;
+	int32 width = 0;
+	if(useTabs == false) {
+		width = std::max_element(widths + 1, widths + kMaxWidth + 1) - widths;
+		int32 multiples = 0;
+		for(int32 delta = width; delta <= kMaxWidth; delta += width)
+			multiples += widths[delta];
+		result.confidence *= static_cast<float>(multiples) / spaceChanges;
+	}
+	if(result.confidence >= kMinConfidence) {
+		result.useTabs = useTabs;
+		if(useTabs == false)
+			result.width = width;
+	}
+	return result;
+}
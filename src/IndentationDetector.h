@@ -0,0 +1,40 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef INDENTATIONDETECTOR_H
+#define INDENTATIONDETECTOR_H
+
+
+#include <SupportDefs.h>
+
+
+class Editor;
+
+
+/*
+ * Guesses whether a document is indented with tabs or spaces and by how
+ * many spaces. Only runs of lines at a fixed number of places spread over
+ * the document are looked at, so the cost does not grow with its size.
+ */
+class IndentationDetector {
+public:
+	struct Result {
+					Result() : useTabs(-1), width(-1), confidence(0) {}
+
+		int			useTabs;
+			// -1 if not sure
+		int			width;
+			// of indentation with spaces, -1 if not sure or tabs are used
+		float		confidence;
+			// 0 to 1, the guess is only made above kMinConfidence
+	};
+
+	static	const float	kMinConfidence;
+
+	static	Result		Detect(Editor* editor);
+};
+
+
+#endif // INDENTATIONDETECTOR_H
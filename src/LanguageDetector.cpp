@@ -0,0 +1,214 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "LanguageDetector.h"
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+
+namespace {
+
+const size_t kModelineLines = 5;
+	// Vim looks at this many lines at the top and bottom
+
+std::string
+FirstLine(const char* text, size_t length)
+{
+	const char* eol = static_cast<const char*>(memchr(text, '\n', length));
+	size_t end = eol != NULL ? eol - text : length;
+	if(end > 0 && text[end - 1] == '\r')
+		end--;
+	return std::string(text, end);
+}
+
+}
+
+
+LanguageDetector::LanguageDetector(const LanguageListTable& table)
+	:
+	fExtensions(table.extensions.begin(), table.extensions.end()),
+	fFilenames(table.filenames),
+	fAliases(table.aliases)
+{
+	// languages can always be referred to by their own name
+	for(const auto& language : table.languages)
+		fAliases.insert(std::make_pair(language.first, language.first));
+	for(const auto& rule : table.firstLines) {
+		try {
+			fFirstLines.push_back(std::make_pair(std::regex(rule.first,
+				std::regex::ECMAScript | std::regex::optimize), rule.second));
+		} catch(std::regex_error&) {
+			// ignore invalid rules
+		}
+	}
+}
+
+
+bool
+LanguageDetector::Detect(const char* filename, const char* text,
+	size_t length, std::string& lang) const
+{
+	length = std::min(length, kMaxSniffed);
+	if(_FromFilename(filename, lang) == true)
+		return true;
+
+	if(length > 0) {
+		const std::string line = FirstLine(text, length);
+		if(line.compare(0, 2, "#!") == 0 && _FromShebang(line, lang) == true)
+			return true;
+		if(_FromModeline(text, length, lang) == true)
+			return true;
+		if(line.compare(0, 5, "<?xml") == 0 || line.compare(0, 8, "\xEF\xBB\xBF<?xml") == 0)
+			return _FromAlias("xml", lang);
+		for(const auto& rule : fFirstLines) {
+			if(std::regex_search(line, rule.first)) {
+				lang = rule.second;
+				return true;
+			}
+		}
+	}
+
+	// templates like config.h.in are detected by what they produce
+	const size_t nameLength = strlen(filename);
+	if(nameLength > 3 && strcmp(filename + nameLength - 3, ".in") == 0) {
+		const std::string stripped(filename, nameLength - 3);
+		if(_FromFilename(stripped.c_str(), lang) == true)
+			return true;
+	}
+	lang = "text";
+	return false;
+}
+
+
+bool
+LanguageDetector::FromExtension(const std::string& extension,
+	std::string& lang) const
+{
+	auto found = std::lower_bound(fExtensions.begin(), fExtensions.end(),
+		std::make_pair(extension, std::string()));
+	if(found != fExtensions.end() && found->first == extension) {
+		lang = found->second;
+		return true;
+	}
+	return false;
+}
+
+
+bool
+LanguageDetector::_FromFilename(const char* filename, std::string& lang) const
+{
+	// try to match whole filename first, this is needed for e.g. CMake
+	if(FromExtension(filename, lang) == true)
+		return true;
+	const char* extension = strrchr(filename, '.');
+	if(extension != nullptr && FromExtension(extension + 1, lang) == true)
+		return true;
+	for(const auto& rule : fFilenames) {
+		if(fnmatch(rule.first.c_str(), filename, 0) == 0) {
+			lang = rule.second;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// #!/bin/sh, #!/usr/bin/env python3 -u
+bool
+LanguageDetector::_FromShebang(const std::string& line, std::string& lang) const
+{
+	size_t start = line.find_first_not_of(" \t", 2);
+	if(start == std::string::npos)
+		return false;
+	size_t end = line.find_first_of(" \t", start);
+	std::string interpreter = line.substr(start, end - start);
+	interpreter = interpreter.substr(interpreter.rfind('/') + 1);
+	if(interpreter == "env" && end != std::string::npos) {
+		start = line.find_first_not_of(" \t", end);
+		while(start != std::string::npos && line[start] == '-') {
+			// skip env options
+			end = line.find_first_of(" \t", start);
+			start = line.find_first_not_of(" \t", end);
+		}
+		if(start == std::string::npos)
+			return false;
+		end = line.find_first_of(" \t", start);
+		interpreter = line.substr(start, end - start);
+	}
+	if(_FromAlias(interpreter, lang) == true)
+		return true;
+	// python3.6 -> python
+	const size_t version = interpreter.find_last_not_of("0123456789.");
+	if(version == std::string::npos || version + 1 == interpreter.size())
+		return false;
+	return _FromAlias(interpreter.substr(0, version + 1), lang);
+}
+
+
+// -*- mode: python -*-, -*- c++ -*-, vim: set ft=python:, vi: filetype=sh
+bool
+LanguageDetector::_FromModeline(const char* text, size_t length,
+	std::string& lang) const
+{
+	const char* end = text + length;
+	for(size_t i = 0; i < kModelineLines && text < end; i++) {
+		const char* eol = static_cast<const char*>(memchr(text, '\n', end - text));
+		if(eol == NULL)
+			eol = end;
+		const std::string line(text, eol);
+		text = eol + 1;
+
+		const size_t emacs = line.find("-*-");
+		if(emacs != std::string::npos) {
+			const size_t close = line.find("-*-", emacs + 3);
+			std::string mode = line.substr(emacs + 3,
+				close == std::string::npos ? std::string::npos : close - emacs - 3);
+			const size_t key = mode.find("mode:");
+			if(key != std::string::npos)
+				mode = mode.substr(key + 5);
+			else if(mode.find(':') != std::string::npos)
+				continue;
+			mode = mode.substr(0, mode.find(';'));
+			const size_t first = mode.find_first_not_of(" \t");
+			const size_t last = mode.find_last_not_of(" \t");
+			if(first != std::string::npos
+					&& _FromAlias(mode.substr(first, last - first + 1), lang) == true)
+				return true;
+		}
+
+		size_t vim = line.find("vim:");
+		if(vim == std::string::npos)
+			vim = line.find("vi:");
+		if(vim == std::string::npos)
+			continue;
+		const char* keys[] = { "filetype=", "ft=", "syntax=", "syn=" };
+		for(auto key : keys) {
+			const size_t found = line.find(key, vim);
+			if(found == std::string::npos)
+				continue;
+			const size_t start = found + strlen(key);
+			const size_t stop = line.find_first_of(" \t:", start);
+			if(_FromAlias(line.substr(start, stop - start), lang) == true)
+				return true;
+		}
+	}
+	return false;
+}
+
+
+bool
+LanguageDetector::_FromAlias(std::string alias, std::string& lang) const
+{
+	std::transform(alias.begin(), alias.end(), alias.begin(), ::tolower);
+	auto found = fAliases.find(alias);
+	if(found == fAliases.end())
+		return false;
+	lang = found->second;
+	return true;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef LANGUAGEDETECTOR_H
+#define LANGUAGEDETECTOR_H
+
+
+#include <map>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "DataTables.h"
+
+
+/*
+ * Picks a language for a file from its name and beginning. Rules come from
+ * languages.yaml and are compiled once, detection only looks at the first
+ * kMaxSniffed bytes.
+ */
+class LanguageDetector {
+public:
+	static	const size_t	kMaxSniffed = 4096;
+
+							LanguageDetector(const LanguageListTable& table);
+
+			bool			Detect(const char* filename, const char* text,
+								size_t length, std::string& lang) const;
+			bool			FromExtension(const std::string& extension,
+								std::string& lang) const;
+
+private:
+			bool			_FromFilename(const char* filename,
+								std::string& lang) const;
+			bool			_FromShebang(const std::string& line,
+								std::string& lang) const;
+			bool			_FromModeline(const char* text, size_t length,
+								std::string& lang) const;
+			bool			_FromAlias(std::string alias,
+								std::string& lang) const;
+
+			std::vector<std::pair<std::string, std::string>>	fExtensions;
+				// sorted by extension
+			std::vector<std::pair<std::string, std::string>>	fFilenames;
+			std::map<std::string, std::string>	fAliases;
+			std::vector<std::pair<std::regex, std::string>>	fFirstLines;
+};
+
+
+#endif // LANGUAGEDETECTOR_H
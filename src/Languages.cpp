@@ -6,145 +6,222 @@
 #include "Languages.h"
 
 #include <algorithm>
+#include <cstring>
 #include <map>
 #include <string>
 
+#include <Autolock.h>
 #include <Catalog.h>
-#include <FindDirectory.h>
-#include <Path.h>
 #include <String.h>
 
 #include <SciLexer.h>
-#include <yaml.h>
 
+#include "DataLoader.h"
 #include "Editor.h"
-#include "EditorWindow.h"
 
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "Languages"
 
 
-std::vector<std::string>			Languages::sLanguages;
-std::map<std::string, std::string>	Languages::sMenuItems;
-std::map<std::string, std::string> 	Languages::sExtensions;
+BLocker								Languages::sLock("Languages");
+std::map<std::string, Languages::DefinitionPtr>	Languages::sDefinitions;
+std::unique_ptr<Languages::Catalog>	Languages::sCatalog;
+uint32								Languages::sCatalogVersion = 1;
 
 
 /* static */ bool
-Languages::GetLanguageForExtension(const std::string ext, std::string& lang)
+Languages::DetectLanguage(const char* filename, const char* text,
+	size_t length, std::string& lang)
 {
-	lang = "text";
-	if(sExtensions.count(ext) > 0) {
-		lang = sExtensions[ext];
-		return true;
-	}
-	return false;
+	BAutolock lock(sLock);
+	return _Catalog().detector->Detect(filename, text, length, lang);
+}
+
+
+/* static */ Languages::MenuModel
+Languages::GetMenuModel(bool compact)
+{
+	BAutolock lock(sLock);
+	Catalog& catalog = _Catalog();
+	MenuModel& model = catalog.menus[compact ? 1 : 0];
+	if(!model)
+		model = _BuildMenuModel(catalog, compact);
+	return model;
 }
 
 
-/* static */ void
-Languages::SortAlphabetically()
+/* static */ uint32
+Languages::CatalogVersion()
 {
-	std::sort(sLanguages.begin(), sLanguages.end());
+	BAutolock lock(sLock);
+	return sCatalogVersion;
 }
 
 
-/* static */ void
+/* static */ std::string
 Languages::ApplyLanguage(Editor* editor, const char* lang)
 {
-	BPath dataPath;
-	find_directory(B_SYSTEM_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyLanguage(editor, lang, dataPath);
-	} catch (YAML::BadFile &) {
+	const DefinitionPtr definitionPtr = _Definition(lang);
+	const LanguageTable& definition = *definitionPtr;
+	const LanguageTable::Profile* profile = _PickProfile(editor, definition);
+	int lexer = definition.lexer;
+	if(profile != NULL && profile->lexer != -1)
+		lexer = profile->lexer;
+	if(lexer != -1) {
+		editor->SendMessage(SCI_SETLEXER, static_cast<uptr_t>(lexer), 0);
 	}
-	find_directory(B_USER_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyLanguage(editor, lang, dataPath);
-	} catch (YAML::BadFile &) {
+	for(const auto& property : definition.properties) {
+		editor->SendMessage(SCI_SETPROPERTY, (uptr_t) property.first.c_str(),
+			(sptr_t) property.second.c_str());
 	}
-	find_directory(B_SYSTEM_NONPACKAGED_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyLanguage(editor, lang, dataPath);
-	} catch (YAML::BadFile &) {
+	if(profile != NULL) {
+		for(const auto& property : profile->properties) {
+			editor->SendMessage(SCI_SETPROPERTY, (uptr_t) property.first.c_str(),
+				(sptr_t) property.second.c_str());
+		}
 	}
-	find_directory(B_USER_NONPACKAGED_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyLanguage(editor, lang, dataPath);
-	} catch (YAML::BadFile &) {
+	// identifiers are set by ApplyIdentifiers(), every set sent relexes
+	for(const auto& keywords : definition.keywords) {
+		if(keywords.first == definition.identifiers)
+			continue;
+		editor->SendMessage(SCI_SETKEYWORDS, keywords.first,
+			(sptr_t) keywords.second.c_str());
 	}
+	return profile != NULL ? profile->name : std::string();
 }
 
 
-/* static */ void
-Languages::_ApplyLanguage(Editor* editor, const char* lang, const BPath &path)
+/* static */ bool
+Languages::ApplyIdentifiers(Editor* editor, const char* lang,
+	const std::string& identifiers)
 {
-	BPath p(path);
-	p.Append(gAppName);
-	p.Append("languages");
-	p.Append(lang);
-	const YAML::Node language = YAML::LoadFile(std::string(p.Path()) + ".yaml");
-	int lexerID = language["lexer"].as<int>();
-	editor->SendMessage(SCI_SETLEXER, static_cast<uptr_t>(lexerID), 0);
-
-	const YAML::Node properties = language["properties"];
-	for(YAML::const_iterator it = properties.begin(); it != properties.end(); ++it) {
-		auto name = it->first.as<std::string>();
-		auto value = it->second.as<std::string>();
-		editor->SendMessage(SCI_SETPROPERTY, (uptr_t) name.c_str(), (sptr_t) value.c_str());
-	}
+	const DefinitionPtr definition = _Definition(lang);
+	if(definition->identifiers == -1)
+		return false;
+	editor->SendMessage(SCI_SETKEYWORDS, definition->identifiers,
+		(sptr_t) identifiers.c_str());
+	return true;
+}
 
-	const YAML::Node keywords = language["keywords"];
-	for(YAML::const_iterator it = keywords.begin(); it != keywords.end(); ++it) {
-		auto num = it->first.as<int>();
-		auto words = it->second.as<std::string>();
-		editor->SendMessage(SCI_SETKEYWORDS, num, (sptr_t) words.c_str());
-	}
+
+/* static */ bool
+Languages::FoldsByIndentation(const char* lang)
+{
+	return _Definition(lang)->foldByIndentation == 1;
 }
 
 
-/* static */ void
-Languages::LoadLanguages()
+/* static */ int
+Languages::BracketStyle(const char* lang, int lexer)
 {
-	BPath dataPath;
-	find_directory(B_SYSTEM_DATA_DIRECTORY, &dataPath);
-	try {
-		_LoadLanguages(dataPath);
-	} catch (YAML::BadFile &) {
-	}
-	find_directory(B_USER_DATA_DIRECTORY, &dataPath);
-	try {
-		_LoadLanguages(dataPath);
-	} catch (YAML::BadFile &) {
-	}
-	find_directory(B_SYSTEM_NONPACKAGED_DATA_DIRECTORY, &dataPath);
-	try {
-		_LoadLanguages(dataPath);
-	} catch (YAML::BadFile &) {
+	const DefinitionPtr definition = _Definition(lang);
+	return definition->lexer == lexer ? definition->bracketStyle : -1;
+}
+
+
+/* static */ bool
+Languages::Invalidate(const std::string& name)
+{
+	BAutolock lock(sLock);
+	if(name == "languages") {
+		sCatalog.reset();
+		sCatalogVersion++;
+		return true;
 	}
-	find_directory(B_USER_NONPACKAGED_DATA_DIRECTORY, &dataPath);
-	try {
-		_LoadLanguages(dataPath);
-	} catch (YAML::BadFile &) {
+	if(name.compare(0, 10, "languages/") != 0)
+		return false;
+	sDefinitions.erase(name.substr(10));
+	return true;
+}
+
+
+/* static */ Languages::DefinitionPtr
+Languages::_Definition(const char* lang)
+{
+	BAutolock lock(sLock);
+	auto cached = sDefinitions.find(lang);
+	if(cached != sDefinitions.end())
+		return cached->second;
+	return sDefinitions[lang] = std::make_shared<const LanguageTable>(
+		DataLoader::LoadLanguage(lang));
+}
+
+
+// The last profile whose size or line length is reached wins.
+/* static */ const LanguageTable::Profile*
+Languages::_PickProfile(Editor* editor, const LanguageTable& definition)
+{
+	if(definition.profiles.empty())
+		return NULL;
+	const int64 length = editor->SendMessage(SCI_GETLENGTH, 0, 0);
+	int64 longestLine = -1;
+	const LanguageTable::Profile* picked = NULL;
+	for(const auto& profile : definition.profiles) {
+		bool matches = profile.size > 0 && length >= (int64) profile.size * 1024;
+		if(matches == false && profile.lineLength > 0) {
+			if(longestLine == -1) {
+				// measured only when some profile needs it
+				const char* text = reinterpret_cast<const char*>(
+					editor->SendMessage(SCI_GETCHARACTERPOINTER, 0, 0));
+				const char* end = text + length;
+				longestLine = 0;
+				while(text < end) {
+					const char* eol = static_cast<const char*>(
+						memchr(text, '\n', end - text));
+					if(eol == NULL)
+						eol = end;
+					longestLine = std::max<int64>(longestLine, eol - text);
+					text = eol + 1;
+				}
+			}
+			matches = longestLine >= profile.lineLength;
+		}
+		if(matches == true)
+			picked = &profile;
 	}
+	return picked;
 }
 
 
-/* static */ void
-Languages::_LoadLanguages(const BPath& path)
+// Must be called with sLock held.
+/* static */ Languages::Catalog&
+Languages::_Catalog()
 {
-	BPath p(path);
-	p.Append(gAppName);
-	p.Append("languages");
-	const YAML::Node languages = YAML::LoadFile(std::string(p.Path()) + ".yaml");
-	for(YAML::const_iterator it = languages.begin(); it != languages.end(); ++it) {
-		auto name = it->first.as<std::string>();
-		auto menuitem = it->second["name"].as<std::string>();
-		auto extensions = it->second["extensions"].as<std::vector<std::string>>();
-		for(auto extension : extensions) {
-			sExtensions[extension] = name;
+	if(sCatalog)
+		return *sCatalog;
+
+	const LanguageListTable list = DataLoader::LoadLanguageList();
+	sCatalog.reset(new Catalog);
+	sCatalog->languages = list.languages;
+	std::sort(sCatalog->languages.begin(), sCatalog->languages.end());
+	sCatalog->detector.reset(new LanguageDetector(list));
+	return *sCatalog;
+}
+
+
+/* static */ Languages::MenuModel
+Languages::_BuildMenuModel(const Catalog& catalog, bool compact)
+{
+	std::vector<MenuGroup> groups;
+	if(compact == false) {
+		groups.push_back(MenuGroup());
+		groups.back().items = catalog.languages;
+		return std::make_shared<const std::vector<MenuGroup>>(groups);
+	}
+	// languages are grouped by first letter of the menu item name, groups
+	// of one are put directly in the menu
+	for(const auto& language : catalog.languages) {
+		const std::string letter = language.second.substr(0, 1);
+		if(groups.empty() || groups.back().submenu != letter) {
+			groups.push_back(MenuGroup());
+			groups.back().submenu = letter;
 		}
-		sLanguages.push_back(name);
-		sMenuItems[name] = menuitem;
+		groups.back().items.push_back(language);
+	}
+	for(auto& group : groups) {
+		if(group.items.size() == 1)
+			group.submenu.clear();
 	}
+	return std::make_shared<const std::vector<MenuGroup>>(groups);
 }
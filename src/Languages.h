@@ -7,31 +7,81 @@
 #define LANGUAGES_H
 
 
+#include <Locker.h>
+#include <SupportDefs.h>
+
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "DataTables.h"
+#include "LanguageDetector.h"
+
 
-class BPath;
 class Editor;
 
 
+/*
+ * Language list is read on first use and kept, along with the language
+ * menu built from it, until languages.yaml changes.
+ */
 class Languages {
 public:
-	static	size_t								GetCount() { return sLanguages.size(); }
-	static	std::string							GetLanguage(int index) { return sLanguages[index]; }
-	static	std::string							GetMenuItemName(std::string lang) { return sMenuItems[lang]; }
-	static	bool								GetLanguageForExtension(const std::string ext, std::string& lang);
-	static	void								SortAlphabetically();
-	static	void								ApplyLanguage(Editor* editor, const char* lang);
-	static	void								LoadLanguages();
+	struct MenuGroup {
+		std::string											submenu;
+			// empty if items go directly to the menu
+		std::vector<std::pair<std::string, std::string>>	items;
+			// language and menu item name
+	};
+	typedef std::shared_ptr<const std::vector<MenuGroup>>	MenuModel;
+
+	// text is the beginning of the file, only a few KB of it are looked at.
+	static	bool								DetectLanguage(const char* filename,
+													const char* text, size_t length,
+													std::string& lang);
+	static	MenuModel							GetMenuModel(bool compact);
+	// Changes every time the language list is reloaded.
+	static	uint32								CatalogVersion();
+	// Picks a size profile for the document in editor, returns its name or
+	// an empty string if none applies.
+	static	std::string							ApplyLanguage(Editor* editor, const char* lang);
+	// Sets the keyword set the language reserves for names defined in the
+	// project to identifiers. Returns false if it has none.
+	static	bool								ApplyIdentifiers(Editor* editor,
+													const char* lang,
+													const std::string& identifiers);
+	// Whether the language is folded by indentation, see IndentFolder.
+	static	bool								FoldsByIndentation(const char* lang);
+	// Style the language's lexer gives brackets in code, -1 if it is not
+	// known or a size profile set another lexer.
+	static	int									BracketStyle(const char* lang,
+													int lexer);
+	// Drops cached definition read from data file name, as used by
+	// DataLoader. Returns false if it does not hold a language definition.
+	static	bool								Invalidate(const std::string& name);
 
 private:
-	static	void								_LoadLanguages(const BPath& path);
-	static	void								_ApplyLanguage(Editor* editor, const char* lang, const BPath &path);
-	static	std::vector<std::string>			sLanguages;
-	static	std::map<std::string, std::string>	sMenuItems;
-	static	std::map<std::string, std::string> 	sExtensions;
+	typedef std::shared_ptr<const LanguageTable>	DefinitionPtr;
+	struct Catalog {
+		std::vector<std::pair<std::string, std::string>>	languages;
+			// language and menu item name, sorted by language
+		std::unique_ptr<LanguageDetector>					detector;
+		MenuModel											menus[2];
+			// plain and compact, built when first needed
+	};
+
+	static	DefinitionPtr						_Definition(const char* lang);
+	static	const LanguageTable::Profile*		_PickProfile(Editor* editor,
+													const LanguageTable& definition);
+	static	Catalog&							_Catalog();
+	static	MenuModel							_BuildMenuModel(const Catalog& catalog,
+													bool compact);
+	static	BLocker								sLock;
+	static	std::map<std::string, DefinitionPtr>	sDefinitions;
+		// merged from all data directories on first use
+	static	std::unique_ptr<Catalog>			sCatalog;
+	static	uint32								sCatalogVersion;
 };
 
 
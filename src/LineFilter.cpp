@@ -0,0 +1,201 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "LineFilter.h"
+
+#include <Message.h>
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace {
+
+const size_t kMinChunkSize = 1024 * 1024;
+const size_t kChunksPerCPU = 4;
+
+
+size_t
+CountLineEnds(const char* start, const char* end, char lineEnd)
+{
+	size_t count = 0;
+	while((start = static_cast<const char*>(memchr(start, lineEnd, end - start))) != nullptr) {
+		count++;
+		start++;
+	}
+	return count;
+}
+
+}
+
+
+LineFilter::LineFilter(const BMessenger& target, const char* text,
+	size_t length, char lineEnd, const std::string& pattern, bool matchCase,
+	bool regex, int32 context)
+	:
+	fTarget(target),
+	fText(text),
+	fLength(length),
+	fLineEnd(lineEnd),
+	fSearcher(pattern, "", matchCase, false, regex),
+	fContext(std::max(context, (int32) 0)),
+	fThread(-1),
+	fCancelled(false),
+	fNextChunk(0)
+{
+}
+
+
+LineFilter::~LineFilter()
+{
+	Cancel();
+	if(fThread >= 0) {
+		status_t exitValue;
+		wait_for_thread(fThread, &exitValue);
+	}
+}
+
+
+status_t
+LineFilter::Start()
+{
+	if(fSearcher.IsValid() == false)
+		return B_BAD_VALUE;
+	fThread = spawn_thread(_FilterThread, "line filter", B_LOW_PRIORITY, this);
+	if(fThread < 0)
+		return fThread;
+	return resume_thread(fThread);
+}
+
+
+void
+LineFilter::Cancel()
+{
+	fCancelled = true;
+}
+
+
+/* static */ status_t
+LineFilter::_FilterThread(void* data)
+{
+	LineFilter* self = static_cast<LineFilter*>(data);
+	self->_SplitChunks();
+
+	system_info info;
+	get_system_info(&info);
+	size_t workers = std::min(static_cast<size_t>(std::max(info.cpu_count, (uint32) 1)),
+		self->fChunks.size());
+	std::vector<thread_id> threads;
+	for(size_t i = 1; i < workers; i++) {
+		thread_id thread = spawn_thread(_WorkerThread, "line filter worker",
+			B_LOW_PRIORITY, self);
+		if(thread >= 0 && resume_thread(thread) == B_OK)
+			threads.push_back(thread);
+	}
+	_WorkerThread(self);
+	for(auto thread : threads) {
+		status_t exitValue;
+		wait_for_thread(thread, &exitValue);
+	}
+
+	if(self->fCancelled == false)
+		self->_MarkVisible();
+
+	BMessage message(LINEFILTER_FINISHED);
+	message.AddPointer("lineFilter", self);
+	message.AddInt32("status", self->fCancelled ? B_CANCELED : B_OK);
+	self->fTarget.SendMessage(&message);
+	return B_OK;
+}
+
+
+/* static */ status_t
+LineFilter::_WorkerThread(void* data)
+{
+	LineFilter* self = static_cast<LineFilter*>(data);
+	size_t index;
+	while((index = self->fNextChunk++) < self->fChunks.size()
+			&& self->fCancelled == false)
+		self->_FilterChunk(self->fChunks[index]);
+	return B_OK;
+}
+
+
+void
+LineFilter::_SplitChunks()
+{
+	system_info info;
+	get_system_info(&info);
+	size_t count = std::max(info.cpu_count, (uint32) 1) * kChunksPerCPU;
+	size_t size = std::max(fLength / count, kMinChunkSize);
+
+	size_t start = 0;
+	do {
+		size_t end = std::min(start + size, fLength);
+		if(end < fLength) {
+			// finish chunk at the end of line, so no line is split
+			const char* lineEnd = static_cast<const char*>(
+				memchr(fText + end, fLineEnd, fLength - end));
+			end = (lineEnd != nullptr) ? lineEnd - fText + 1 : fLength;
+		}
+		Chunk chunk;
+		chunk.start = start;
+		chunk.end = end;
+		chunk.lines = 0;
+		fChunks.push_back(chunk);
+		start = end;
+	} while(start < fLength);
+}
+
+
+void
+LineFilter::_FilterChunk(Chunk& chunk)
+{
+	const char* end = fText + chunk.end;
+	size_t line = 0;
+	size_t lineStart = chunk.start;
+	size_t counted = chunk.start;
+	Searcher::Match match;
+	while(lineStart < chunk.end && fCancelled == false
+			&& fSearcher.Find(fText, fLength, lineStart, chunk.end, match) == true) {
+		line += CountLineEnds(fText + counted, fText + match.start, fLineEnd);
+		chunk.matches.push_back(line);
+		// one match is enough, continue from the next line
+		const char* next = static_cast<const char*>(
+			memchr(fText + match.start, fLineEnd, end - (fText + match.start)));
+		if(next == nullptr) {
+			counted = chunk.end;
+			break;
+		}
+		line++;
+		counted = lineStart = next - fText + 1;
+	}
+	chunk.lines = line + CountLineEnds(fText + counted, end, fLineEnd);
+}
+
+
+void
+LineFilter::_MarkVisible()
+{
+	size_t lineCount = 1;
+	for(const auto& chunk : fChunks)
+		lineCount += chunk.lines;
+	fVisible.assign(lineCount, 0);
+
+	size_t firstLine = 0;
+	size_t filledTo = 0;
+	for(const auto& chunk : fChunks) {
+		for(size_t match : chunk.matches) {
+			const size_t line = firstLine + match;
+			const size_t from = std::max(filledTo,
+				line > (size_t) fContext ? line - fContext : 0);
+			const size_t to = std::min(line + fContext + 1, lineCount);
+			if(from < to)
+				std::fill(fVisible.begin() + from, fVisible.begin() + to, 1);
+			filledTo = std::max(filledTo, to);
+		}
+		firstLine += chunk.lines;
+	}
+}
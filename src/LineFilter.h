@@ -0,0 +1,78 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef LINEFILTER_H
+#define LINEFILTER_H
+
+
+#include <Messenger.h>
+#include <OS.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "Searcher.h"
+
+
+enum {
+	LINEFILTER_FINISHED		= 'lffn'
+};
+
+
+/*
+ * Marks lines matching a pattern, with given number of context lines around
+ * each match. Text is split into chunks at line boundaries and searched on
+ * worker threads. When done, LINEFILTER_FINISHED with "lineFilter" pointer
+ * and "status" is sent to the target. Text must not change until then.
+ */
+class LineFilter {
+public:
+								LineFilter(const BMessenger& target,
+									const char* text, size_t length,
+									char lineEnd, const std::string& pattern,
+									bool matchCase, bool regex, int32 context);
+								~LineFilter();
+
+			status_t			Start();
+			void				Cancel();
+
+			bool				IsValid() const { return fSearcher.IsValid(); }
+			// one entry per line, non-zero for lines which should be shown
+			const std::vector<uint8>&	Visible() const { return fVisible; }
+
+private:
+	struct Chunk {
+		size_t					start;
+		size_t					end;
+		size_t					lines;
+			// number of line ends in chunk
+		std::vector<size_t>		matches;
+			// chunk relative indices of matching lines
+	};
+
+	static	status_t			_FilterThread(void* data);
+	static	status_t			_WorkerThread(void* data);
+
+			void				_SplitChunks();
+			void				_FilterChunk(Chunk& chunk);
+			void				_MarkVisible();
+
+			BMessenger			fTarget;
+			const char*			fText;
+			size_t				fLength;
+			char				fLineEnd;
+			Searcher			fSearcher;
+			int32				fContext;
+
+			thread_id			fThread;
+			std::atomic<bool>	fCancelled;
+			std::atomic<size_t>	fNextChunk;
+			std::vector<Chunk>	fChunks;
+			std::vector<uint8>	fVisible;
+};
+
+
+#endif // LINEFILTER_H
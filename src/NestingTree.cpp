@@ -0,0 +1,308 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "NestingTree.h"
+
+#include <algorithm>
+
+
+namespace {
+
+const int32 kUnreachable = 1 << 30;
+	// depth of the empty tree, no delimiter gets there
+
+}
+
+
+struct NestingTree::Node {
+	Node*			left;
+	Node*			right;
+	uint32			priority;
+		// higher in parents
+	Sci_Position	position;
+	Sci_Position	shift;
+		// still to be added to positions in the subtree, this one included
+	int32			value;
+		// 1 for opening delimiters, -1 for closing ones
+	int32			sum;
+	int32			minPrefix;
+	int32			maxSuffix;
+		// of values over the subtree in order, prefixes and suffixes are
+		// not empty
+};
+
+
+NestingTree::NestingTree()
+	:
+	fRoot(NULL),
+	fSeed(2463534242u)
+{
+}
+
+
+NestingTree::~NestingTree()
+{
+	_Delete(fRoot);
+}
+
+
+bool
+NestingTree::Contains(Sci_Position pos) const
+{
+	const Node* node = fRoot;
+	Sci_Position shift = 0;
+	while(node != NULL) {
+		shift += node->shift;
+		const Sci_Position position = node->position + shift;
+		if(position == pos)
+			return true;
+		node = pos < position ? node->left : node->right;
+	}
+	return false;
+}
+
+
+void
+NestingTree::Shift(Sci_Position pos, Sci_Position delta)
+{
+	Node* left;
+	Node* right;
+	_Split(fRoot, pos, left, right);
+	if(right != NULL)
+		right->shift += delta;
+	fRoot = _Merge(left, right);
+}
+
+
+void
+NestingTree::Remove(Sci_Position from, Sci_Position to)
+{
+	Node* left;
+	Node* middle;
+	Node* right;
+	_Split(fRoot, from, left, right);
+	_Split(right, to, middle, right);
+	_Delete(middle);
+	fRoot = _Merge(left, right);
+}
+
+
+void
+NestingTree::Append(Sci_Position pos, int32 value)
+{
+	fRoot = _Merge(fRoot, _Create(pos, value));
+}
+
+
+void
+NestingTree::Insert(NestingTree& other)
+{
+	if(other.fRoot == NULL)
+		return;
+	Node* left;
+	Node* right;
+	_Split(fRoot, _First(other.fRoot)->position, left, right);
+	fRoot = _Merge(_Merge(left, other.fRoot), right);
+	other.fRoot = NULL;
+}
+
+
+// Opening delimiter is closed where the depth of those after it first drops
+// below zero, closing one is opened where the depth of those before it,
+// counted backwards, first rises above zero.
+Sci_Position
+NestingTree::Closing(Sci_Position pos)
+{
+	Node* left;
+	Node* right;
+	_Split(fRoot, pos + 1, left, right);
+	const Node* match = _FirstDroppingTo(right, -1);
+	const Sci_Position result = match != NULL ? match->position : -1;
+	fRoot = _Merge(left, right);
+	return result;
+}
+
+
+Sci_Position
+NestingTree::Opening(Sci_Position pos)
+{
+	Node* left;
+	Node* right;
+	_Split(fRoot, pos, left, right);
+	const Node* match = _LastRisingTo(left, 1);
+	const Sci_Position result = match != NULL ? match->position : -1;
+	fRoot = _Merge(left, right);
+	return result;
+}
+
+
+NestingTree::Node*
+NestingTree::_Create(Sci_Position position, int32 value)
+{
+	// xorshift
+	fSeed ^= fSeed << 13;
+	fSeed ^= fSeed >> 17;
+	fSeed ^= fSeed << 5;
+	Node* node = new Node;
+	node->left = node->right = NULL;
+	node->priority = fSeed;
+	node->position = position;
+	node->shift = 0;
+	node->value = value;
+	_Update(node);
+	return node;
+}
+
+
+/* static */ void
+NestingTree::_Push(Node* node)
+{
+	if(node->shift == 0)
+		return;
+	node->position += node->shift;
+	if(node->left != NULL)
+		node->left->shift += node->shift;
+	if(node->right != NULL)
+		node->right->shift += node->shift;
+	node->shift = 0;
+}
+
+
+/* static */ void
+NestingTree::_Update(Node* node)
+{
+	const Node* left = node->left;
+	const Node* right = node->right;
+	int32 sum = node->value;
+	int32 minPrefix = node->value;
+	if(left != NULL) {
+		minPrefix = std::min(left->minPrefix, left->sum + node->value);
+		sum += left->sum;
+	}
+	int32 maxSuffix = node->value;
+	if(right != NULL) {
+		minPrefix = std::min(minPrefix, sum + right->minPrefix);
+		maxSuffix = std::max(right->maxSuffix, right->sum + node->value);
+		sum += right->sum;
+	}
+	if(left != NULL)
+		maxSuffix = std::max(maxSuffix, sum - left->sum + left->maxSuffix);
+	node->sum = sum;
+	node->minPrefix = minPrefix;
+	node->maxSuffix = maxSuffix;
+}
+
+
+// Delimiters before pos go to left, the rest to right.
+/* static */ void
+NestingTree::_Split(Node* node, Sci_Position pos, Node*& left, Node*& right)
+{
+	if(node == NULL) {
+		left = right = NULL;
+		return;
+	}
+	_Push(node);
+	if(node->position < pos) {
+		_Split(node->right, pos, node->right, right);
+		left = node;
+	} else {
+		_Split(node->left, pos, left, node->left);
+		right = node;
+	}
+	_Update(node);
+}
+
+
+// All delimiters in left come before those in right.
+/* static */ NestingTree::Node*
+NestingTree::_Merge(Node* left, Node* right)
+{
+	if(left == NULL)
+		return right;
+	if(right == NULL)
+		return left;
+	if(left->priority > right->priority) {
+		_Push(left);
+		left->right = _Merge(left->right, right);
+		_Update(left);
+		return left;
+	}
+	_Push(right);
+	right->left = _Merge(left, right->left);
+	_Update(right);
+	return right;
+}
+
+
+/* static */ void
+NestingTree::_Delete(Node* node)
+{
+	if(node == NULL)
+		return;
+	_Delete(node->left);
+	_Delete(node->right);
+	delete node;
+}
+
+
+// Leftmost delimiter, with its position made exact.
+/* static */ NestingTree::Node*
+NestingTree::_First(Node* node)
+{
+	_Push(node);
+	while(node->left != NULL) {
+		node = node->left;
+		_Push(node);
+	}
+	return node;
+}
+
+
+// First delimiter at which the sum of values from the beginning of the tree
+// reaches depth, which is below zero. Positions on the way are made exact.
+/* static */ NestingTree::Node*
+NestingTree::_FirstDroppingTo(Node* node, int32 depth)
+{
+	if(node == NULL || node->minPrefix > depth)
+		return NULL;
+	while(true) {
+		_Push(node);
+		const int32 leftMin = node->left != NULL ? node->left->minPrefix
+			: kUnreachable;
+		if(leftMin <= depth) {
+			node = node->left;
+			continue;
+		}
+		const int32 sum = (node->left != NULL ? node->left->sum : 0) + node->value;
+		if(sum <= depth)
+			return node;
+		depth -= sum;
+		node = node->right;
+	}
+}
+
+
+// Last delimiter at which the sum of values to the end of the tree reaches
+// depth, which is above zero.
+/* static */ NestingTree::Node*
+NestingTree::_LastRisingTo(Node* node, int32 depth)
+{
+	if(node == NULL || node->maxSuffix < depth)
+		return NULL;
+	while(true) {
+		_Push(node);
+		const int32 rightMax = node->right != NULL ? node->right->maxSuffix
+			: -kUnreachable;
+		if(rightMax >= depth) {
+			node = node->right;
+			continue;
+		}
+		const int32 sum = (node->right != NULL ? node->right->sum : 0) + node->value;
+		if(sum >= depth)
+			return node;
+		depth -= sum;
+		node = node->left;
+	}
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef NESTINGTREE_H
+#define NESTINGTREE_H
+
+
+#include <SupportDefs.h>
+
+#include <Scintilla.h>
+
+
+/*
+ * Opening and closing delimiters in a treap ordered by position. Every
+ * subtree knows how deep it nests, so the delimiter closing another one and
+ * the one enclosing a position are found by descending a single path.
+ * Positions are moved lazily.
+ */
+class NestingTree {
+public:
+								NestingTree();
+								~NestingTree();
+
+			bool				IsEmpty() const { return fRoot == NULL; }
+			bool				Contains(Sci_Position pos) const;
+			// Moves delimiters from pos on by delta.
+			void				Shift(Sci_Position pos, Sci_Position delta);
+			void				Remove(Sci_Position from, Sci_Position to);
+			// Adds a delimiter after all others, value is 1 for opening
+			// ones and -1 for closing ones.
+			void				Append(Sci_Position pos, int32 value);
+			// Moves all delimiters of other, which lie between two of these,
+			// here.
+			void				Insert(NestingTree& other);
+
+			// Position of the first delimiter after pos closing more than
+			// it opens since, -1 if there is none.
+			Sci_Position		Closing(Sci_Position pos);
+			// Position of the last delimiter before pos opening more than
+			// is closed until it, -1 if there is none.
+			Sci_Position		Opening(Sci_Position pos);
+
+private:
+	struct Node;
+
+								NestingTree(const NestingTree&);
+			NestingTree&		operator=(const NestingTree&);
+
+			Node*				_Create(Sci_Position position, int32 value);
+
+	static	void				_Push(Node* node);
+	static	void				_Update(Node* node);
+	static	void				_Split(Node* node, Sci_Position pos,
+									Node*& left, Node*& right);
+	static	Node*				_Merge(Node* left, Node* right);
+	static	void				_Delete(Node* node);
+	static	Node*				_First(Node* node);
+	static	Node*				_FirstDroppingTo(Node* node, int32 depth);
+	static	Node*				_LastRisingTo(Node* node, int32 depth);
+
+			Node*				fRoot;
+			uint32				fSeed;
+				// of node priorities
+};
+
+
+#endif // NESTINGTREE_H
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "OutlineView.h"
+
+#include <ListItem.h>
+#include <Message.h>
+#include <Window.h>
+
+#include <string>
+
+#include "GoToLineWindow.h"
+
+
+namespace {
+
+class SymbolItem : public BStringItem {
+public:
+	SymbolItem(const SymbolIndex::Symbol& symbol, uint32 level)
+		:
+		BStringItem(_Label(symbol).c_str(), level),
+		fLine(symbol.line)
+	{
+	}
+
+	int32 Line() const { return fLine; }
+
+private:
+	static std::string _Label(const SymbolIndex::Symbol& symbol)
+	{
+		if(symbol.kind == SymbolIndex::FUNCTION)
+			return symbol.name + "()";
+		if(symbol.kind == SymbolIndex::FILE) {
+			return symbol.name + "  +" + std::to_string(symbol.added)
+				+ " -" + std::to_string(symbol.removed);
+		}
+		return symbol.name;
+	}
+
+	int32	fLine;
+};
+
+}
+
+
+OutlineView::OutlineView()
+	:
+	BOutlineListView("outline", B_SINGLE_SELECTION_LIST)
+{
+}
+
+
+OutlineView::~OutlineView()
+{
+	_RemoveAll();
+}
+
+
+void
+OutlineView::AttachedToWindow()
+{
+	BOutlineListView::AttachedToWindow();
+	SetInvocationMessage(new BMessage(OUTLINE_INVOKED));
+	SetTarget(this);
+}
+
+
+void
+OutlineView::MessageReceived(BMessage* message)
+{
+	switch(message->what) {
+		case OUTLINE_INVOKED: {
+			SymbolItem* item = dynamic_cast<SymbolItem*>(
+				ItemAt(message->GetInt32("index", -1)));
+			if(item == NULL)
+				break;
+			BMessage go(GTLW_GO);
+			go.AddInt32("line", item->Line() + 1);
+			Window()->PostMessage(&go);
+		} break;
+		default:
+			BOutlineListView::MessageReceived(message);
+		break;
+	}
+}
+
+
+// Symbols are nested under the closest preceding one indented less. Diff
+// hunks are too many to list, files show lines changed by them instead.
+void
+OutlineView::SetSymbols(const std::vector<SymbolIndex::Symbol>& symbols)
+{
+	const float top = Bounds().top;
+	_RemoveAll();
+	std::vector<int32> parents;
+		// indentation of symbols which later ones can be nested under
+	for(auto symbol = symbols.begin(); symbol != symbols.end(); symbol++) {
+		if(symbol->kind == SymbolIndex::HUNK)
+			continue;
+		SymbolIndex::Symbol listed = *symbol;
+		for(auto hunk = symbol + 1; listed.kind == SymbolIndex::FILE
+				&& hunk != symbols.end() && hunk->kind == SymbolIndex::HUNK; hunk++) {
+			listed.added += hunk->added;
+			listed.removed += hunk->removed;
+		}
+		while(!parents.empty() && parents.back() >= listed.indent)
+			parents.pop_back();
+		AddItem(new SymbolItem(listed, parents.size()));
+		parents.push_back(listed.indent);
+	}
+	ScrollTo(0, top);
+}
+
+
+void
+OutlineView::_RemoveAll()
+{
+	std::vector<BListItem*> items;
+	for(int32 i = 0; i < FullListCountItems(); i++)
+		items.push_back(FullListItemAt(i));
+	MakeEmpty();
+	for(BListItem* item : items)
+		delete item;
+}
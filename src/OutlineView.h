@@ -0,0 +1,41 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef OUTLINEVIEW_H
+#define OUTLINEVIEW_H
+
+
+#include <OutlineListView.h>
+
+#include <vector>
+
+#include "SymbolIndex.h"
+
+
+enum {
+	OUTLINE_INVOKED			= 'olin'
+};
+
+
+/*
+ * Lists symbols of the document, nested by their indentation. Invoking
+ * a symbol sends GTLW_GO with its line to the window.
+ */
+class OutlineView : public BOutlineListView {
+public:
+							OutlineView();
+							~OutlineView();
+
+	virtual	void			AttachedToWindow();
+	virtual	void			MessageReceived(BMessage* message);
+
+			void			SetSymbols(const std::vector<SymbolIndex::Symbol>& symbols);
+
+private:
+			void			_RemoveAll();
+};
+
+
+#endif // OUTLINEVIEW_H
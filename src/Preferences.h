@@ -22,7 +22,7 @@ public:
 
 	BPath			fSettingsPath;
 
-	// file specific
+	// file specific, .editorconfig of the file takes precedence
 	uint8			fTabWidth;
 	bool			fTabsToSpaces;
 	// broadcast to all editors
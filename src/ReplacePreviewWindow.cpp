@@ -0,0 +1,124 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "ReplacePreviewWindow.h"
+
+#include <Application.h>
+#include <Button.h>
+#include <Catalog.h>
+#include <LayoutBuilder.h>
+#include <ListItem.h>
+#include <OutlineListView.h>
+#include <ScrollView.h>
+#include <String.h>
+#include <StringView.h>
+
+#include "FindInFiles.h"
+
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "ReplacePreviewWindow"
+
+
+ReplacePreviewWindow::ReplacePreviewWindow(FindInFiles* findInFiles)
+	:
+	BWindow(BRect(0, 0, 600, 400), B_TRANSLATE("Replace in files"), B_TITLED_WINDOW,
+		B_NOT_ZOOMABLE | B_AUTO_UPDATE_SIZE_LIMITS, 0),
+	fFindInFiles(findInFiles),
+	fFinished(false)
+{
+	_InitInterface();
+	CenterOnScreen();
+}
+
+
+void
+ReplacePreviewWindow::MessageReceived(BMessage* message)
+{
+	switch(message->what) {
+		case Actions::APPLY: {
+			_Finish(REPLACEPREVIEW_APPLY);
+			Quit();
+		} break;
+		case Actions::CANCEL: {
+			_Finish(REPLACEPREVIEW_CANCEL);
+			Quit();
+		} break;
+		default: {
+			BWindow::MessageReceived(message);
+		} break;
+	}
+}
+
+
+bool
+ReplacePreviewWindow::QuitRequested()
+{
+	_Finish(REPLACEPREVIEW_CANCEL);
+	return true;
+}
+
+
+void
+ReplacePreviewWindow::_InitInterface()
+{
+	const auto& changes = fFindInFiles->Changes();
+
+	BString summary(B_TRANSLATE("Replace %count% occurrences in %files% files?"));
+	BString count, files;
+	count << (uint64) fFindInFiles->TotalCount();
+	files << (uint64) changes.size();
+	summary.ReplaceAll("%count%", count.String());
+	summary.ReplaceAll("%files%", files.String());
+	fSummaryString = new BStringView("summary", summary.String());
+
+	// Files are listed collapsed, so that even a refactor touching thousands
+	// of files only lays out one row per file.
+	fChangesList = new BOutlineListView("changes");
+	for(const auto& change : changes) {
+		BString label(change.path.c_str());
+		label << " (" << (uint64) change.count << ")";
+		BStringItem* fileItem = new BStringItem(label.String());
+		fChangesList->AddItem(fileItem);
+		for(const auto& preview : change.previews) {
+			BString before, after;
+			before << preview.line << ": " << preview.before.c_str();
+			after << "\xE2\x86\x92 " << preview.after.c_str();
+				// right arrow
+			fChangesList->AddUnder(new BStringItem(before.String()), fileItem);
+			fChangesList->AddUnder(new BStringItem(after.String()), fileItem);
+		}
+		fChangesList->Collapse(fileItem);
+	}
+	BScrollView* changesScroll = new BScrollView("changesScroll", fChangesList,
+		0, true, true);
+
+	fReplaceButton = new BButton(B_TRANSLATE("Replace"), new BMessage((uint32) Actions::APPLY));
+	fReplaceButton->MakeDefault(true);
+	fCancelButton = new BButton(B_TRANSLATE("Cancel"), new BMessage((uint32) Actions::CANCEL));
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL, 5)
+		.Add(fSummaryString)
+		.Add(changesScroll)
+		.AddGroup(B_HORIZONTAL, 5)
+			.AddGlue()
+			.Add(fCancelButton)
+			.Add(fReplaceButton)
+		.End()
+		.SetInsets(5, 5, 5, 5);
+}
+
+
+void
+ReplacePreviewWindow::_Finish(uint32 what)
+{
+	if(fFinished == true)
+		return;
+	fFinished = true;
+
+	BMessage message(what);
+	message.AddPointer("findInFiles", fFindInFiles);
+	be_app->PostMessage(&message);
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef REPLACEPREVIEWWINDOW_H
+#define REPLACEPREVIEWWINDOW_H
+
+
+#include <Window.h>
+
+
+class BButton;
+class BOutlineListView;
+class BStringView;
+class FindInFiles;
+
+
+enum {
+	REPLACEPREVIEW_APPLY	= 'rpap',
+	REPLACEPREVIEW_CANCEL	= 'rpcn'
+};
+
+
+class ReplacePreviewWindow : public BWindow {
+public:
+						ReplacePreviewWindow(FindInFiles* findInFiles);
+
+	void				MessageReceived(BMessage* message);
+	bool				QuitRequested();
+
+private:
+	enum Actions {
+		APPLY			= 'aply',
+		CANCEL			= 'cncl'
+	};
+	void				_InitInterface();
+	void				_Finish(uint32 what);
+
+	FindInFiles*		fFindInFiles;
+	bool				fFinished;
+
+	BStringView*		fSummaryString;
+	BOutlineListView*	fChangesList;
+	BButton*			fReplaceButton;
+	BButton*			fCancelButton;
+};
+
+
+#endif // REPLACEPREVIEWWINDOW_H
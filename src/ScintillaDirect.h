@@ -0,0 +1,107 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef SCINTILLADIRECT_H
+#define SCINTILLADIRECT_H
+
+
+#include <ScintillaView.h>
+#include <SupportDefs.h>
+
+
+/*
+ * Calls Scintilla through its direct function, fetched once from the view,
+ * and names the messages used on hot paths. Valid as long as the view, and
+ * only in the thread owning it, as the view's own calls are.
+ */
+class ScintillaDirect {
+public:
+						ScintillaDirect() : fFunction(NULL), fPointer(0), fCalls(0) {}
+
+	void				SetView(BScintillaView* view)
+		{
+			fFunction = reinterpret_cast<SciFnDirect>(
+				view->SendMessage(SCI_GETDIRECTFUNCTION, 0, 0));
+			fPointer = view->SendMessage(SCI_GETDIRECTPOINTER, 0, 0);
+		}
+
+	sptr_t				Call(unsigned int message, uptr_t wParam = 0,
+							sptr_t lParam = 0)
+		{ fCalls++; return fFunction(fPointer, message, wParam, lParam); }
+	// Number of calls made so far.
+	int64				Calls() const { return fCalls; }
+
+	// Text and selection
+	Sci_Position		Length()
+		{ return Call(SCI_GETLENGTH); }
+	const char*			CharacterPointer()
+		{ return reinterpret_cast<const char*>(Call(SCI_GETCHARACTERPOINTER)); }
+	Sci_Position		CurrentPos()
+		{ return Call(SCI_GETCURRENTPOS); }
+	Sci_Position		Anchor()
+		{ return Call(SCI_GETANCHOR); }
+	Sci_Position		SelectionStart()
+		{ return Call(SCI_GETSELECTIONSTART); }
+	Sci_Position		SelectionEnd()
+		{ return Call(SCI_GETSELECTIONEND); }
+	void				SetSel(Sci_Position anchor, Sci_Position caret)
+		{ Call(SCI_SETSEL, anchor, caret); }
+	void				ReplaceSel(const char* text)
+		{ Call(SCI_REPLACESEL, 0, reinterpret_cast<sptr_t>(text)); }
+	void				BeginUndoAction()
+		{ Call(SCI_BEGINUNDOACTION); }
+	void				EndUndoAction()
+		{ Call(SCI_ENDUNDOACTION); }
+
+	// Target, reversed when searching backwards
+	Sci_Position		TargetStart()
+		{ return Call(SCI_GETTARGETSTART); }
+	Sci_Position		TargetEnd()
+		{ return Call(SCI_GETTARGETEND); }
+	void				SetTargetRange(Sci_Position start, Sci_Position end)
+		{ Call(SCI_SETTARGETRANGE, start, end); }
+	void				ReplaceTarget(const char* text, Sci_Position length)
+		{ Call(SCI_REPLACETARGET, length, reinterpret_cast<sptr_t>(text)); }
+
+	// Lines and indentation
+	int					EOLMode()
+		{ return Call(SCI_GETEOLMODE); }
+	int32				LineFromPosition(Sci_Position pos)
+		{ return Call(SCI_LINEFROMPOSITION, pos); }
+	int					LineIndentation(int32 line)
+		{ return Call(SCI_GETLINEINDENTATION, line); }
+	void				SetLineIndentation(int32 line, int indentation)
+		{ Call(SCI_SETLINEINDENTATION, line, indentation); }
+	Sci_Position		LineIndentPosition(int32 line)
+		{ return Call(SCI_GETLINEINDENTPOSITION, line); }
+
+	// Styles
+	void				StyleSetFont(int style, const char* font)
+		{ Call(SCI_STYLESETFONT, style, reinterpret_cast<sptr_t>(font)); }
+	void				StyleSetSize(int style, int size)
+		{ Call(SCI_STYLESETSIZE, style, size); }
+	void				StyleSetFore(int style, int color)
+		{ Call(SCI_STYLESETFORE, style, color); }
+	void				StyleSetBack(int style, int color)
+		{ Call(SCI_STYLESETBACK, style, color); }
+	void				StyleSetBold(int style, bool bold)
+		{ Call(SCI_STYLESETBOLD, style, bold); }
+	void				StyleSetItalic(int style, bool italic)
+		{ Call(SCI_STYLESETITALIC, style, italic); }
+	void				StyleSetUnderline(int style, bool underline)
+		{ Call(SCI_STYLESETUNDERLINE, style, underline); }
+	void				StyleClearAll()
+		{ Call(SCI_STYLECLEARALL); }
+	void				IndicSetFore(int indicator, int color)
+		{ Call(SCI_INDICSETFORE, indicator, color); }
+
+private:
+	SciFnDirect			fFunction;
+	sptr_t				fPointer;
+	int64				fCalls;
+};
+
+
+#endif // SCINTILLADIRECT_H
@@ -0,0 +1,368 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "SearchResultsView.h"
+
+#include <Application.h>
+#include <Entry.h>
+#include <Message.h>
+#include <Path.h>
+#include <ScrollBar.h>
+#include <String.h>
+#include <Window.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "Editor.h"
+#include "GoToLineWindow.h"
+
+
+namespace {
+
+const uint32 kDocument = 0xFFFFFFFF;
+const size_t kMaxCachedPreviews = 512;
+const size_t kMaxPreviewLength = 400;
+const uint32 kLeadingContext = 40;
+const rgb_color kMatchColor = { 255, 224, 128, 255 };
+
+}
+
+
+SearchResultsView::SearchResultsView(Editor* editor)
+	:
+	BView("searchResults", B_WILL_DRAW | B_FRAME_EVENTS | B_NAVIGABLE),
+	fEditor(editor),
+	fSelected(-1),
+	fRowHeight(0),
+	fBaseline(0),
+	fOpenFileIndex(kDocument)
+{
+}
+
+
+void
+SearchResultsView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	SetViewColor(B_TRANSPARENT_COLOR);
+
+	font_height fontHeight;
+	GetFontHeight(&fontHeight);
+	fBaseline = ceilf(fontHeight.ascent) + 1;
+	fRowHeight = static_cast<int32>(fBaseline
+		+ ceilf(fontHeight.descent + fontHeight.leading) + 1);
+	_UpdateScrollBar();
+}
+
+
+void
+SearchResultsView::Draw(BRect updateRect)
+{
+	SetLowColor(ui_color(B_LIST_BACKGROUND_COLOR));
+	FillRect(updateRect, B_SOLID_LOW);
+	if(fResults.empty() == true || fRowHeight <= 0)
+		return;
+
+	// only rows in the update rect are looked at, however many there are
+	const size_t first = _RowAt(updateRect.top);
+	const size_t last = std::min(fResults.size() - 1,
+		static_cast<size_t>(_RowAt(updateRect.bottom)));
+	for(size_t i = first; i <= last; i++) {
+		const Result& result = fResults[i];
+		BRect frame = _RowFrame(i);
+		if(static_cast<int64>(i) == fSelected) {
+			SetLowColor(ui_color(B_LIST_SELECTED_BACKGROUND_COLOR));
+			FillRect(frame, B_SOLID_LOW);
+			SetHighColor(ui_color(B_LIST_SELECTED_ITEM_TEXT_COLOR));
+		} else {
+			SetLowColor(ui_color(B_LIST_BACKGROUND_COLOR));
+			SetHighColor(ui_color(B_LIST_ITEM_TEXT_COLOR));
+		}
+
+		BString label;
+		if(result.file != kDocument)
+			label << BPath(fFiles[result.file].c_str()).Leaf() << ":";
+		label << result.line + 1 << ": ";
+		BPoint point(frame.left + 4, frame.top + fBaseline);
+		DrawString(label.String(), point);
+		point.x += StringWidth(label.String());
+
+		const Preview& preview = _Preview(i);
+		const char* text = preview.text.c_str();
+		DrawString(text, preview.column, point);
+		point.x += StringWidth(text, preview.column);
+		const float matchWidth = StringWidth(text + preview.column, preview.length);
+		rgb_color low = LowColor();
+		SetLowColor(kMatchColor);
+		FillRect(BRect(point.x, frame.top, point.x + matchWidth, frame.bottom), B_SOLID_LOW);
+		DrawString(text + preview.column, preview.length, point);
+		SetLowColor(low);
+		point.x += matchWidth;
+		DrawString(text + preview.column + preview.length, point);
+	}
+}
+
+
+void
+SearchResultsView::FrameResized(float width, float height)
+{
+	BView::FrameResized(width, height);
+	_UpdateScrollBar();
+}
+
+
+void
+SearchResultsView::KeyDown(const char* bytes, int32 numBytes)
+{
+	const int64 page = std::max((int64) 1,
+		static_cast<int64>(Bounds().Height()) / std::max(fRowHeight, (int32) 1));
+	switch(bytes[0]) {
+		case B_UP_ARROW: _Select(fSelected - 1); break;
+		case B_DOWN_ARROW: _Select(fSelected + 1); break;
+		case B_PAGE_UP: _Select(fSelected - page); break;
+		case B_PAGE_DOWN: _Select(fSelected + page); break;
+		case B_HOME: _Select(0); break;
+		case B_END: _Select(static_cast<int64>(fResults.size()) - 1); break;
+		case B_ENTER:
+			if(fSelected >= 0)
+				_Invoke(fSelected);
+		break;
+		default:
+			BView::KeyDown(bytes, numBytes);
+		break;
+	}
+}
+
+
+void
+SearchResultsView::MouseDown(BPoint where)
+{
+	MakeFocus();
+	if(fRowHeight <= 0 || where.y < 0)
+		return;
+	const size_t index = _RowAt(where.y);
+	if(index >= fResults.size())
+		return;
+	_Select(index);
+	int32 clicks = 1;
+	Window()->CurrentMessage()->FindInt32("clicks", &clicks);
+	if(clicks == 2)
+		_Invoke(index);
+}
+
+
+void
+SearchResultsView::AddResults(BMessage* message)
+{
+	const void* data;
+	ssize_t size;
+	if(message->FindData("matches", B_RAW_TYPE, &data, &size) != B_OK)
+		return;
+	AddResults(message->GetString("path", ""),
+		static_cast<const Match*>(data), size / sizeof(Match));
+}
+
+
+void
+SearchResultsView::AddResults(const char* path, const Match* matches,
+	size_t count)
+{
+	if(count == 0)
+		return;
+	uint32 file = kDocument;
+	if(path != nullptr && path[0] != '\0') {
+		// producers send batches file by file
+		if(fFiles.empty() == true || fFiles.back() != path)
+			fFiles.push_back(path);
+		file = fFiles.size() - 1;
+	}
+
+	const size_t oldCount = fResults.size();
+	fResults.reserve(oldCount + count);
+	for(size_t i = 0; i < count; i++) {
+		Result result;
+		result.offset = matches[i].offset;
+		result.line = matches[i].line;
+		result.column = matches[i].column;
+		result.length = matches[i].length;
+		result.file = file;
+		fResults.push_back(result);
+	}
+	_UpdateScrollBar();
+	BRect bounds = Bounds();
+	Invalidate(BRect(bounds.left, _RowFrame(oldCount).top, bounds.right,
+		_RowFrame(fResults.size() - 1).bottom));
+}
+
+
+void
+SearchResultsView::Clear()
+{
+	std::vector<Result>().swap(fResults);
+	fFiles.clear();
+	fPreviews.clear();
+	fSelected = -1;
+	fOpenFile.Unset();
+	fOpenFileIndex = kDocument;
+	ScrollTo(0, 0);
+	_UpdateScrollBar();
+	Invalidate();
+}
+
+
+/* static */ void
+SearchResultsView::AddToMessage(BMessage* message, const char* path,
+	const std::vector<Match>& matches)
+{
+	message->AddString("path", path);
+	message->AddData("matches", B_RAW_TYPE, matches.data(),
+		matches.size() * sizeof(Match));
+}
+
+
+void
+SearchResultsView::_Invoke(size_t index)
+{
+	const Result& result = fResults[index];
+	if(result.file == kDocument) {
+		BMessage go(GTLW_GO);
+		go.AddInt32("line", result.line + 1);
+		Window()->PostMessage(&go);
+		return;
+	}
+	entry_ref ref;
+	if(get_ref_for_path(fFiles[result.file].c_str(), &ref) != B_OK)
+		return;
+	BMessage refs(B_REFS_RECEIVED);
+	refs.AddRef("refs", &ref);
+	refs.AddInt32("be:line", result.line + 1);
+	be_app->PostMessage(&refs);
+}
+
+
+void
+SearchResultsView::_Select(int64 index)
+{
+	if(fResults.empty() == true)
+		return;
+	index = std::max((int64) 0,
+		std::min(index, static_cast<int64>(fResults.size()) - 1));
+	if(fSelected >= 0)
+		Invalidate(_RowFrame(fSelected));
+	fSelected = index;
+	BRect frame = _RowFrame(fSelected);
+	Invalidate(frame);
+
+	BRect bounds = Bounds();
+	if(frame.top < bounds.top)
+		ScrollTo(0, frame.top);
+	else if(frame.bottom > bounds.bottom)
+		ScrollTo(0, frame.bottom - bounds.Height());
+}
+
+
+void
+SearchResultsView::_UpdateScrollBar()
+{
+	BScrollBar* scrollBar = ScrollBar(B_VERTICAL);
+	if(scrollBar == nullptr)
+		return;
+	const float height = Bounds().Height();
+	const float total = static_cast<int64>(fResults.size()) * fRowHeight;
+	scrollBar->SetRange(0, std::max(0.0f, total - height));
+	scrollBar->SetProportion(total > 0 ? std::min(1.0f, height / total) : 1.0f);
+	scrollBar->SetSteps(fRowHeight, std::max<float>(fRowHeight, height - fRowHeight));
+}
+
+
+// Row at vertical position y, which is not below 0.
+int64
+SearchResultsView::_RowAt(float y) const
+{
+	if(fRowHeight <= 0 || y < 0)
+		return 0;
+	return static_cast<int64>(floorf(y)) / fRowHeight;
+}
+
+
+BRect
+SearchResultsView::_RowFrame(size_t index) const
+{
+	BRect bounds = Bounds();
+	const int64 top = static_cast<int64>(index) * fRowHeight;
+	return BRect(bounds.left, top, bounds.right, top + fRowHeight - 1);
+}
+
+
+const SearchResultsView::Preview&
+SearchResultsView::_Preview(size_t index)
+{
+	auto cached = fPreviews.find(index);
+	if(cached != fPreviews.end())
+		return cached->second;
+	if(fPreviews.size() >= kMaxCachedPreviews)
+		fPreviews.clear();
+
+	// Long lines are shown from a bit before the match.
+	const Result& result = fResults[index];
+	const uint32 skip = result.column > kLeadingContext
+		? result.column - kLeadingContext : 0;
+	Preview& preview = fPreviews[index];
+	std::string line;
+	if(_ReadLine(result, skip, line) == false)
+		return preview;
+
+	size_t start = 0;
+	if(skip > 0) {
+		// do not start in the middle of a character
+		while(start < line.size() && (static_cast<uint8>(line[start]) & 0xC0) == 0x80)
+			start++;
+		preview.text = B_UTF8_ELLIPSIS;
+	}
+	const size_t column = std::min(line.size(),
+		std::max(start, static_cast<size_t>(result.column - skip)));
+	preview.text.append(line, start, column - start);
+	preview.column = preview.text.size();
+	preview.length = std::min(static_cast<size_t>(result.length), line.size() - column);
+	preview.text.append(line, column, std::string::npos);
+	std::replace(preview.text.begin(), preview.text.end(), '\t', ' ');
+	return preview;
+}
+
+
+bool
+SearchResultsView::_ReadLine(const Result& result, off_t skip, std::string& text)
+{
+	char buffer[kMaxPreviewLength];
+	ssize_t length;
+	if(result.file == kDocument) {
+		const Sci_Position start = fEditor->SendMessage(SCI_POSITIONFROMLINE,
+			result.line, 0) + skip;
+		const Sci_Position end = std::min(start + (Sci_Position) kMaxPreviewLength - 1,
+			(Sci_Position) fEditor->SendMessage(SCI_GETLINEENDPOSITION, result.line, 0));
+		if(start < 0 || end < start)
+			return false;
+		Sci_TextRange range;
+		range.chrg.cpMin = start;
+		range.chrg.cpMax = end;
+		range.lpstrText = buffer;
+		length = fEditor->SendMessage(SCI_GETTEXTRANGE, 0, (sptr_t) &range);
+	} else {
+		if(fOpenFileIndex != result.file) {
+			fOpenFile.SetTo(fFiles[result.file].c_str(), B_READ_ONLY);
+			fOpenFileIndex = result.file;
+		}
+		if(fOpenFile.InitCheck() != B_OK)
+			return false;
+		length = fOpenFile.ReadAt(result.offset + skip, buffer, sizeof(buffer));
+	}
+	if(length < 0)
+		return false;
+	const char* end = std::find_if(buffer, buffer + length,
+		[](char ch) { return ch == '\n' || ch == '\r'; });
+	text.assign(buffer, end - buffer);
+	return true;
+}
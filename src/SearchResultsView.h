@@ -0,0 +1,102 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef SEARCHRESULTSVIEW_H
+#define SEARCHRESULTSVIEW_H
+
+
+#include <File.h>
+#include <View.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+class Editor;
+
+
+enum {
+	SEARCHRESULTS_CLEAR		= 'srcl',
+	SEARCHRESULTS_ADD		= 'srad',
+	SEARCHRESULTS_DONE		= 'srdn'
+};
+
+
+/*
+ * Lists search results, one row per match. Only compact records are kept
+ * for every result, preview lines are read from the file (or the editor,
+ * for results in the current document) when rows become visible.
+ *
+ * SEARCHRESULTS_ADD carries "path" (empty for the current document) and
+ * "matches" raw data with an array of Match records, so that producers can
+ * send results in batches as they find them.
+ */
+class SearchResultsView : public BView {
+public:
+	struct Match {
+		off_t				offset;
+			// of the line start
+		int32				line;
+		uint32				column;
+		uint32				length;
+	};
+
+							SearchResultsView(Editor* editor);
+
+	virtual	void			AttachedToWindow();
+	virtual	void			Draw(BRect updateRect);
+	virtual	void			FrameResized(float width, float height);
+	virtual	void			KeyDown(const char* bytes, int32 numBytes);
+	virtual	void			MouseDown(BPoint where);
+
+			void			AddResults(BMessage* message);
+			void			AddResults(const char* path, const Match* matches,
+								size_t count);
+			void			Clear();
+			size_t			CountResults() const { return fResults.size(); }
+
+	static	void			AddToMessage(BMessage* message, const char* path,
+								const std::vector<Match>& matches);
+
+private:
+	struct Result {
+		off_t				offset;
+		int32				line;
+		uint32				column;
+		uint32				length;
+		uint32				file;
+	};
+	struct Preview {
+		std::string			text;
+		uint32				column;
+		uint32				length;
+	};
+
+			void			_Invoke(size_t index);
+			void			_Select(int64 index);
+			void			_UpdateScrollBar();
+			int64			_RowAt(float y) const;
+			BRect			_RowFrame(size_t index) const;
+			const Preview&	_Preview(size_t index);
+			bool			_ReadLine(const Result& result, off_t skip,
+								std::string& text);
+
+			Editor*			fEditor;
+			std::vector<std::string>	fFiles;
+			std::vector<Result>	fResults;
+			int64			fSelected;
+			int32			fRowHeight;
+				// whole pixels, rows are placed by integer arithmetic
+			float			fBaseline;
+
+			std::map<size_t, Preview>	fPreviews;
+				// only rows drawn recently
+			uint32			fOpenFileIndex;
+			BFile			fOpenFile;
+};
+
+
+#endif // SEARCHRESULTSVIEW_H
@@ -0,0 +1,544 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "Searcher.h"
+
+#include <cstring>
+
+#include "CaseFolding.h"
+
+
+namespace {
+
+const ptrdiff_t kFoldChunkSize = 4096;
+const size_t kMaxScannedBytes = 4;
+
+
+inline bool
+IsWordChar(unsigned char ch)
+{
+	// Same as Scintilla's default word characters, everything above ASCII
+	// is treated as a part of word.
+	return ch >= 0x80 || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')
+		|| (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+
+inline char
+AsciiLower(char ch)
+{
+	return (ch >= 'A' && ch <= 'Z') ? ch + ('a' - 'A') : ch;
+}
+
+
+inline char
+AsciiUpper(char ch)
+{
+	return (ch >= 'a' && ch <= 'z') ? ch - ('a' - 'A') : ch;
+}
+
+
+enum CaseMode {
+	CASE_KEEP,
+	CASE_UPPER,
+	CASE_LOWER
+};
+
+
+inline char
+ApplyCase(char ch, CaseMode mode)
+{
+	switch(mode) {
+		case CASE_UPPER: return AsciiUpper(ch);
+		case CASE_LOWER: return AsciiLower(ch);
+		default: return ch;
+	}
+}
+
+
+void
+AppendCased(std::string& output, const char* text, size_t length,
+	CaseMode mode, CaseMode& next)
+{
+	if(length == 0)
+		return;
+	if(mode == CASE_KEEP && next == CASE_KEEP) {
+		output.append(text, length);
+		return;
+	}
+	size_t i = 0;
+	if(next != CASE_KEEP) {
+		output.push_back(ApplyCase(text[0], next));
+		next = CASE_KEEP;
+		i = 1;
+	}
+	if(mode == CASE_KEEP) {
+		output.append(text + i, length - i);
+		return;
+	}
+	for(; i < length; i++)
+		output.push_back(ApplyCase(text[i], mode));
+}
+
+
+inline const char*
+FindByte(const char* start, const char* end, char ch)
+{
+	return static_cast<const char*>(memchr(start, ch, end - start));
+}
+
+}
+
+
+Searcher::Searcher(const std::string& pattern, const std::string& replacement,
+	bool matchCase, bool matchWord, bool regex)
+	:
+	fPattern(pattern),
+	fMatchCase(matchCase),
+	fMatchWord(matchWord),
+	fRegex(regex),
+	fValid(!pattern.empty()),
+	fLeadBytes()
+{
+	if(fRegex == true) {
+		auto flags = std::regex_constants::ECMAScript
+			| std::regex_constants::optimize;
+		if(fMatchCase == false)
+			flags |= std::regex_constants::icase;
+		try {
+			fExpression.assign(fPattern, flags);
+		} catch(std::regex_error&) {
+			fValid = false;
+		}
+	} else if(fMatchCase == false && fValid == true) {
+		size_t pos = 0;
+		while(pos < fPattern.length()) {
+			fFolded.push_back(CaseFolding::Fold(
+				CaseFolding::Decode(fPattern.data(), fPattern.length(), pos)));
+		}
+		CaseFolding::CollectLeadBytes(fFolded[0], fLeadBytes);
+		for(int ch = 0; ch < 256; ch++) {
+			if(fLeadBytes[ch] == true)
+				fFirstBytes.push_back(static_cast<char>(ch));
+		}
+	}
+	_CompileReplacement(replacement);
+}
+
+
+bool
+Searcher::Find(const char* text, size_t length, size_t from, size_t to,
+	Match& match) const
+{
+	if(fValid == false)
+		return false;
+	if(fRegex == true)
+		return _FindRegex(text, length, from, to, match);
+	return _FindLiteral(text, length, from, to, match);
+}
+
+
+bool
+Searcher::FindLast(const char* text, size_t length, size_t from, size_t to,
+	Match& match) const
+{
+	if(fValid == false)
+		return false;
+	if(fRegex == false)
+		return _FindLastLiteral(text, length, from, to, match);
+
+	// Go back line by line and take the last match in the first line which
+	// has one.
+	if(to > length || from > to)
+		return false;
+	size_t lineEnd = to;
+	while(true) {
+		size_t lineStart = lineEnd;
+		while(lineStart > from && text[lineStart - 1] != '\n')
+			lineStart--;
+		bool found = false;
+		Match current;
+		size_t pos = lineStart;
+		while(pos <= lineEnd && _SearchLine(text, length, pos, lineEnd, current) == true) {
+			found = true;
+			match.start = current.start;
+			match.end = current.end;
+			match.groups = current.groups;
+			pos = (current.end > current.start) ? current.end : current.end + 1;
+		}
+		if(found == true)
+			return true;
+		if(lineStart <= from)
+			return false;
+		lineEnd = lineStart - 1;
+			// skip the newline
+	}
+}
+
+
+bool
+Searcher::_FindLiteral(const char* text, size_t length, size_t from, size_t to,
+	Match& match) const
+{
+	// every character of the pattern takes at least one byte
+	const size_t minimumLength = fMatchCase ? fPattern.length() : fFolded.size();
+	if(to > length || from >= to || to - from < minimumLength)
+		return false;
+
+	const char* end = text + to - minimumLength + 1;
+		// last position at which match can start, exclusive
+	const char* pos = text + from;
+	size_t matchEnd;
+	if(fMatchCase == true) {
+		while(pos < end) {
+			const char* candidate = FindByte(pos, end, fPattern[0]);
+			if(candidate == nullptr)
+				return false;
+			const size_t start = candidate - text;
+			if(_MatchAt(text, start, to, matchEnd) == true
+					&& (fMatchWord == false
+						|| _IsWholeWord(text, length, start, matchEnd))) {
+				match.start = start;
+				match.end = matchEnd;
+				return true;
+			}
+			pos = candidate + 1;
+		}
+		return false;
+	}
+
+	// When case is ignored first character may be encoded with several lead
+	// bytes. Look for all of them in bounded chunks and remember where the
+	// next occurrence of each is, so that a missing variant does not make
+	// every call scan to the end of the buffer. Characters with many
+	// variants fall back to checking every byte.
+	const size_t variants = fFirstBytes.size();
+	const bool scanBytes = variants <= kMaxScannedBytes;
+	const char* next[kMaxScannedBytes] = {};
+	const char* chunkEnd = nullptr;
+	while(pos < end) {
+		const char* candidate;
+		if(scanBytes == true) {
+			if(chunkEnd == nullptr || pos >= chunkEnd) {
+				chunkEnd = end - pos > kFoldChunkSize ? pos + kFoldChunkSize : end;
+				for(size_t i = 0; i < variants; i++)
+					next[i] = nullptr;
+			}
+			candidate = chunkEnd;
+			for(size_t i = 0; i < variants; i++) {
+				if(next[i] == nullptr || next[i] < pos) {
+					next[i] = FindByte(pos, chunkEnd, fFirstBytes[i]);
+					if(next[i] == nullptr) next[i] = chunkEnd;
+				}
+				if(next[i] < candidate)
+					candidate = next[i];
+			}
+			if(candidate == chunkEnd) {
+				pos = chunkEnd;
+				continue;
+			}
+		} else {
+			candidate = pos;
+			while(candidate < end
+					&& fLeadBytes[static_cast<unsigned char>(*candidate)] == false)
+				candidate++;
+			if(candidate == end)
+				return false;
+		}
+		const size_t start = candidate - text;
+		if(_MatchAt(text, start, to, matchEnd) == true
+				&& (fMatchWord == false
+					|| _IsWholeWord(text, length, start, matchEnd))) {
+			match.start = start;
+			match.end = matchEnd;
+			return true;
+		}
+		pos = candidate + 1;
+	}
+	return false;
+}
+
+
+size_t
+Searcher::Count(const char* text, size_t length) const
+{
+	size_t count = 0;
+	Match match;
+	size_t pos = 0;
+	while(pos <= length && Find(text, length, pos, length, match) == true) {
+		count++;
+		pos = (match.end > match.start) ? match.end : match.end + 1;
+	}
+	return count;
+}
+
+
+void
+Searcher::Expand(const Match& match, std::string& output) const
+{
+	CaseMode mode = CASE_KEEP;
+	CaseMode next = CASE_KEEP;
+	for(const auto& part : fParts) {
+		switch(part.type) {
+			case Part::LITERAL:
+				AppendCased(output, fReplacement.data() + part.offset,
+					part.length, mode, next);
+			break;
+			case Part::GROUP:
+				if(part.offset < match.groups.size()
+						&& match.groups[part.offset].matched == true) {
+					const auto& group = match.groups[part.offset];
+					AppendCased(output, group.first, group.second - group.first,
+						mode, next);
+				}
+			break;
+			case Part::UPPER: mode = CASE_UPPER; break;
+			case Part::LOWER: mode = CASE_LOWER; break;
+			case Part::END_CASE: mode = CASE_KEEP; break;
+			case Part::UPPER_NEXT: next = CASE_UPPER; break;
+			case Part::LOWER_NEXT: next = CASE_LOWER; break;
+		}
+	}
+}
+
+
+size_t
+Searcher::ReplaceAll(const char* text, size_t length, size_t from, size_t to,
+	std::string& output, Match& replaced) const
+{
+	size_t count = 0;
+	Match match;
+	size_t pos = from;
+	while(pos <= to && Find(text, length, pos, to, match) == true) {
+		if(count == 0) {
+			replaced.start = match.start;
+			// Most replacements change the size only slightly, so reserve
+			// once for the rest of the range instead of growing repeatedly.
+			output.reserve(output.size() + (to - match.start) + fReplacement.size());
+		} else {
+			output.append(text + pos, match.start - pos);
+		}
+		Expand(match, output);
+		count++;
+		pos = match.end;
+		if(match.end == match.start) {
+			// Empty regex match, step over one character so that it is not
+			// found again, and so that nothing is inserted inside of it.
+			if(pos >= to)
+				break;
+			size_t next = pos + 1;
+			while(next < to && (static_cast<unsigned char>(text[next]) & 0xC0) == 0x80)
+				next++;
+			output.append(text + pos, next - pos);
+			pos = next;
+		}
+	}
+	if(count > 0)
+		replaced.end = pos;
+	return count;
+}
+
+
+void
+Searcher::_CompileReplacement(const std::string& replacement)
+{
+	if(fRegex == false) {
+		fReplacement = replacement;
+		fParts.push_back(Part{ Part::LITERAL, 0, fReplacement.length() });
+		return;
+	}
+
+	auto addLiteral = [this](const char* start, size_t length) {
+		if(fParts.empty() == false && fParts.back().type == Part::LITERAL
+				&& fParts.back().offset + fParts.back().length == fReplacement.length()) {
+			fParts.back().length += length;
+		} else {
+			fParts.push_back(Part{ Part::LITERAL, fReplacement.length(), length });
+		}
+		fReplacement.append(start, length);
+	};
+	auto addPart = [this](Part::Type type, size_t value) {
+		fParts.push_back(Part{ type, value, 0 });
+	};
+
+	const char* pos = replacement.c_str();
+	const char* end = pos + replacement.length();
+	while(pos < end) {
+		const char ch = pos[0];
+		const char next = (pos + 1 < end) ? pos[1] : '\0';
+		if(ch == '\\' && next != '\0') {
+			pos += 2;
+			switch(next) {
+				case 'U': addPart(Part::UPPER, 0); break;
+				case 'L': addPart(Part::LOWER, 0); break;
+				case 'E': addPart(Part::END_CASE, 0); break;
+				case 'u': addPart(Part::UPPER_NEXT, 0); break;
+				case 'l': addPart(Part::LOWER_NEXT, 0); break;
+				case 'n': addLiteral("\n", 1); break;
+				case 'r': addLiteral("\r", 1); break;
+				case 't': addLiteral("\t", 1); break;
+				case '\\': addLiteral("\\", 1); break;
+				default:
+					if(next >= '0' && next <= '9')
+						addPart(Part::GROUP, next - '0');
+					else
+						addLiteral(pos - 2, 2);
+				break;
+			}
+		} else if(ch == '$' && next != '\0') {
+			if(next >= '0' && next <= '9') {
+				addPart(Part::GROUP, next - '0');
+				pos += 2;
+			} else if(next == '&') {
+				addPart(Part::GROUP, 0);
+				pos += 2;
+			} else if(next == '$') {
+				addLiteral(pos, 1);
+				pos += 2;
+			} else if(next == '{') {
+				const char* close = static_cast<const char*>(memchr(pos, '}', end - pos));
+				size_t group = 0;
+				const char* digit = pos + 2;
+				for(; close != nullptr && digit < close && *digit >= '0' && *digit <= '9'; digit++)
+					group = group * 10 + (*digit - '0');
+				if(close != nullptr && digit == close && close > pos + 2) {
+					addPart(Part::GROUP, group);
+					pos = close + 1;
+				} else {
+					addLiteral(pos, 1);
+					pos++;
+				}
+			} else {
+				addLiteral(pos, 1);
+				pos++;
+			}
+		} else {
+			addLiteral(pos, 1);
+			pos++;
+		}
+	}
+}
+
+
+bool
+Searcher::_FindLastLiteral(const char* text, size_t length, size_t from,
+	size_t to, Match& match) const
+{
+	const size_t minimumLength = fMatchCase ? fPattern.length() : fFolded.size();
+	if(to > length || from >= to || to - from < minimumLength)
+		return false;
+
+	size_t matchEnd;
+	for(size_t start = to - minimumLength + 1; start-- > from;) {
+		const char ch = text[start];
+		if(fMatchCase == true ? ch != fPattern[0]
+				: fLeadBytes[static_cast<unsigned char>(ch)] == false)
+			continue;
+		if(_MatchAt(text, start, to, matchEnd) == true
+				&& (fMatchWord == false
+					|| _IsWholeWord(text, length, start, matchEnd))) {
+			match.start = start;
+			match.end = matchEnd;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool
+Searcher::_FindRegex(const char* text, size_t length, size_t from, size_t to,
+	Match& match) const
+{
+	if(to > length || from > to)
+		return false;
+
+	size_t lineStart = from;
+	while(true) {
+		const char* newline = static_cast<const char*>(
+			memchr(text + lineStart, '\n', to - lineStart));
+		size_t lineEnd = (newline != nullptr) ? newline - text : to;
+		if(_SearchLine(text, length, lineStart, lineEnd, match) == true)
+			return true;
+		if(newline == nullptr)
+			return false;
+		lineStart = lineEnd + 1;
+	}
+}
+
+
+bool
+Searcher::_SearchLine(const char* text, size_t length, size_t from, size_t to,
+	Match& match) const
+{
+	// $ should match before CRLF too
+	if(to > from && to < length && text[to] == '\n' && text[to - 1] == '\r')
+		to--;
+
+	size_t pos = from;
+	while(pos <= to) {
+		auto flags = std::regex_constants::match_default;
+		if(pos > 0 && text[pos - 1] != '\n')
+			flags |= std::regex_constants::match_prev_avail;
+				// started in the middle of a line, ^ must not match
+		if(to < length && text[to] != '\n' && text[to] != '\r')
+			flags |= std::regex_constants::match_not_eol;
+		if(std::regex_search(text + pos, text + to, match.groups, fExpression,
+				flags) == false)
+			return false;
+		const size_t start = match.groups[0].first - text;
+		const size_t end = match.groups[0].second - text;
+		if(fMatchWord == false || _IsWholeWord(text, length, start, end) == true) {
+			match.start = start;
+			match.end = end;
+			return true;
+		}
+		pos = start + 1;
+	}
+	return false;
+}
+
+
+bool
+Searcher::_MatchAt(const char* text, size_t start, size_t to,
+	size_t& end) const
+{
+	const char* candidate = text + start;
+	if(fMatchCase == true) {
+		end = start + fPattern.length();
+		return end <= to
+			&& memcmp(candidate, fPattern.data(), fPattern.length()) == 0;
+	}
+
+	size_t pos = start;
+	for(size_t i = 0; i < fFolded.size(); i++) {
+		if(pos >= to)
+			return false;
+		const unsigned char ch = text[pos];
+		uint32 folded;
+		if(ch < 0x80) {
+			// ASCII needs neither decoding nor table lookup
+			folded = CaseFolding::Fold(ch);
+			pos++;
+		} else
+			folded = CaseFolding::Fold(CaseFolding::Decode(text, to, pos));
+		if(folded != fFolded[i])
+			return false;
+	}
+	end = pos;
+	return true;
+}
+
+
+bool
+Searcher::_IsWholeWord(const char* text, size_t length, size_t start,
+	size_t end) const
+{
+	if(start > 0 && IsWordChar(text[start - 1]) == true)
+		return false;
+	if(end < length && IsWordChar(text[end]) == true)
+		return false;
+	return true;
+}
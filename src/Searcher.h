@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef SEARCHER_H
+#define SEARCHER_H
+
+
+#include <SupportDefs.h>
+
+#include <cstddef>
+#include <regex>
+#include <string>
+#include <vector>
+
+
+/*
+ * Text matcher shared by in-document Find/Replace and Find/Replace in files.
+ * It works on raw buffers (Scintilla character pointer or file contents),
+ * so neither path has to copy the text before searching.
+ *
+ * Regular expressions use ECMAScript syntax and, like Scintilla, never span
+ * more than one line. Replacement text may then refer to capture groups with
+ * $1 or \1 ($0, \0 and $& for the whole match) and change case with \U, \L,
+ * \u, \l and \E. In plain text mode replacement is inserted verbatim.
+ *
+ * Plain text search ignoring case compares Unicode simple case foldings, so
+ * a match may differ in length from the pattern (e.g. Kelvin sign and k).
+ * Regular expressions ignore case of ASCII letters only.
+ */
+class Searcher {
+public:
+	struct Match {
+		size_t			start;
+		size_t			end;
+		std::cmatch		groups;
+			// only filled in regex mode, reused between calls
+	};
+
+							Searcher(const std::string& pattern,
+								const std::string& replacement,
+								bool matchCase, bool matchWord,
+								bool regex = false);
+
+			bool			IsValid() const { return fValid; }
+
+			// text/length describe the whole buffer, so that word boundaries
+			// can be checked outside of the searched [from, to) range.
+			bool			Find(const char* text, size_t length,
+								size_t from, size_t to, Match& match) const;
+			bool			FindLast(const char* text, size_t length,
+								size_t from, size_t to, Match& match) const;
+			size_t			Count(const char* text, size_t length) const;
+
+			// Appends replacement for a match found by this searcher.
+			void			Expand(const Match& match, std::string& output) const;
+
+			// Appends [first match start, last match end) with every match
+			// replaced to output and returns number of replacements. Span of
+			// the rewritten range is returned in replaced.
+			size_t			ReplaceAll(const char* text, size_t length,
+								size_t from, size_t to,
+								std::string& output, Match& replaced) const;
+
+private:
+	struct Part {
+		enum Type {
+			LITERAL,
+			GROUP,
+			UPPER,
+			LOWER,
+			UPPER_NEXT,
+			LOWER_NEXT,
+			END_CASE
+		};
+		Type	type;
+		size_t	offset;
+			// into fReplacement for literals, group number for groups
+		size_t	length;
+	};
+
+			void			_CompileReplacement(const std::string& replacement);
+			bool			_FindLiteral(const char* text, size_t length,
+								size_t from, size_t to, Match& match) const;
+			bool			_FindLastLiteral(const char* text, size_t length,
+								size_t from, size_t to, Match& match) const;
+			bool			_FindRegex(const char* text, size_t length,
+								size_t from, size_t to, Match& match) const;
+			bool			_SearchLine(const char* text, size_t length,
+								size_t from, size_t to, Match& match) const;
+			bool			_MatchAt(const char* text, size_t start, size_t to,
+								size_t& end) const;
+			bool			_IsWholeWord(const char* text, size_t length,
+								size_t start, size_t end) const;
+
+			std::string		fPattern;
+			bool			fMatchCase;
+			bool			fMatchWord;
+			bool			fRegex;
+			bool			fValid;
+			std::regex		fExpression;
+
+			std::vector<uint32>	fFolded;
+				// folded pattern when case is ignored
+			std::vector<char>	fFirstBytes;
+			bool			fLeadBytes[256];
+				// bytes which can start a match when case is ignored
+
+			std::string		fReplacement;
+				// literal replacement, or unescaped literal parts of template
+			std::vector<Part>	fParts;
+};
+
+
+#endif // SEARCHER_H
@@ -5,203 +5,271 @@
 
 #include "Styler.h"
 
-#include <cstdlib>
-#include <yaml.h>
-
-#include <FindDirectory.h>
-#include <Path.h>
+#include <Autolock.h>
 #include <String.h>
+#include <Window.h>
 
+#include "DataLoader.h"
 #include "Editor.h"
-#include "EditorWindow.h"
 
 
-/* static */ void
-Styler::ApplyGlobal(Editor* editor, const char* style)
+BLocker Styler::sLock("Styler");
+std::map<std::string, Styler::GlobalPtr> Styler::sGlobals;
+std::map<std::string, Styler::LanguagePtr> Styler::sLanguages;
+std::map<std::string, Styler::StatePtr> Styler::sResolved;
+
+
+bool
+Styler::Attributes::operator==(const Attributes& other) const
+{
+	return fgColor == other.fgColor && bgColor == other.bgColor
+		&& bold == other.bold && italic == other.italic
+		&& underline == other.underline;
+}
+
+
+void
+Styler::Attributes::Apply(const StyleRecord& record)
 {
-	BPath dataPath;
-	find_directory(B_SYSTEM_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyGlobal(editor, style, dataPath);
-	} catch (YAML::BadFile &) {
-	}
-	find_directory(B_USER_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyGlobal(editor, style, dataPath);
-	} catch (YAML::BadFile &) {
-	}
-	find_directory(B_SYSTEM_NONPACKAGED_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyGlobal(editor, style, dataPath);
-	} catch (YAML::BadFile &) {
-	}
-	find_directory(B_USER_NONPACKAGED_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyGlobal(editor, style, dataPath);
-	} catch (YAML::BadFile &) {
+	if(record.fgColor != -1)
+		fgColor = record.fgColor;
+	if(record.bgColor != -1)
+		bgColor = record.bgColor;
+	if(record.fontStyle != -1) {
+		// styles are only ever turned on
+		bold = bold || (record.fontStyle & 1);
+		italic = italic || (record.fontStyle & 2);
+		underline = underline || (record.fontStyle & 4);
 	}
 }
 
 
 /* static */ void
-Styler::_ApplyGlobal(Editor* editor, const char* style, const BPath &path)
+Styler::Apply(Editor* editor, const char* style, const char* lang)
 {
-	BPath p(path);
-	p.Append(gAppName);
-	p.Append("styles");
-	p.Append(style);
-	const YAML::Node global = YAML::LoadFile(std::string(p.Path()) + ".yaml");
-
-	int id, fg, bg, fs;
-	if(global["Default"]) {
-		_GetAttributesFromNode(global["Default"], &id, &fg, &bg, &fs);
-
-		font_family fixed;
-		be_fixed_font->GetFamilyAndStyle(&fixed, NULL);
-		editor->SendMessage(SCI_STYLESETFONT, id, (sptr_t) fixed);
-		editor->SendMessage(SCI_STYLESETSIZE, id, (sptr_t) be_fixed_font->Size());
-		_SetAttributesInEditor(editor, id, fg, bg, fs);
-		editor->SendMessage(SCI_STYLECLEARALL, 0, 0);
-	}
-	for(YAML::const_iterator it = global.begin(); it != global.end(); ++it) {
-		std::string name = it->first.as<std::string>();
-		_GetAttributesFromNode(global[name], &id, &fg, &bg, &fs);
-		if(id != -1) {
-			_SetAttributesInEditor(editor, id, fg, bg, fs);
-		} else {
-			if(name == "Current line") {
-				editor->SendMessage(SCI_SETCARETLINEBACK, bg, 0);
-				//editor->SendMessage(SCI_SETCARETLINEBACKALPHA, 128, 0);
-			}
-			else if(name == "Whitespace") {
-				if(fg != -1) {
-					editor->SendMessage(SCI_SETWHITESPACEFORE, true, fg);
-				}
-				if(bg != -1) {
-					editor->SendMessage(SCI_SETWHITESPACEBACK, true, bg);
-				}
-			}
-			else if(name == "Selected text") {
-				if(fg != -1) {
-					editor->SendMessage(SCI_SETSELFORE, true, fg);
-				}
-				if(bg != -1) {
-					editor->SendMessage(SCI_SETSELBACK, true, bg);
-				}
-			}
-			else if(name == "Caret") {
-				editor->SendMessage(SCI_SETCARETFORE, fg, 0);
-			}
-			else if(name == "Edge") {
-				editor->SendMessage(SCI_SETEDGECOLOUR, fg, 0);
-			}
-			else if(name == "Fold") {
-				if(fg != -1) {
-					editor->SendMessage(SCI_SETFOLDMARGINHICOLOUR, true, fg);
-				}
-				if(bg != -1) {
-					editor->SendMessage(SCI_SETFOLDMARGINCOLOUR, true, bg);
-				}
-			}
+	const bigtime_t start = system_time();
+	EditorState& current = editor->StyleState();
+
+	// Attributes come from the state resolved once per style and language,
+	// special colours not set by the style keep their values.
+	const StatePtr resolved = _Resolve(style, lang);
+	EditorState target = *resolved;
+	target.special = current.special;
+	for(const auto& it : resolved->special)
+		target.special[it.first] = it.second;
+	font_family fixed;
+	be_fixed_font->GetFamilyAndStyle(&fixed, NULL);
+	target.font = fixed;
+	target.size = be_fixed_font->Size();
+
+	// Every message invalidates the view, so draw only once at the end.
+	BWindow* window = editor->Window();
+	if(window != NULL)
+		window->DisableUpdates();
+	int32 messages = 0;
+	if(current.valid == false || current.font != target.font
+			|| current.size != target.size) {
+		// Set everything from scratch. Attributes of STYLE_DEFAULT are
+		// copied to all other styles, so only differences from it are sent.
+		const Attributes& def = target.styles[STYLE_DEFAULT];
+		Attributes unknown;
+		unknown.fgColor = unknown.bgColor = -1;
+		unknown.bold = !def.bold;
+		unknown.italic = !def.italic;
+		unknown.underline = !def.underline;
+		ScintillaDirect& direct = editor->Direct();
+		direct.StyleSetFont(STYLE_DEFAULT, target.font.c_str());
+		direct.StyleSetSize(STYLE_DEFAULT, target.size);
+		messages += 2 + _SendAttributes(editor, STYLE_DEFAULT, def, unknown);
+		direct.StyleClearAll();
+		messages++;
+		for(int id = 0; id <= STYLE_MAX; id++) {
+			if(id != STYLE_DEFAULT)
+				messages += _SendAttributes(editor, id, target.styles[id], def);
 		}
+		current.special.clear();
+	} else {
+		for(int id = 0; id <= STYLE_MAX; id++)
+			messages += _SendAttributes(editor, id, target.styles[id], current.styles[id]);
 	}
+	// Themes give tag highlights as styles, editor draws them with
+	// indicators of the same number.
+	for(int indicator : { Editor::TAG_ATTRIBUTES, Editor::TAG_MATCH,
+			Editor::SCOPE }) {
+		const int color = target.styles[indicator].bgColor;
+		if(current.valid == false || current.styles[indicator].bgColor != color) {
+			editor->Direct().IndicSetFore(indicator, color);
+			messages++;
+		}
+	}
+	for(const auto& it : target.special) {
+		auto sent = current.special.find(it.first);
+		if(sent == current.special.end() || sent->second != it.second) {
+			editor->SendMessage(it.first, it.second.first, it.second.second);
+			messages++;
+		}
+	}
+	target.valid = true;
+	current = target;
+	// the margin is sized by the width of digits in its style
+	editor->UpdateLineNumberWidth();
+	if(window != NULL)
+		window->EnableUpdates();
+	current.messages = messages;
+	current.time = system_time() - start;
 }
 
 
-/* static */ void
-Styler::ApplyLanguage(Editor* editor, const char* style, const char* lang)
+/* static */ bool
+Styler::Invalidate(const std::string& name)
 {
-	BPath dataPath;
-	find_directory(B_SYSTEM_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyLanguage(editor, style, lang, dataPath);
-	} catch (YAML::BadFile &) {
-	}
-	find_directory(B_USER_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyLanguage(editor, style, lang, dataPath);
-	} catch (YAML::BadFile &) {
-	}
-	find_directory(B_SYSTEM_NONPACKAGED_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyLanguage(editor, style, lang, dataPath);
-	} catch (YAML::BadFile &) {
-	}
-	find_directory(B_USER_NONPACKAGED_DATA_DIRECTORY, &dataPath);
-	try {
-		_ApplyLanguage(editor, style, lang, dataPath);
-	} catch (YAML::BadFile &) {
-	}
+	if(name.compare(0, 7, "styles/") != 0)
+		return false;
+	const std::string key = name.substr(7);
+	BAutolock lock(sLock);
+	if(key.find('/') == std::string::npos)
+		sGlobals.erase(key);
+	else
+		sLanguages.erase(key);
+	sResolved.clear();
+	return true;
 }
 
 
-/* static */ void
-Styler::_ApplyLanguage(Editor* editor, const char* style, const char* lang, const BPath &path)
+/* static */ Styler::GlobalPtr
+Styler::_Global(const char* style)
 {
-	BPath p(path);
-	p.Append(gAppName);
-	p.Append("styles");
-	p.Append(style);
-	p.Append(lang);
-	const YAML::Node language = YAML::LoadFile(std::string(p.Path()) + ".yaml");
-	int id, fg, bg, fs;
-	for(YAML::const_iterator it = language.begin(); it != language.end(); ++it) {
-		std::string name = it->first.as<std::string>();
-		_GetAttributesFromNode(language[name], &id, &fg, &bg, &fs);
-		_SetAttributesInEditor(editor, id, fg, bg, fs);
-	}
+	BAutolock lock(sLock);
+	auto cached = sGlobals.find(style);
+	if(cached != sGlobals.end())
+		return cached->second;
+	return sGlobals[style] = std::make_shared<const GlobalStyleTable>(
+		DataLoader::LoadGlobalStyle(style));
 }
 
 
-void
-Styler::_GetAttributesFromNode(const YAML::Node &node, int* styleId, int* fgColor,
-	int* bgColor, int* fontStyle)
+/* static */ Styler::LanguagePtr
+Styler::_Language(const char* style, const char* lang)
+{
+	BAutolock lock(sLock);
+	const std::string key = std::string(style) + "/" + lang;
+	auto cached = sLanguages.find(key);
+	if(cached != sLanguages.end())
+		return cached->second;
+	return sLanguages[key] = std::make_shared<const LanguageStyleTable>(
+		DataLoader::LoadLanguageStyle(style, lang));
+}
+
+
+// Computes the state sending everything one by one would leave on a fresh
+// editor, the way it used to be done: Default followed by
+// SCI_STYLECLEARALL, then global and language styles.
+/* static */ Styler::StatePtr
+Styler::_Resolve(const char* style, const char* lang)
 {
-	*styleId = -1;
-	*fgColor = -1;
-	*bgColor = -1;
-	*fontStyle = -1;
-
-	if(node["id"]) {
-		*styleId = node["id"].as<int>();
-	}
-	if(node["foreground"]) {
-		*fgColor = strtol(node["foreground"].as<std::string>().c_str(), NULL, 16);
-	}
-	if(node["background"]) {
-		*bgColor = strtol(node["background"].as<std::string>().c_str(), NULL, 16);
-	}
-	if(node["style"]) {
-		*fontStyle = 0;
-		auto styles = node["style"].as<std::vector<std::string>>();
-		for(auto style : styles) {
-			if(style == "bold") *fontStyle |= 1;
-			else if(style == "italic") *fontStyle |= 2;
-			else if(style == "underline") *fontStyle |= 4;
+	const std::string key = std::string(style) + "/" + (lang != NULL ? lang : "");
+	{
+		BAutolock lock(sLock);
+		auto cached = sResolved.find(key);
+		if(cached != sResolved.end())
+			return cached->second;
+	}
+
+	std::shared_ptr<EditorState> state = std::make_shared<EditorState>();
+	const GlobalPtr global = _Global(style);
+	if(global->hasDefault == true) {
+		state->styles[STYLE_DEFAULT].Apply(global->defaultStyle);
+		for(auto& attributes : state->styles)
+			attributes = state->styles[STYLE_DEFAULT];
+	}
+	for(const auto& it : global->styles) {
+		if(it.first >= 0 && it.first <= STYLE_MAX)
+			state->styles[it.first].Apply(it.second);
+	}
+	for(const auto& it : global->special)
+		_AddSpecial(*state, it.first, it.second);
+	if(lang != NULL) {
+		const LanguagePtr language = _Language(style, lang);
+		for(const auto& it : language->styles) {
+			if(it.first >= 0 && it.first <= STYLE_MAX)
+				state->styles[it.first].Apply(it.second);
 		}
 	}
+
+	BAutolock lock(sLock);
+	return sResolved[key] = state;
 }
 
 
-void
-Styler::_SetAttributesInEditor(Editor* editor, int styleId, int fgColor,
-	int bgColor, int fontStyle)
+/* static */ void
+Styler::_AddSpecial(EditorState& state, const std::string& name,
+	const StyleRecord& record)
 {
-	if(fgColor != -1) {
-		editor->SendMessage(SCI_STYLESETFORE, styleId, fgColor);
+	const int fg = record.fgColor;
+	const int bg = record.bgColor;
+	if(name == "Current line") {
+		state.special[SCI_SETCARETLINEBACK] = std::make_pair(bg, 0);
+		//SCI_SETCARETLINEBACKALPHA, 128
 	}
-	if(bgColor != -1) {
-		editor->SendMessage(SCI_STYLESETBACK, styleId, bgColor);
+	else if(name == "Whitespace") {
+		if(fg != -1) {
+			state.special[SCI_SETWHITESPACEFORE] = std::make_pair(true, fg);
+		}
+		if(bg != -1) {
+			state.special[SCI_SETWHITESPACEBACK] = std::make_pair(true, bg);
+		}
 	}
-	if(fontStyle != -1) {
-		if(fontStyle & 1) {
-			editor->SendMessage(SCI_STYLESETBOLD, styleId, true);
+	else if(name == "Selected text") {
+		if(fg != -1) {
+			state.special[SCI_SETSELFORE] = std::make_pair(true, fg);
 		}
-		if(fontStyle & 2) {
-			editor->SendMessage(SCI_STYLESETITALIC, styleId, true);
+		if(bg != -1) {
+			state.special[SCI_SETSELBACK] = std::make_pair(true, bg);
 		}
-		if(fontStyle & 4) {
-			editor->SendMessage(SCI_STYLESETUNDERLINE, styleId, true);
+	}
+	else if(name == "Caret") {
+		state.special[SCI_SETCARETFORE] = std::make_pair(fg, 0);
+	}
+	else if(name == "Edge") {
+		state.special[SCI_SETEDGECOLOUR] = std::make_pair(fg, 0);
+	}
+	else if(name == "Fold") {
+		if(fg != -1) {
+			state.special[SCI_SETFOLDMARGINHICOLOUR] = std::make_pair(true, fg);
+		}
+		if(bg != -1) {
+			state.special[SCI_SETFOLDMARGINCOLOUR] = std::make_pair(true, bg);
 		}
 	}
 }
+
+
+// Sends attributes which differ from current, returns number of messages.
+/* static */ int32
+Styler::_SendAttributes(Editor* editor, int id, const Attributes& attributes,
+	const Attributes& current)
+{
+	ScintillaDirect& direct = editor->Direct();
+	int32 messages = 0;
+	if(attributes.fgColor != current.fgColor) {
+		direct.StyleSetFore(id, attributes.fgColor);
+		messages++;
+	}
+	if(attributes.bgColor != current.bgColor) {
+		direct.StyleSetBack(id, attributes.bgColor);
+		messages++;
+	}
+	if(attributes.bold != current.bold) {
+		direct.StyleSetBold(id, attributes.bold);
+		messages++;
+	}
+	if(attributes.italic != current.italic) {
+		direct.StyleSetItalic(id, attributes.italic);
+		messages++;
+	}
+	if(attributes.underline != current.underline) {
+		direct.StyleSetUnderline(id, attributes.underline);
+		messages++;
+	}
+	return messages;
+}
@@ -7,25 +7,87 @@
 #define STYLER_H
 
 
-#include <yaml.h>
+#include <Locker.h>
+#include <SupportDefs.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <Scintilla.h>
+
+#include "DataTables.h"
 
 
-class BPath;
 class Editor;
 
 
+/*
+ * Styles are read from all data directories on first use and merged into
+ * tables kept for the lifetime of the process, so applying a style to
+ * another editor does not touch the disk.
+ */
 class Styler {
 public:
-	static	void	ApplyGlobal(Editor* editor, const char* style);
-	static	void	ApplyLanguage(Editor* editor, const char* style, const char* lang);
+	struct Attributes {
+					Attributes() : fgColor(0), bgColor(0xFFFFFF),
+						bold(false), italic(false), underline(false) {}
+						// Scintilla defaults
+
+		bool		operator==(const Attributes& other) const;
+		bool		operator!=(const Attributes& other) const
+						{ return !(*this == other); }
+		void		Apply(const StyleRecord& record);
+
+		int			fgColor;
+		int			bgColor;
+		bool		bold;
+		bool		italic;
+		bool		underline;
+	};
+	// What was last sent to an editor, so only differences are sent when
+	// the theme or language changes.
+	struct EditorState {
+					EditorState() : valid(false), size(0), messages(0),
+						time(0) {}
+
+		bool		valid;
+		std::string	font;
+		int			size;
+		Attributes	styles[STYLE_MAX + 1];
+		std::map<int, std::pair<uptr_t, sptr_t>>	special;
+			// keyed by message, e.g. SCI_SETCARETFORE
+		int32		messages;
+		bigtime_t	time;
+			// taken by the last Apply()
+	};
+
+	// lang can be NULL to apply only the global style.
+	static	void	Apply(Editor* editor, const char* style, const char* lang);
+	// Drops cached tables read from data file name, as used by DataLoader.
+	// Returns false if it does not hold styles.
+	static	bool	Invalidate(const std::string& name);
 
 private:
-	static	void	_ApplyGlobal(Editor* editor, const char* style, const BPath &path);
-	static	void	_ApplyLanguage(Editor* editor, const char* style, const char* lang, const BPath &path);
-	static	void	_GetAttributesFromNode(const YAML::Node &node, int* styleId,
-						int* fgColor, int* bgColor, int* fontStyle);
-	static	void	_SetAttributesInEditor(Editor* editor, int styleId,
-						int fgColor, int bgColor, int fontStyle);
+	typedef std::shared_ptr<const GlobalStyleTable> GlobalPtr;
+	typedef std::shared_ptr<const LanguageStyleTable> LanguagePtr;
+	typedef std::shared_ptr<const EditorState> StatePtr;
+		// windows may still apply a table while it is invalidated
+
+	static	GlobalPtr		_Global(const char* style);
+	static	LanguagePtr		_Language(const char* style, const char* lang);
+	static	StatePtr		_Resolve(const char* style, const char* lang);
+	static	void	_AddSpecial(EditorState& state, const std::string& name,
+						const StyleRecord& record);
+	static	int32	_SendAttributes(Editor* editor, int id,
+						const Attributes& attributes, const Attributes& current);
+
+	static	BLocker							sLock;
+	static	std::map<std::string, GlobalPtr>	sGlobals;
+	static	std::map<std::string, LanguagePtr>	sLanguages;
+	static	std::map<std::string, StatePtr>		sResolved;
+		// editor state for style and language, shared by all windows
 };
 
 
@@ -0,0 +1,748 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "SymbolIndex.h"
+
+#include <Message.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include "Editor.h"
+
+
+namespace {
+
+const int32 kMaxIncrementalLines = 1000;
+	// edits adding or removing more lines, like loading a file, rescan all
+const int32 kTabWidth = 4;
+
+
+bool
+IsIdentifierChar(char c)
+{
+	return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+
+bool
+IsIdentifierStart(char c)
+{
+	return isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+
+const char*
+FindWord(const char* start, const char* end, const char* word)
+{
+	const char* found = std::search(start, end, word, word + strlen(word));
+	return found != end ? found : NULL;
+}
+
+
+bool
+StartsWithWord(const char* start, const char* end, const char* word)
+{
+	const size_t length = strlen(word);
+	return static_cast<size_t>(end - start) >= length
+		&& strncmp(start, word, length) == 0
+		&& (start + length == end || !IsIdentifierChar(start[length]));
+}
+
+
+int32
+SkipIndent(const char*& pos, const char* end)
+{
+	int32 indent = 0;
+	for(; pos < end && (*pos == ' ' || *pos == '\t'); pos++)
+		indent = *pos == '\t' ? (indent / kTabWidth + 1) * kTabWidth : indent + 1;
+	return indent;
+}
+
+
+const char*
+TrimEnd(const char* start, const char* end)
+{
+	while(end > start && isspace(static_cast<unsigned char>(end[-1])))
+		end--;
+	return end;
+}
+
+
+std::string
+ReadIdentifier(const char*& pos, const char* end)
+{
+	const char* start = pos;
+	while(pos < end && IsIdentifierChar(*pos))
+		pos++;
+	return std::string(start, pos);
+}
+
+
+// Only column 0 is looked at, where function definitions and types start
+// in most C and C++ code, e.g.
+//	status_t
+//	Foo::Bar(int32 baz)
+bool
+ScanCpp(const char* line, size_t length, const SymbolIndex::Symbol* previous,
+	SymbolIndex::Symbol& symbol)
+{
+	if(length == 0 || !IsIdentifierStart(line[0]))
+		return false;
+	const char* end = line + length;
+	const char* comment = static_cast<const char*>(memchr(line, '/', length));
+	for(; comment != NULL && comment + 1 < end; comment = static_cast<const char*>(
+			memchr(comment + 1, '/', end - comment - 1))) {
+		if(comment[1] == '/' || comment[1] == '*') {
+			end = comment;
+			break;
+		}
+	}
+	end = TrimEnd(line, end);
+	if(end == line || end[-1] == ';')
+		return false;
+		// declaration
+
+	static const char* skipped[] = { "typedef", "namespace", "using",
+		"template", "return", "else", "public", "protected", "private", NULL };
+	for(int32 i = 0; skipped[i] != NULL; i++) {
+		if(StartsWithWord(line, end, skipped[i]))
+			return false;
+	}
+
+	const char* paren = static_cast<const char*>(memchr(line, '(', end - line));
+	if(paren == NULL) {
+		static const char* types[] = { "class", "struct", "union", "enum", NULL };
+		bool isType = false;
+		for(int32 i = 0; types[i] != NULL && isType == false; i++)
+			isType = StartsWithWord(line, end, types[i]);
+		if(isType == false)
+			return false;
+		// the last identifier before the base clause or the body
+		const char* pos = line;
+		ReadIdentifier(pos, end);
+		std::string name;
+		while(pos < end && *pos != '{') {
+			if(*pos == ':') {
+				if(pos + 1 == end || pos[1] != ':')
+					break;
+				pos += 2;
+			} else if(IsIdentifierChar(*pos)) {
+				std::string word = ReadIdentifier(pos, end);
+				if(word != "class" && word != "final")
+					name = word;
+			} else
+				pos++;
+		}
+		if(name.empty())
+			return false;
+		symbol.kind = SymbolIndex::TYPE;
+		symbol.indent = 0;
+		symbol.name = name;
+		return true;
+	}
+
+	const char* operatorName = NULL;
+	for(const char* found = line; (found = FindWord(found, paren, "operator")) != NULL;
+			found++) {
+		operatorName = found;
+	}
+	if(memchr(line, '=', paren - line) != NULL && operatorName == NULL)
+		return false;
+		// initialized variable
+	const char* nameEnd = TrimEnd(line, paren);
+	const char* nameStart = nameEnd;
+	while(nameStart > line && (IsIdentifierChar(nameStart[-1])
+			|| nameStart[-1] == ':' || nameStart[-1] == '~'))
+		nameStart--;
+	if(operatorName != NULL && operatorName < nameStart) {
+		nameStart = operatorName;
+		while(nameStart > line && (IsIdentifierChar(nameStart[-1])
+				|| nameStart[-1] == ':'))
+			nameStart--;
+	}
+	if(nameStart == nameEnd || !IsIdentifierStart(*nameStart))
+		return false;
+
+	// leave out macros and keywords which can be followed by a parenthesis
+	const char* last = nameEnd;
+	while(last > nameStart && last[-1] != ':')
+		last--;
+	bool lowercase = false;
+	for(const char* c = last; c < nameEnd && lowercase == false; c++)
+		lowercase = islower(static_cast<unsigned char>(*c));
+	static const char* keywords[] = { "if", "for", "while", "switch",
+		"sizeof", "alignof", "decltype", "static_assert", NULL };
+	for(int32 i = 0; keywords[i] != NULL && lowercase == true; i++) {
+		if(StartsWithWord(last, nameEnd, keywords[i]) && nameEnd - last
+				== static_cast<ptrdiff_t>(strlen(keywords[i])))
+			lowercase = false;
+	}
+	if(lowercase == false)
+		return false;
+
+	symbol.kind = SymbolIndex::FUNCTION;
+	symbol.indent = 0;
+	symbol.name.assign(nameStart, nameEnd);
+	return true;
+}
+
+
+bool
+ScanPython(const char* line, size_t length, const SymbolIndex::Symbol* previous,
+	SymbolIndex::Symbol& symbol)
+{
+	const char* pos = line;
+	const char* end = line + length;
+	const int32 indent = SkipIndent(pos, end);
+	if(StartsWithWord(pos, end, "async")) {
+		pos += 5;
+		SkipIndent(pos, end);
+	}
+	SymbolIndex::Kind kind;
+	if(StartsWithWord(pos, end, "def")) {
+		kind = SymbolIndex::FUNCTION;
+		pos += 3;
+	} else if(StartsWithWord(pos, end, "class")) {
+		kind = SymbolIndex::TYPE;
+		pos += 5;
+	} else
+		return false;
+	SkipIndent(pos, end);
+	std::string name = ReadIdentifier(pos, end);
+	if(name.empty())
+		return false;
+	symbol.kind = kind;
+	symbol.indent = indent;
+	symbol.name = name;
+	return true;
+}
+
+
+bool
+ScanYaml(const char* line, size_t length, const SymbolIndex::Symbol* previous,
+	SymbolIndex::Symbol& symbol)
+{
+	const char* pos = line;
+	const char* end = TrimEnd(line, line + length);
+	int32 indent = SkipIndent(pos, end);
+	while(pos + 1 < end && pos[0] == '-' && pos[1] == ' ') {
+		// key of a mapping in a sequence
+		pos += 2;
+		indent += 2 + SkipIndent(pos, end);
+	}
+	if(pos == end || strchr("#-[]{}|>!&*%@`,?", *pos) != NULL)
+		return false;
+
+	const char* keyStart = pos;
+	const char* keyEnd;
+	if(*pos == '"' || *pos == '\'') {
+		const char* quote = static_cast<const char*>(memchr(pos + 1, *pos, end - pos - 1));
+		if(quote == NULL)
+			return false;
+		keyStart = pos + 1;
+		keyEnd = quote;
+		pos = quote + 1;
+	} else {
+		for(; pos < end; pos++) {
+			if(*pos == ':' && (pos + 1 == end || pos[1] == ' ' || pos[1] == '\t'))
+				break;
+			if(*pos == '#' && (pos[-1] == ' ' || pos[-1] == '\t'))
+				return false;
+		}
+		keyEnd = TrimEnd(keyStart, pos);
+	}
+	if(pos == end || *pos != ':' || keyStart == keyEnd)
+		return false;
+	symbol.kind = SymbolIndex::KEY;
+	symbol.indent = indent;
+	symbol.name.assign(keyStart, keyEnd);
+	return true;
+}
+
+
+bool
+ScanMakefile(const char* line, size_t length, const SymbolIndex::Symbol* previous,
+	SymbolIndex::Symbol& symbol)
+{
+	const char* end = TrimEnd(line, line + length);
+	if(end == line || line[0] == ' ' || line[0] == '\t' || line[0] == '#'
+			|| line[0] == '.')
+		return false;
+		// recipes, comments and special targets
+	static const char* directives[] = { "ifeq", "ifneq", "ifdef", "ifndef",
+		"else", "endif", "include", "-include", "sinclude", "define", "endef",
+		"export", "unexport", "override", "vpath", NULL };
+	for(int32 i = 0; directives[i] != NULL; i++) {
+		if(StartsWithWord(line, end, directives[i]))
+			return false;
+	}
+
+	const char* colon = static_cast<const char*>(memchr(line, ':', end - line));
+	if(colon == NULL || memchr(line, '=', colon - line) != NULL)
+		return false;
+	const char* next = colon + 1;
+	if(next < end && *next == ':')
+		next++;
+	if(next < end && *next == '=')
+		return false;
+		// := and ::= assignments
+	const char* nameEnd = TrimEnd(line, colon);
+	if(nameEnd == line)
+		return false;
+	symbol.kind = SymbolIndex::TARGET;
+	symbol.indent = 0;
+	symbol.name.assign(line, nameEnd);
+	return true;
+}
+
+
+// Path of a file header, without timestamp and git's a/ and b/ prefixes.
+std::string
+DiffPath(const char* start, const char* end)
+{
+	const char* tab = static_cast<const char*>(memchr(start, '\t', end - start));
+	if(tab != NULL)
+		end = TrimEnd(start, tab);
+	if(end - start > 2 && (start[0] == 'a' || start[0] == 'b') && start[1] == '/')
+		start += 2;
+	return std::string(start, end);
+}
+
+
+int32
+ReadNumber(const char*& pos, const char* end)
+{
+	int32 number = 0;
+	for(; pos < end && isdigit(static_cast<unsigned char>(*pos)); pos++)
+		number = number * 10 + *pos - '0';
+	return number;
+}
+
+
+// Unified diffs. Hunk headers give how many lines of each file follow:
+//	@@ -12,7 +12,9 @@ context
+// Files start at "--- " headers, unless it is a line removed by a hunk
+// which has not ended yet.
+bool
+ScanDiff(const char* line, size_t length, const SymbolIndex::Symbol* previous,
+	SymbolIndex::Symbol& symbol)
+{
+	const char* end = TrimEnd(line, line + length);
+	if(end - line > 4 && strncmp(line, "@@ -", 4) == 0) {
+		const char* pos = line + 3;
+		int32 pending = 0;
+		for(const char sign : { '-', '+' }) {
+			if(pos == end || *pos != sign)
+				return false;
+			pos++;
+			ReadNumber(pos, end);
+			int32 count = 1;
+			if(pos < end && *pos == ',') {
+				pos++;
+				count = ReadNumber(pos, end);
+			}
+			pending += count;
+			while(pos < end && *pos == ' ')
+				pos++;
+		}
+		symbol.kind = SymbolIndex::HUNK;
+		symbol.indent = 1;
+		symbol.name.assign(line, end);
+		symbol.added = symbol.removed = 0;
+		symbol.pending = pending;
+		return true;
+	}
+	if(end - line > 4 && strncmp(line, "--- ", 4) == 0 && (previous == NULL
+			|| previous->kind != SymbolIndex::HUNK || previous->pending <= 0)) {
+		symbol.kind = SymbolIndex::FILE;
+		symbol.indent = 0;
+		symbol.name = DiffPath(line + 4, end);
+		symbol.added = symbol.removed = 0;
+		symbol.pending = 0;
+		return true;
+	}
+	return false;
+}
+
+
+// Counts lines of hunks, and names files after their new path.
+void
+ScanDiffBody(const char* line, size_t length, SymbolIndex::Symbol& symbol)
+{
+	if(symbol.kind == SymbolIndex::FILE) {
+		const char* end = TrimEnd(line, line + length);
+		if(end - line > 4 && strncmp(line, "+++ ", 4) == 0) {
+			const std::string path = DiffPath(line + 4, end);
+			if(path != "/dev/null")
+				symbol.name = path;
+				// removed files keep the old one
+		}
+		return;
+	}
+	if(symbol.kind != SymbolIndex::HUNK || symbol.pending <= 0)
+		return;
+	switch(length > 0 ? line[0] : ' ') {
+		case ' ':
+		case '\r':
+			symbol.pending -= 2;
+				// context is in both files, some tools strip its space
+		break;
+		case '-':
+			symbol.removed++;
+			symbol.pending--;
+		break;
+		case '+':
+			symbol.added++;
+			symbol.pending--;
+		break;
+		case '\\':
+		break;
+			// no newline at end of file
+		default:
+			symbol.pending = 0;
+			// the hunk was cut short
+		break;
+	}
+}
+
+
+bool
+ContainsIgnoringCase(const std::string& name, const std::string& lowered,
+	bool& prefix)
+{
+	auto found = std::search(name.begin(), name.end(), lowered.begin(),
+		lowered.end(), [](char a, char b) {
+			return tolower(static_cast<unsigned char>(a)) == b; });
+	prefix = found == name.begin();
+	return found != name.end() || lowered.empty();
+}
+
+}
+
+
+SymbolIndex::SymbolIndex(Editor* editor)
+	:
+	fEditor(editor),
+	fScanner(NULL),
+	fBodyScanner(NULL),
+	fThread(-1),
+	fCancelled(false),
+	fGeneration(0)
+{
+}
+
+
+SymbolIndex::~SymbolIndex()
+{
+	_StopScan();
+}
+
+
+void
+SymbolIndex::SetLanguage(const std::string& lang)
+{
+	// the scan thread calls the scanners
+	_StopScan();
+	fScanner = ScannerFor(lang);
+	fBodyScanner = BodyScannerFor(lang);
+	_StartScan();
+}
+
+
+bool
+SymbolIndex::Finish(BMessage* message)
+{
+	if(fThread < 0 || message->GetUInt32("generation", 0) != fGeneration)
+		return false;
+		// superseded by another scan
+
+	status_t exitValue;
+	wait_for_thread(fThread, &exitValue);
+	fThread = -1;
+	fSymbols.swap(fScanned);
+	std::vector<Symbol>().swap(fScanned);
+	std::string().swap(fScanText);
+
+	// bring the result up to date with edits made in the meantime, the
+	// lines they touched are rescanned as one range
+	int32 dirtyFirst = -1;
+	int32 dirtyLast = -1;
+	for(const auto& edit : fPendingEdits) {
+		const int32 first = edit.first;
+		const int32 added = edit.second;
+		_ApplyEdit(first, added);
+		if(dirtyFirst != -1) {
+			const int32 oldLast = first + std::max(0, -added);
+			if(dirtyFirst > oldLast)
+				dirtyFirst += added;
+			else if(dirtyFirst > first)
+				dirtyFirst = first;
+			if(dirtyLast > oldLast)
+				dirtyLast += added;
+			else if(dirtyLast >= first)
+				dirtyLast = first + std::max(0, added);
+		}
+		dirtyFirst = dirtyFirst == -1 ? first : std::min(dirtyFirst, first);
+		dirtyLast = std::max(dirtyLast, first + std::max(0, added));
+	}
+	fPendingEdits.clear();
+	if(dirtyFirst != -1)
+		_Rescan(dirtyFirst, dirtyLast);
+	return true;
+}
+
+
+bool
+SymbolIndex::Modified(const SCNotification* notification)
+{
+	if(fScanner == NULL || (notification->modificationType
+			& (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) == 0)
+		return false;
+
+	const int32 first = fEditor->SendMessage(SCI_LINEFROMPOSITION,
+		notification->position, 0);
+	const int32 added = notification->linesAdded;
+	if(std::abs(added) > kMaxIncrementalLines) {
+		_StartScan();
+		return false;
+	}
+	if(fThread >= 0) {
+		fPendingEdits.push_back(std::make_pair(first, added));
+		return false;
+	}
+	bool changed = _ApplyEdit(first, added);
+	if(_Rescan(first, first + std::max(0, added)) == true)
+		changed = true;
+	return changed;
+}
+
+
+/* static */ SymbolIndex::LineScanner
+SymbolIndex::ScannerFor(const std::string& lang)
+{
+	if(lang == "c" || lang == "cpp")
+		return ScanCpp;
+	if(lang == "python")
+		return ScanPython;
+	if(lang == "yaml")
+		return ScanYaml;
+	if(lang == "makefile")
+		return ScanMakefile;
+	if(lang == "diff")
+		return ScanDiff;
+	return NULL;
+}
+
+
+/* static */ SymbolIndex::BodyScanner
+SymbolIndex::BodyScannerFor(const std::string& lang)
+{
+	if(lang == "diff")
+		return ScanDiffBody;
+	return NULL;
+}
+
+
+const SymbolIndex::Symbol*
+SymbolIndex::SymbolAt(int32 line) const
+{
+	auto next = std::upper_bound(fSymbols.begin(), fSymbols.end(), line,
+		[](int32 line, const Symbol& symbol) { return line < symbol.line; });
+	if(next == fSymbols.begin())
+		return NULL;
+	return &*(next - 1);
+}
+
+
+const SymbolIndex::Symbol*
+SymbolIndex::Next(int32 line, Kind kind, bool forward) const
+{
+	if(forward == true) {
+		auto next = std::upper_bound(fSymbols.begin(), fSymbols.end(), line,
+			[](int32 line, const Symbol& symbol) { return line < symbol.line; });
+		for(; next != fSymbols.end(); next++) {
+			if(next->kind == kind)
+				return &*next;
+		}
+	} else {
+		auto next = std::lower_bound(fSymbols.begin(), fSymbols.end(), line,
+			[](const Symbol& symbol, int32 line) { return symbol.line < line; });
+		while(next != fSymbols.begin()) {
+			if((--next)->kind == kind)
+				return &*next;
+		}
+	}
+	return NULL;
+}
+
+
+/* static */ void
+SymbolIndex::Find(const std::vector<Symbol>& symbols, const char* text,
+	std::vector<const Symbol*>& found, size_t limit)
+{
+	std::string lowered(text);
+	std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+	std::vector<const Symbol*> contained;
+	for(const auto& symbol : symbols) {
+		bool prefix;
+		if(ContainsIgnoringCase(symbol.name, lowered, prefix) == false)
+			continue;
+		if(prefix == true)
+			found.push_back(&symbol);
+		else
+			contained.push_back(&symbol);
+		if(found.size() >= limit)
+			return;
+	}
+	found.insert(found.end(), contained.begin(), contained.begin()
+		+ std::min(contained.size(), limit - found.size()));
+}
+
+
+/* static */ status_t
+SymbolIndex::_ScanThread(void* data)
+{
+	SymbolIndex* self = static_cast<SymbolIndex*>(data);
+	const char* text = self->fScanText.data();
+	const char* end = text + self->fScanText.size();
+	Symbol symbol;
+	for(int32 line = 0; text <= end && self->fCancelled == false; line++) {
+		const char* lineEnd = static_cast<const char*>(memchr(text, '\n', end - text));
+		if(lineEnd == NULL)
+			lineEnd = end;
+		const Symbol* previous = self->fScanned.empty() ? NULL
+			: &self->fScanned.back();
+		if(self->fScanner(text, lineEnd - text, previous, symbol) == true) {
+			symbol.line = line;
+			self->fScanned.push_back(symbol);
+		} else if(self->fBodyScanner != NULL && previous != NULL)
+			self->fBodyScanner(text, lineEnd - text, self->fScanned.back());
+		text = lineEnd + 1;
+	}
+	if(self->fCancelled == false) {
+		BMessage message(SYMBOLINDEX_SCANNED);
+		message.AddUInt32("generation", self->fGeneration);
+		self->fTarget.SendMessage(&message);
+	}
+	return B_OK;
+}
+
+
+void
+SymbolIndex::_StartScan()
+{
+	_StopScan();
+	fPendingEdits.clear();
+	if(fScanner == NULL) {
+		fSymbols.clear();
+		return;
+	}
+	const char* text = reinterpret_cast<const char*>(
+		fEditor->SendMessage(SCI_GETCHARACTERPOINTER, 0, 0));
+	fScanText.assign(text, fEditor->SendMessage(SCI_GETLENGTH, 0, 0));
+	fScanned.clear();
+	fTarget = BMessenger(fEditor);
+	fGeneration++;
+	fThread = spawn_thread(_ScanThread, "symbol index", B_LOW_PRIORITY, this);
+	if(fThread >= 0)
+		resume_thread(fThread);
+}
+
+
+void
+SymbolIndex::_StopScan()
+{
+	if(fThread < 0)
+		return;
+	fCancelled = true;
+	status_t exitValue;
+	wait_for_thread(fThread, &exitValue);
+	fThread = -1;
+	fCancelled = false;
+}
+
+
+// Drops symbols from lines joined with the first one and moves those after
+// them. The first line is left for _Rescan() to compare.
+bool
+SymbolIndex::_ApplyEdit(int32 first, int32 linesAdded)
+{
+	const int32 oldLast = first + std::max(0, -linesAdded);
+	auto begin = std::lower_bound(fSymbols.begin(), fSymbols.end(), first + 1,
+		[](const Symbol& symbol, int32 line) { return symbol.line < line; });
+	auto end = std::upper_bound(begin, fSymbols.end(), oldLast,
+		[](int32 line, const Symbol& symbol) { return line < symbol.line; });
+	const bool changed = begin != end
+		|| (linesAdded != 0 && end != fSymbols.end());
+	for(auto moved = end; linesAdded != 0 && moved != fSymbols.end(); moved++)
+		moved->line += linesAdded;
+	fSymbols.erase(begin, end);
+	return changed;
+}
+
+
+// With a body scanner the symbol owning the lines before first is scanned
+// again with them, and lines after last are until symbols are found as
+// they were.
+bool
+SymbolIndex::_Rescan(int32 first, int32 last)
+{
+	const int32 lineCount = fEditor->SendMessage(SCI_GETLINECOUNT, 0, 0);
+	last = std::min(last, lineCount - 1);
+	if(fBodyScanner != NULL) {
+		const Symbol* owner = SymbolAt(first - 1);
+		if(owner != NULL)
+			first = owner->line;
+	}
+	auto begin = std::lower_bound(fSymbols.begin(), fSymbols.end(), first,
+		[](const Symbol& symbol, int32 line) { return symbol.line < line; });
+	const Symbol* previous = begin != fSymbols.begin() ? &*(begin - 1) : NULL;
+
+	std::vector<Symbol> found;
+	Symbol symbol;
+	auto old = begin;
+	int32 line = first;
+	for(; line < lineCount && (line <= last || fBodyScanner != NULL); line++) {
+		const Sci_Position start = fEditor->SendMessage(SCI_POSITIONFROMLINE, line, 0);
+		const Sci_Position length = fEditor->SendMessage(SCI_GETLINEENDPOSITION,
+			line, 0) - start;
+		const char* text = reinterpret_cast<const char*>(
+			fEditor->SendMessage(SCI_GETRANGEPOINTER, start, length));
+		const bool isSymbol = fScanner(text, length,
+			found.empty() ? previous : &found.back(), symbol);
+		if(line > last) {
+			while(old != fSymbols.end() && old->line < line)
+				old++;
+			if(isSymbol == true && old != fSymbols.end() && old->line == line
+					&& old->kind == symbol.kind && old->name == symbol.name)
+				break;
+		}
+		if(isSymbol == true) {
+			symbol.line = line;
+			found.push_back(symbol);
+		} else if(fBodyScanner != NULL && found.empty() == false)
+			fBodyScanner(text, length, found.back());
+	}
+	auto end = std::lower_bound(begin, fSymbols.end(), line,
+		[](const Symbol& symbol, int32 line) { return symbol.line < line; });
+
+	bool changed = end - begin != static_cast<ptrdiff_t>(found.size());
+	for(size_t i = 0; changed == false && i < found.size(); i++) {
+		const Symbol& old = *(begin + i);
+		changed = old.line != found[i].line || old.name != found[i].name
+			|| old.kind != found[i].kind || old.indent != found[i].indent
+			|| old.added != found[i].added || old.removed != found[i].removed;
+	}
+	if(changed == true) {
+		begin = fSymbols.erase(begin, end);
+		fSymbols.insert(begin, found.begin(), found.end());
+	} else
+		std::copy(found.begin(), found.end(), begin);
+			// state of unfinished hunks may still differ
+	return changed;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+
+#include <Messenger.h>
+#include <OS.h>
+#include <SupportDefs.h>
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+class BMessage;
+class Editor;
+struct SCNotification;
+
+
+enum {
+	SYMBOLINDEX_SCANNED		= 'syis'
+};
+
+
+/*
+ * Functions, types and other named places in a document, at most one per
+ * line, found by a simple line scanner for each language. The whole text
+ * is scanned on a worker thread when the language is set, which sends
+ * SYMBOLINDEX_SCANNED to the editor to be passed to Finish(). After that
+ * edits only rescan lines they touched, and for languages which look at
+ * lines under a symbol, until symbols are found as they were.
+ */
+class SymbolIndex {
+public:
+	enum Kind {
+		FUNCTION,
+		TYPE,
+		KEY,
+		TARGET,
+		FILE,
+		HUNK
+	};
+	struct Symbol {
+						Symbol() : line(0), indent(0), kind(FUNCTION),
+							added(0), removed(0), pending(0) {}
+
+		int32			line;
+		int32			indent;
+			// in columns, for nesting
+		Kind			kind;
+		std::string		name;
+		int32			added;
+		int32			removed;
+			// lines of a diff hunk
+		int32			pending;
+			// lines the hunk header announced which did not follow yet
+	};
+	// previous is the last symbol before line, NULL if there is none.
+	typedef bool (*LineScanner)(const char* line, size_t length,
+		const Symbol* previous, Symbol& symbol);
+	// Called for lines after a symbol, up to the next one.
+	typedef void (*BodyScanner)(const char* line, size_t length,
+		Symbol& symbol);
+
+								SymbolIndex(Editor* editor);
+								~SymbolIndex();
+
+			void				SetLanguage(const std::string& lang);
+			bool				Finish(BMessage* message);
+			// Call for SCN_MODIFIED, returns true if symbols changed.
+			bool				Modified(const SCNotification* notification);
+
+			bool				IsEmpty() const { return fSymbols.empty(); }
+			const std::vector<Symbol>&	Symbols() const { return fSymbols; }
+			// Last symbol at or before line, NULL if there is none.
+			const Symbol*		SymbolAt(int32 line) const;
+			// First symbol of kind after line, or last before it, NULL if
+			// there is none.
+			const Symbol*		Next(int32 line, Kind kind, bool forward) const;
+
+	static	LineScanner			ScannerFor(const std::string& lang);
+	static	BodyScanner			BodyScannerFor(const std::string& lang);
+	// Symbols containing text, ignoring case, those starting with it first.
+	static	void				Find(const std::vector<Symbol>& symbols,
+									const char* text,
+									std::vector<const Symbol*>& found,
+									size_t limit);
+
+private:
+	static	status_t			_ScanThread(void* data);
+
+			void				_StartScan();
+			void				_StopScan();
+			bool				_ApplyEdit(int32 first, int32 linesAdded);
+			bool				_Rescan(int32 first, int32 last);
+
+			Editor*				fEditor;
+			LineScanner			fScanner;
+			BodyScanner			fBodyScanner;
+			std::vector<Symbol>	fSymbols;
+				// ordered by line
+
+			BMessenger			fTarget;
+			thread_id			fThread;
+			std::atomic<bool>	fCancelled;
+			uint32				fGeneration;
+			std::string			fScanText;
+			std::vector<Symbol>	fScanned;
+			std::vector<std::pair<int32, int32>>	fPendingEdits;
+				// first line and lines added by edits made during the scan
+};
+
+
+#endif // SYMBOLINDEX_H
@@ -0,0 +1,390 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "TagIndex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "Editor.h"
+
+
+namespace {
+
+const Sci_Position kMaxTagLength = 16 * 1024;
+	// '<' not closed within that is not a tag, comments can be longer
+const Sci_Position kFetchAhead = 1024;
+
+enum ParseResult {
+	PARSED,
+	NOT_A_TAG,
+	INCOMPLETE
+		// text ended before the tag did
+};
+
+struct Delimiters {
+	const char*	open;
+	const char*	close;
+};
+
+const Delimiters kSpecialTags[] = {
+	{ "<!--", "-->" },
+	{ "<![CDATA[", "]]>" },
+	{ "<?", "?>" },
+	{ "<!", ">" }
+};
+
+
+bool
+IsNameStart(char c)
+{
+	const unsigned char u = static_cast<unsigned char>(c);
+	return isalpha(u) || c == '_' || c == ':' || u >= 0x80;
+}
+
+
+bool
+IsNameChar(char c)
+{
+	return IsNameStart(c) || isdigit(static_cast<unsigned char>(c))
+		|| c == '-' || c == '.';
+}
+
+
+// Parses tag starting with '<' at text, its start and end are set relative
+// to it. Comments and the like left open take the rest of the document, as
+// they do when styled.
+ParseResult
+ParseTag(const char* text, size_t length, bool atEnd, TagIndex::Tag& tag)
+{
+	tag.start = 0;
+	for(const Delimiters& special : kSpecialTags) {
+		const size_t openLength = strlen(special.open);
+		if(strncmp(text, special.open, std::min(length, openLength)) != 0)
+			continue;
+		if(length < openLength) {
+			if(atEnd == false)
+				return INCOMPLETE;
+			continue;
+		}
+		const char* closeEnd = special.close + strlen(special.close);
+		const char* close = std::search(text + openLength, text + length,
+			special.close, closeEnd);
+		if(close == text + length && atEnd == false)
+			return INCOMPLETE;
+		tag.end = close == text + length ? length
+			: close - text + (closeEnd - special.close);
+		tag.kind = TagIndex::OTHER;
+		tag.name.clear();
+		return PARSED;
+	}
+
+	size_t pos = 1;
+	const bool closing = pos < length && text[pos] == '/';
+	if(closing == true)
+		pos++;
+	if(pos >= length)
+		return atEnd ? NOT_A_TAG : INCOMPLETE;
+	if(IsNameStart(text[pos]) == false)
+		return NOT_A_TAG;
+	const size_t nameStart = pos;
+	while(pos < length && IsNameChar(text[pos]))
+		pos++;
+	const size_t nameEnd = pos;
+	char quote = 0;
+	for(; pos < length && pos < static_cast<size_t>(kMaxTagLength); pos++) {
+		const char c = text[pos];
+		if(c == '<') {
+			// not allowed in attribute values either, so '<' not starting
+			// a tag never hides the following ones
+			return NOT_A_TAG;
+		} else if(quote != 0) {
+			if(c == quote)
+				quote = 0;
+		} else if(c == '"' || c == '\'') {
+			quote = c;
+		} else if(c == '>') {
+			tag.end = pos + 1;
+			if(closing == true)
+				tag.kind = TagIndex::CLOSE;
+			else
+				tag.kind = text[pos - 1] == '/' ? TagIndex::EMPTY : TagIndex::OPEN;
+			tag.name.assign(text + nameStart, nameEnd - nameStart);
+			return PARSED;
+		}
+	}
+	return pos < static_cast<size_t>(kMaxTagLength) && atEnd == false
+		? INCOMPLETE : NOT_A_TAG;
+}
+
+}
+
+
+TagIndex::TagIndex(Editor* editor)
+	:
+	fEditor(editor),
+	fEnabled(false),
+	fStepIndex(0),
+	fStepLength(0)
+{
+}
+
+
+void
+TagIndex::SetLanguage(const std::string& lang)
+{
+	const bool enabled = lang == "xml";
+	if(enabled == fEnabled)
+		return;
+	fEnabled = enabled;
+	fTags.clear();
+	fStepIndex = 0;
+	fStepLength = 0;
+	fElements.clear();
+	if(fEnabled == true)
+		_Rescan(0, fEditor->SendMessage(SCI_GETLENGTH, 0, 0), 0, 0);
+}
+
+
+void
+TagIndex::Modified(const SCNotification* notification)
+{
+	const bool inserted = (notification->modificationType & SC_MOD_INSERTTEXT) != 0;
+	if(fEnabled == false || (inserted == false
+			&& (notification->modificationType & SC_MOD_DELETETEXT) == 0))
+		return;
+
+	// Tags text was inserted into or removed from are replaced by what is
+	// found in the text they took.
+	const Sci_Position position = notification->position;
+	const Sci_Position delta = inserted ? notification->length : -notification->length;
+	// Tag ending with the document may be a comment left open, appending
+	// text changes it too.
+	const bool appended = inserted && position + delta
+		== fEditor->SendMessage(SCI_GETLENGTH, 0, 0);
+	const int32 first = _FirstEndingAfter(appended ? position - 1 : position);
+	const int32 last = _FirstStartingFrom(inserted ? position
+		: position + notification->length);
+	Sci_Position from = position;
+	Sci_Position to = inserted ? position + delta : position;
+	if(first < last) {
+		from = std::min(from, _Start(first));
+		to = std::max(to, _End(last - 1) + delta);
+	}
+	_Unpair(first, last);
+	_Shift(last, delta);
+	_Rescan(from, to, first, last);
+}
+
+
+TagIndex::Tag
+TagIndex::TagAt(int32 index) const
+{
+	Tag tag = fTags[index];
+	tag.start = _Start(index);
+	tag.end = _End(index);
+	return tag;
+}
+
+
+int32
+TagIndex::IndexAt(Sci_Position pos) const
+{
+	const int32 index = _FirstStartingFrom(pos + 1) - 1;
+	return index >= 0 && pos <= _End(index) ? index : -1;
+}
+
+
+int32
+TagIndex::MatchOf(int32 index)
+{
+	const Tag& tag = fTags[index];
+	if(tag.kind == EMPTY)
+		return index;
+	if(tag.kind == OTHER)
+		return -1;
+	NestingTree& element = fElements[tag.name];
+	const Sci_Position start = _Start(index);
+	const Sci_Position match = tag.kind == OPEN ? element.Closing(start)
+		: element.Opening(start);
+	return match >= 0 ? _FirstStartingFrom(match) : -1;
+}
+
+
+Sci_Position
+TagIndex::_Start(int32 index) const
+{
+	return fTags[index].start + (index >= fStepIndex ? fStepLength : 0);
+}
+
+
+Sci_Position
+TagIndex::_End(int32 index) const
+{
+	return fTags[index].end + (index >= fStepIndex ? fStepLength : 0);
+}
+
+
+int32
+TagIndex::_FirstStartingFrom(Sci_Position pos, int32 low) const
+{
+	int32 high = fTags.size();
+	while(low < high) {
+		const int32 middle = low + (high - low) / 2;
+		if(_Start(middle) < pos)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+
+int32
+TagIndex::_FirstEndingAfter(Sci_Position pos) const
+{
+	int32 low = 0, high = fTags.size();
+	while(low < high) {
+		const int32 middle = low + (high - low) / 2;
+		if(_End(middle) <= pos)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+
+void
+TagIndex::_MoveStep(int32 index)
+{
+	for(; fStepIndex < index; fStepIndex++) {
+		fTags[fStepIndex].start += fStepLength;
+		fTags[fStepIndex].end += fStepLength;
+	}
+	while(fStepIndex > index) {
+		fStepIndex--;
+		fTags[fStepIndex].start -= fStepLength;
+		fTags[fStepIndex].end -= fStepLength;
+	}
+	if(fStepIndex == static_cast<int32>(fTags.size()))
+		fStepLength = 0;
+}
+
+
+// Moves tags from index on by delta.
+void
+TagIndex::_Shift(int32 index, Sci_Position delta)
+{
+	if(index < static_cast<int32>(fTags.size())) {
+		const Sci_Position start = _Start(index);
+		for(auto& element : fElements)
+			element.second.Shift(start, delta);
+	}
+	_MoveStep(index);
+	if(index < static_cast<int32>(fTags.size()))
+		fStepLength += delta;
+}
+
+
+// Tags from first to last are taken by new ones. Those after them are
+// already moved by the edit, while the dropped ones may not be, so they are
+// unpaired before.
+void
+TagIndex::_Replace(int32 first, int32 last, const std::vector<Tag>& tags)
+{
+	std::map<std::string, NestingTree> found;
+	for(const Tag& tag : tags) {
+		if(tag.kind == OPEN || tag.kind == CLOSE)
+			found[tag.name].Append(tag.start, tag.kind == OPEN ? 1 : -1);
+	}
+	for(auto& element : found)
+		fElements[element.first].Insert(element.second);
+
+	_MoveStep(last);
+	const int32 count = tags.size();
+	const int32 kept = std::min(last - first, count);
+	std::copy(tags.begin(), tags.begin() + kept, fTags.begin() + first);
+	if(count < last - first)
+		fTags.erase(fTags.begin() + first + kept, fTags.begin() + last);
+	else
+		fTags.insert(fTags.begin() + last, tags.begin() + kept, tags.end());
+	fStepIndex = first + count;
+	if(fStepIndex == static_cast<int32>(fTags.size()))
+		fStepLength = 0;
+}
+
+
+// Takes tags from first to last out of their nesting trees.
+void
+TagIndex::_Unpair(int32 first, int32 last)
+{
+	for(int32 i = first; i < last; i++) {
+		const Tag& tag = fTags[i];
+		if(tag.kind != OPEN && tag.kind != CLOSE)
+			continue;
+		auto element = fElements.find(tag.name);
+		const Sci_Position start = _Start(i);
+		element->second.Remove(start, start + 1);
+		if(element->second.IsEmpty())
+			fElements.erase(element);
+	}
+}
+
+
+// Replaces tags from first to last with those starting between from and to.
+// '<' left unclosed before from may be completed by an edit, so text after
+// the previous tag is scanned too. A tag going past to, like a comment just
+// opened, takes the place of following ones it covers.
+void
+TagIndex::_Rescan(Sci_Position from, Sci_Position to, int32 first, int32 last)
+{
+	const Sci_Position length = fEditor->SendMessage(SCI_GETLENGTH, 0, 0);
+	const Sci_Position scanStart = std::max(first > 0 ? _End(first - 1) : 0,
+		from - kMaxTagLength);
+	Sci_Position fetched = 0;
+	const char* text = NULL;
+	auto fetch = [&](Sci_Position end) {
+		fetched = std::min(length, end);
+		text = reinterpret_cast<const char*>(fEditor->SendMessage(
+			SCI_GETRANGEPOINTER, scanStart, fetched - scanStart));
+	};
+	fetch(to + kFetchAhead);
+
+	std::vector<Tag> found;
+	Sci_Position pos = scanStart;
+	while(pos < to) {
+		const char* open = static_cast<const char*>(
+			memchr(text + (pos - scanStart), '<', to - pos));
+		if(open == NULL)
+			break;
+		pos = scanStart + (open - text);
+		Tag tag;
+		const ParseResult result = ParseTag(open, fetched - pos,
+			fetched == length, tag);
+		if(result == INCOMPLETE) {
+			fetch(fetched + (fetched - scanStart));
+			continue;
+		}
+		if(result == NOT_A_TAG) {
+			pos++;
+			continue;
+		}
+		tag.start = pos;
+		tag.end += pos;
+		const int32 covered = _FirstStartingFrom(tag.end, last);
+		if(covered > last) {
+			_Unpair(last, covered);
+			to = std::max(to, _End(covered - 1));
+			last = covered;
+			if(fetched < std::min(length, to))
+				fetch(to + kFetchAhead);
+		}
+		found.push_back(tag);
+		pos = tag.end;
+	}
+	_Replace(first, last, found);
+}
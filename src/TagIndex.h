@@ -0,0 +1,92 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#ifndef TAGINDEX_H
+#define TAGINDEX_H
+
+
+#include <SupportDefs.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Scintilla.h>
+
+#include "NestingTree.h"
+
+
+class Editor;
+
+
+/*
+ * Tags of an XML document, found once when the language is set and then
+ * kept current by rescanning only around edits. Open and close tags of
+ * each name are also kept in a nesting tree, so the other tag of an element
+ * is found without going through those between.
+ */
+class TagIndex {
+public:
+	enum Kind {
+		OPEN,
+		CLOSE,
+		EMPTY,
+			// <tag/>
+		OTHER
+			// comments, CDATA, declarations and processing instructions
+	};
+	struct Tag {
+		Sci_Position	start;
+		Sci_Position	end;
+			// past '>'
+		Kind			kind;
+		std::string		name;
+	};
+
+								TagIndex(Editor* editor);
+
+			void				SetLanguage(const std::string& lang);
+			bool				IsEnabled() const { return fEnabled; }
+			// Call for SCN_MODIFIED.
+			void				Modified(const SCNotification* notification);
+
+			int32				CountTags() const { return fTags.size(); }
+			Tag					TagAt(int32 index) const;
+			// Index of the tag containing pos or ending at it, -1 if none.
+			int32				IndexAt(Sci_Position pos) const;
+			// Index of the other tag of the element, the tag itself for
+			// empty ones and -1 if it has none. Elements of each name nest
+			// on their own, like brackets of one kind.
+			int32				MatchOf(int32 index);
+
+private:
+			Sci_Position		_Start(int32 index) const;
+			Sci_Position		_End(int32 index) const;
+			int32				_FirstStartingFrom(Sci_Position pos,
+									int32 low = 0) const;
+			int32				_FirstEndingAfter(Sci_Position pos) const;
+			void				_MoveStep(int32 index);
+			void				_Shift(int32 index, Sci_Position delta);
+			void				_Replace(int32 first, int32 last,
+									const std::vector<Tag>& tags);
+			void				_Unpair(int32 first, int32 last);
+			void				_Rescan(Sci_Position from, Sci_Position to,
+									int32 first, int32 last);
+
+			Editor*				fEditor;
+			bool				fEnabled;
+			std::vector<Tag>	fTags;
+				// ordered by position
+			int32				fStepIndex;
+			Sci_Position		fStepLength;
+				// tags from fStepIndex on are stored this much too far back,
+				// so an edit only moves the tags between it and the last one
+			std::map<std::string, NestingTree>
+								fElements;
+				// open and close tags by name
+};
+
+
+#endif // TAGINDEX_H
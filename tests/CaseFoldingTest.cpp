@@ -0,0 +1,76 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+/*
+ * Compares CaseFolding::Fold with simple case folding (statuses C and S) of
+ * CaseFolding.txt, code point by code point:
+ *
+ *	casefolding-test <CaseFolding.txt>
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "CaseFolding.h"
+
+
+int
+main(int argc, char* argv[])
+{
+	if(argc != 2) {
+		fprintf(stderr, "Usage: %s <CaseFolding.txt>\n", argv[0]);
+		return 1;
+	}
+	FILE* file = fopen(argv[1], "r");
+	if(file == NULL) {
+		fprintf(stderr, "Could not read %s\n", argv[1]);
+		return 1;
+	}
+
+	// code points not listed fold to themselves
+	std::vector<uint32> expected(CaseFolding::kInvalid);
+	for(uint32 codePoint = 0; codePoint < expected.size(); codePoint++)
+		expected[codePoint] = codePoint;
+	int32 mappings = 0;
+	char line[1024];
+	while(fgets(line, sizeof(line), file) != NULL) {
+		// <code>; <status>; <mapping>; # <name>
+		char* end;
+		const unsigned long codePoint = strtoul(line, &end, 16);
+		if(end == line || strncmp(end, "; ", 2) != 0)
+			continue;
+		const char status = end[2];
+		if(status != 'C' && status != 'S')
+			continue;
+		const unsigned long folded = strtoul(end + 4, &end, 16);
+		if(codePoint >= expected.size() || folded >= expected.size()) {
+			fprintf(stderr, "Malformed line: %s", line);
+			fclose(file);
+			return 1;
+		}
+		expected[codePoint] = folded;
+		mappings++;
+	}
+	fclose(file);
+	if(mappings == 0) {
+		fprintf(stderr, "No mappings in %s\n", argv[1]);
+		return 1;
+	}
+
+	int32 mismatches = 0;
+	for(uint32 codePoint = 0; codePoint < expected.size(); codePoint++) {
+		const uint32 folded = CaseFolding::Fold(codePoint);
+		if(folded == expected[codePoint])
+			continue;
+		fprintf(stderr, "U+%04X folds to U+%04X, expected U+%04X\n",
+			(unsigned) codePoint, (unsigned) folded,
+			(unsigned) expected[codePoint]);
+		mismatches++;
+	}
+	printf("%d mappings, %d mismatches\n", (int) mappings, (int) mismatches);
+	return mismatches == 0 ? 0 : 1;
+}
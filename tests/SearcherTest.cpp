@@ -0,0 +1,143 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+/*
+ * Checks plain text Find, FindLast and ReplaceAll of Searcher when case is
+ * ignored, on characters whose folding is not ASCII and on malformed UTF-8:
+ *
+ *	searcher-test
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Searcher.h"
+
+
+namespace {
+
+// UTF-8 of code points used below
+const char* kKelvin = "\xE2\x84\xAA";
+	// KELVIN SIGN, folds to k
+const char* kSigma = "\xCF\x83";
+const char* kFinalSigma = "\xCF\x82";
+const char* kCapitalSigma = "\xCE\xA3";
+const char* kSharpS = "\xC3\x9F";
+const char* kCapitalSharpS = "\xE1\xBA\x9E";
+const char* kDotlessI = "\xC4\xB1";
+const char* kEAcute = "\xC3\xA9";
+
+int32 sFailures = 0;
+
+
+void
+Check(bool condition, const char* what)
+{
+	if(condition == true)
+		return;
+	fprintf(stderr, "Failed: %s\n", what);
+	sFailures++;
+}
+
+
+// Range of the first match of pattern in text, or -1 if there is none.
+void
+Find(const std::string& pattern, const std::string& text, bool matchCase,
+	long& start, long& end, bool last = false)
+{
+	const Searcher searcher(pattern, "", matchCase, false);
+	Searcher::Match match;
+	const bool found = last
+		? searcher.FindLast(text.c_str(), text.size(), 0, text.size(), match)
+		: searcher.Find(text.c_str(), text.size(), 0, text.size(), match);
+	start = found ? match.start : -1;
+	end = found ? match.end : -1;
+}
+
+
+bool
+Finds(const std::string& pattern, const std::string& text, long start,
+	long end, bool matchCase = false)
+{
+	long foundStart, foundEnd;
+	Find(pattern, text, matchCase, foundStart, foundEnd);
+	return foundStart == start && foundEnd == end;
+}
+
+
+bool
+FindsLast(const std::string& pattern, const std::string& text, long start,
+	long end)
+{
+	long foundStart, foundEnd;
+	Find(pattern, text, false, foundStart, foundEnd, true);
+	return foundStart == start && foundEnd == end;
+}
+
+
+std::string
+ReplaceAll(const std::string& pattern, const std::string& replacement,
+	const std::string& text, size_t& count)
+{
+	const Searcher searcher(pattern, replacement, false, false);
+	std::string output;
+	Searcher::Match replaced;
+	count = searcher.ReplaceAll(text.c_str(), text.size(), 0, text.size(),
+		output, replaced);
+	if(count == 0)
+		return text;
+	return text.substr(0, replaced.start) + output + text.substr(replaced.end);
+}
+
+}
+
+
+int
+main()
+{
+	const std::string kelvin(kKelvin);
+	Check(Finds("k", "x" + kelvin + "y", 1, 4), "k finds Kelvin sign");
+	Check(Finds(kelvin, "xKy", 1, 2), "Kelvin sign finds K");
+	Check(Finds("K", "x" + kelvin, 1, 4), "K finds Kelvin sign");
+	Check(Finds("k", "x" + kelvin, -1, -1, true),
+		"k does not find Kelvin sign when matching case");
+	Check(FindsLast("k", "kK" + kelvin + "x", 2, 5), "FindLast of k ends at Kelvin sign");
+	Check(FindsLast(kelvin, "xkK", 2, 3), "FindLast of Kelvin sign finds K");
+
+	const std::string sigmas = std::string(kCapitalSigma) + kFinalSigma + kSigma;
+	Check(Finds(kSigma, "a" + sigmas, 1, 3), "sigma finds capital sigma");
+	Check(Finds(kFinalSigma, "a" + std::string(kSigma), 1, 3),
+		"final sigma finds sigma");
+	Check(Finds(kCapitalSigma, "a" + std::string(kFinalSigma), 1, 3),
+		"capital sigma finds final sigma");
+	Check(FindsLast(kFinalSigma, sigmas + "a", 4, 6), "FindLast of final sigma");
+	size_t count;
+	Check(ReplaceAll(kSigma, "s", sigmas + kelvin, count) == "sss" + kelvin
+		&& count == 3, "all sigmas replaced");
+	Check(ReplaceAll("K", "c", "k" + kelvin + "K" + kSigma, count)
+		== "ccc" + std::string(kSigma) && count == 3, "all k replaced");
+
+	// simple folding only
+	Check(Finds(kSharpS, "x" + std::string(kCapitalSharpS), 1, 4),
+		"sharp s finds capital sharp s");
+	Check(Finds("ss", kSharpS, -1, -1), "ss does not find sharp s");
+	Check(Finds("i", kDotlessI, -1, -1), "i does not find dotless i");
+	Check(Finds("I", kDotlessI, -1, -1), "I does not find dotless i");
+
+	// Malformed bytes only ever match themselves.
+	Check(Finds("\xFF", "a\xFF" "b", 1, 2), "invalid byte finds itself");
+	Check(Finds("b", "a\xFF" "b", 2, 3), "search continues after invalid byte");
+	Check(Finds("\xC3", std::string(kEAcute) + "x\xC3", 3, 4),
+		"truncated sequence finds only itself");
+	Check(Finds(kEAcute, "\xC3" "a" + std::string(kEAcute), 2, 4),
+		"character found after truncated sequence");
+	Check(FindsLast("\xFF", "\xFF" "a\xFF", 2, 3), "FindLast of invalid byte");
+	Check(ReplaceAll("\xFF", "?", "a\xFF" "b\xFF", count) == "a?b?" && count == 2,
+		"invalid bytes replaced");
+
+	printf("%d failures\n", (int) sFailures);
+	return sFailures == 0 ? 0 : 1;
+}
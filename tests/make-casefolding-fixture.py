@@ -0,0 +1,36 @@
+#!/usr/bin/env python3
+#
+# Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+# All rights reserved. Distributed under the terms of the MIT license.
+#
+# Writes simple case foldings (statuses C and S) in the format of
+# CaseFolding.txt, from the Unicode database Python was built with:
+#
+#	make-casefolding-fixture.py > data/CaseFolding.txt
+#
+# Full folding of a code point equals the simple one when it is a single
+# code point (status C). Code points folding to several ones (status F) may
+# also have a simple folding (status S), which is then their lowercase.
+# Turkic foldings (status T) are not produced by str.casefold().
+
+import sys
+import unicodedata
+
+print("# Simple case folding of Unicode %s, statuses C and S."
+	% unicodedata.unidata_version)
+print("# Generated by make-casefolding-fixture.py.")
+for codePoint in range(0x110000):
+	if 0xD800 <= codePoint < 0xE000:
+		continue
+	char = chr(codePoint)
+	folded = char.casefold()
+	if len(folded) == 1 and folded != char:
+		status = "C"
+	elif len(folded) > 1 and codePoint != 0x130 and len(char.lower()) == 1 \
+			and char.lower() != char:
+		status = "S"
+		folded = char.lower()
+	else:
+		continue
+	print("%04X; %s; %04X; # %s" % (codePoint, status, ord(folded),
+		unicodedata.name(char, "")))
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2017 Kacper Kasper <kacperkasper@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+/*
+ * Compiles a Koder data directory into data.bundle:
+ *
+ *	koder-datac <data directory> <output file>
+ */
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <yaml.h>
+
+#include "DataBundle.h"
+#include "DataTables.h"
+
+
+namespace {
+
+// Returns names of entries in directory that are YAML files (without
+// extension) or, if directories is true, subdirectories.
+std::vector<std::string>
+ListDirectory(const std::string& path, bool directories)
+{
+	std::vector<std::string> names;
+	DIR* dir = opendir(path.c_str());
+	if(dir == NULL)
+		return names;
+	while(dirent* entry = readdir(dir)) {
+		const std::string name = entry->d_name;
+		if(name[0] == '.')
+			continue;
+		struct stat st;
+		if(stat((path + "/" + name).c_str(), &st) != 0)
+			continue;
+		if(directories == true) {
+			if(S_ISDIR(st.st_mode))
+				names.push_back(name);
+		} else if(S_ISREG(st.st_mode) && name.size() > 5
+				&& name.compare(name.size() - 5, 5, ".yaml") == 0) {
+			names.push_back(name.substr(0, name.size() - 5));
+		}
+	}
+	closedir(dir);
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+}
+
+
+int
+main(int argc, char* argv[])
+{
+	if(argc != 3) {
+		fprintf(stderr, "Usage: %s <data directory> <output file>\n", argv[0]);
+		return 1;
+	}
+	const std::string data = argv[1];
+	DataBundleWriter writer;
+	std::string current;
+	try {
+		current = data + "/languages.yaml";
+		writer.AddLanguageList(LanguageListTable::FromYAML(YAML::LoadFile(current)));
+		for(const auto& lang : ListDirectory(data + "/languages", false)) {
+			current = data + "/languages/" + lang + ".yaml";
+			writer.AddLanguage("languages/" + lang,
+				LanguageTable::FromYAML(YAML::LoadFile(current)));
+		}
+		for(const auto& style : ListDirectory(data + "/styles", false)) {
+			current = data + "/styles/" + style + ".yaml";
+			writer.AddGlobalStyle("styles/" + style,
+				GlobalStyleTable::FromYAML(YAML::LoadFile(current)));
+		}
+		for(const auto& style : ListDirectory(data + "/styles", true)) {
+			const std::string folder = data + "/styles/" + style;
+			for(const auto& lang : ListDirectory(folder, false)) {
+				current = folder + "/" + lang + ".yaml";
+				writer.AddLanguageStyle("styles/" + style + "/" + lang,
+					LanguageStyleTable::FromYAML(YAML::LoadFile(current)));
+			}
+		}
+	} catch(YAML::Exception& e) {
+		fprintf(stderr, "%s: %s\n", current.c_str(), e.what());
+		return 1;
+	}
+	if(!writer.Write(argv[2])) {
+		fprintf(stderr, "Could not write %s\n", argv[2]);
+		return 1;
+	}
+	return 0;
+}